@@ -1,12 +1,47 @@
 import json
+import queue
+import re
 import sys
+import threading
+import time
 from datetime import datetime, timedelta
 from pathlib import Path
-from typing import Dict, Any
+from typing import Dict, Any, Optional, Tuple
 import os
 from extract_weather import extract_weather
 from extract_prayer_times import extract_prayer_times
+from extract_prayer_times_vaktija import extract_prayer_times_vaktija
 PRAYER_TIMES_AVAILABLE = True
+try:
+    import paho.mqtt.publish as mqtt_publish
+except ImportError:
+    mqtt_publish = None
+
+PRAYER_NAMES = ['fajr', 'shuruq', 'dhuhr', 'asr', 'maghrib', 'isha']
+# Both sources are queried at once; the first valid answer is used
+PRAYER_SOURCES = {
+    'mawaqit': lambda: extract_prayer_times(),
+    'vaktija': lambda: extract_prayer_times_vaktija(
+        os.environ.get('VAKTIJA_URL', 'https://vaktija.eu/de/stuttgart')),
+}
+# Overall budget for prayer times. The sources' 10 s HTTP timeouts only
+# bound each socket read, so this is what ends the wait on a source that
+# trickles its answer.
+PRAYER_SOURCES_TIMEOUT = 15
+# Once one source is valid, wait at most this long for the cross-check
+PRAYER_CROSS_CHECK_GRACE = 3
+# Sources disagreeing by more than this are reported
+PRAYER_CROSS_CHECK_TOLERANCE_MIN = 5
+
+# The display parses and draws each top-level key as soon as it has arrived,
+# so the keys its left column needs go first; anything else follows
+PAYLOAD_KEY_ORDER = ['location', 'prayer_times', 'weather']
+
+# Optional MQTT transport: with MQTT_HOST set, the compact payload (only the
+# keys above) is also published retained to <MQTT_TOPIC>/payload, and its
+# version to <MQTT_TOPIC>/version. The display reads the version first and
+# skips the payload when it already shows it.
+MQTT_TOPIC_PREFIX = 'eink'
 
 # Load environment variables from .env file if it exists
 env_path = Path(__file__).parent / '.env'
@@ -19,6 +54,102 @@ if env_path.exists():
                 os.environ[key] = value
 
 
+def validate_prayer_times(times: Optional[Dict[str, str]]) -> Optional[str]:
+    """
+    Check that all six times are present, well-formed and in order.
+
+    Returns:
+        None if valid, otherwise the reason
+    """
+    if not times:
+        return 'no data'
+    minutes = []
+    for name in PRAYER_NAMES:
+        value = times.get(name)
+        if not isinstance(value, str) or not re.fullmatch(r'\d{2}:\d{2}', value):
+            return f'bad {name}: {value!r}'
+        hours, mins = int(value[:2]), int(value[3:])
+        if hours > 23 or mins > 59:
+            return f'bad {name}: {value!r}'
+        minutes.append(hours * 60 + mins)
+    if any(b <= a for a, b in zip(minutes, minutes[1:])):
+        return 'times not in order'
+    return None
+
+
+def _minutes(value: str) -> int:
+    return int(value[:2]) * 60 + int(value[3:])
+
+
+def _run_source(name: str, fetch, results: queue.Queue) -> None:
+    """Run one source and report (name, times, seconds, exception)."""
+    start = time.monotonic()
+    try:
+        results.put((name, fetch(), time.monotonic() - start, None))
+    except Exception as e:
+        results.put((name, None, time.monotonic() - start, e))
+
+
+def fetch_prayer_times() -> Tuple[Optional[Dict[str, str]], Dict[str, Any]]:
+    """
+    Query all prayer time sources concurrently.
+
+    The first valid result wins; the others are cross-checked against it if
+    they finish within PRAYER_CROSS_CHECK_GRACE seconds.
+
+    Returns:
+        (prayer times or None, per-source stats)
+    """
+    stats = {name: {'ok': False, 'latency_ms': None, 'error': 'timeout'}
+             for name in PRAYER_SOURCES}
+    results = {}
+    chosen = None
+
+    # Daemon threads: a source still running at the deadline is abandoned
+    # and can't keep the process from exiting (executor workers would be
+    # joined at exit)
+    answers: queue.Queue = queue.Queue()
+    for name, fetch in PRAYER_SOURCES.items():
+        threading.Thread(target=_run_source, args=(name, fetch, answers),
+                         name=f'prayer-{name}', daemon=True).start()
+    deadline = time.monotonic() + PRAYER_SOURCES_TIMEOUT
+    for _ in PRAYER_SOURCES:
+        remaining = deadline - time.monotonic()
+        if remaining <= 0:
+            break
+        try:
+            name, times, seconds, exc = answers.get(timeout=remaining)
+        except queue.Empty:
+            break
+        stats[name]['latency_ms'] = round(seconds * 1000)
+        if exc is not None:
+            stats[name]['error'] = str(exc)
+            continue
+        times = {k: v for k, v in (times or {}).items() if k in PRAYER_NAMES}
+        error = validate_prayer_times(times)
+        stats[name]['ok'] = error is None
+        stats[name]['error'] = error
+        if error is None:
+            results[name] = times
+            if chosen is None:
+                chosen = name
+                deadline = min(deadline,
+                               time.monotonic() + PRAYER_CROSS_CHECK_GRACE)
+
+    if chosen is None:
+        return None, stats
+    stats[chosen]['used'] = True
+    for name, times in results.items():
+        if name == chosen:
+            continue
+        diff = max(abs(_minutes(times[p]) - _minutes(results[chosen][p]))
+                   for p in PRAYER_NAMES)
+        stats[name]['max_diff_min'] = diff
+        if diff > PRAYER_CROSS_CHECK_TOLERANCE_MIN:
+            print(f"⚠ {name} differs from {chosen} by up to {diff} min")
+    return results[chosen], stats
+
+
 def aggregate_data(location: str = None) -> Dict[str, Any]:
     """
     Aggregate all data sources into a single JSON structure.
@@ -49,7 +180,13 @@ def aggregate_data(location: str = None) -> Dict[str, Any]:
     # Extract prayer times (if available)
     if PRAYER_TIMES_AVAILABLE:
         print("Extracting prayer times...")
-        prayer_times = extract_prayer_times()
+        prayer_times, source_stats = fetch_prayer_times()
+        # Diagnostics for the job log only; every panel downloads the output
+        for name, st in source_stats.items():
+            mark = "✓" if st['ok'] else "✗"
+            latency = f"{st['latency_ms']} ms" if st['latency_ms'] is not None else "-"
+            detail = st['error'] or ('used' if st.get('used') else 'cross-check')
+            print(f"  {mark} {name:8} {latency:>8}  {detail}")
         if prayer_times:
             aggregated_data['prayer_times'] = prayer_times
             print("✓ Prayer times extracted successfully")
@@ -72,6 +209,69 @@ def aggregate_data(location: str = None) -> Dict[str, Any]:
     return aggregated_data
 
 
+def order_for_streaming(data: Dict[str, Any]) -> Dict[str, Any]:
+    """Reorders the top-level keys as in PAYLOAD_KEY_ORDER."""
+    ordered = {key: data[key] for key in PAYLOAD_KEY_ORDER if key in data}
+    ordered.update((key, value) for key, value in data.items()
+                   if key not in ordered)
+    return ordered
+
+
+def compact_payload(data: Dict[str, Any]) -> bytes:
+    """The keys the display reads, in streaming order, without whitespace."""
+    compact = {key: data[key] for key in PAYLOAD_KEY_ORDER if key in data}
+    return json.dumps(compact, separators=(',', ':'),
+                      ensure_ascii=False).encode('utf-8')
+
+
+def payload_version(payload: bytes) -> str:
+    """FNV-1a of the payload as 8 hex digits, as the display's traceHash()."""
+    h = 2166136261
+    for byte in payload:
+        h = ((h ^ byte) * 16777619) & 0xFFFFFFFF
+    return f'{h:08x}'
+
+
+def mqtt_topic(location: str) -> str:
+    """MQTT_TOPIC, or eink/<location> with the location lowercased, e.g.
+    eink/my-city."""
+    slug = re.sub(r'[^a-z0-9]+', '-', location.lower()).strip('-')
+    return os.environ.get('MQTT_TOPIC', f'{MQTT_TOPIC_PREFIX}/{slug}')
+
+
+def publish_to_mqtt(data: Dict[str, Any]) -> bool:
+    """
+    Publish the compact payload and its version as retained messages.
+
+    Returns:
+        True if successful, False otherwise
+    """
+    if mqtt_publish is None:
+        print("✗ MQTT_HOST is set but paho-mqtt is not installed")
+        return False
+    payload = compact_payload(data)
+    version = payload_version(payload)
+    topic = mqtt_topic(data['location'])
+    auth = None
+    if os.environ.get('MQTT_USER'):
+        auth = {'username': os.environ['MQTT_USER'],
+                'password': os.environ.get('MQTT_PASSWORD')}
+    try:
+        # Payload before version, so a version always has its payload
+        mqtt_publish.multiple(
+            [{'topic': f'{topic}/payload', 'payload': payload, 'qos': 1,
+              'retain': True},
+             {'topic': f'{topic}/version', 'payload': version, 'qos': 1,
+              'retain': True}],
+            hostname=os.environ['MQTT_HOST'],
+            port=int(os.environ.get('MQTT_PORT', 1883)), auth=auth)
+    except Exception as e:
+        print(f"✗ Error publishing to MQTT: {e}")
+        return False
+    print(f"✓ Published {len(payload)} bytes to {topic} (version {version})")
+    return True
+
+
 def save_to_file(data: Dict[str, Any], output_path = None) -> bool:
     """
     Save aggregated data to JSON file.
@@ -90,7 +290,8 @@ def save_to_file(data: Dict[str, Any], output_path = None) -> bool:
         print(f"[DEBUG] Directory ensured: {output_file.parent.resolve()}")
         # Write JSON file with pretty formatting
         with open(output_file, 'w', encoding='utf-8') as f:
-            json.dump(data, f, indent=2, ensure_ascii=False)
+            json.dump(order_for_streaming(data), f, indent=2,
+                      ensure_ascii=False)
         print(f"\n✓ Data saved to {output_file}")
         print(f"[DEBUG] File write complete: {output_file.resolve()}")
         return True
@@ -112,6 +313,8 @@ def main():
     # Save to file
     if not save_to_file(data):
         sys.exit(1)
+    if os.environ.get('MQTT_HOST') and not publish_to_mqtt(data):
+        sys.exit(1)
     
     # Print summary
     print("\n" + "=" * 50)
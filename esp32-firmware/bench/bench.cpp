@@ -0,0 +1,89 @@
+#include "bench.h"
+
+#include "cycles.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#define BENCH_TARGET "esp32s3"
+#define BENCH_UNIT "cycles"
+#else
+#define BENCH_TARGET "host"
+#define BENCH_UNIT "ns"
+#endif
+
+#if defined(ARDUINO) && defined(RENDER_IRAM)
+#define BENCH_BUILD "iram"
+#else
+#define BENCH_BUILD "flash"
+#endif
+
+volatile uint32_t benchSink;
+
+static BenchCase *head = nullptr;
+static BenchCase *tail = nullptr;
+
+BenchRegistrar::BenchRegistrar(BenchCase *c) {
+  if (tail) {
+    tail->next = c;
+  } else {
+    head = c;
+  }
+  tail = c;
+}
+
+static void benchPrint(const char *line) {
+#ifdef ARDUINO
+  Serial.println(line);
+#else
+  puts(line);
+#endif
+}
+
+static void sortSamples(uint32_t *s, int n) {
+  for (int i = 1; i < n; i++) {
+    uint32_t v = s[i];
+    int j = i - 1;
+    while (j >= 0 && s[j] > v) {
+      s[j + 1] = s[j];
+      j--;
+    }
+    s[j + 1] = v;
+  }
+}
+
+void benchRunAll(const char *filter, const char *cond,
+                 void (*beforeSample)()) {
+  for (BenchCase *c = head; c; c = c->next) {
+    if (filter && *filter && !strstr(c->name, filter)) {
+      continue;
+    }
+    for (int i = 0; i < BENCH_WARMUP && !beforeSample; i++) {
+      c->run();
+    }
+    uint32_t samples[BENCH_REPS];
+    uint64_t total = 0;
+    for (int i = 0; i < BENCH_REPS; i++) {
+      if (beforeSample) {
+        beforeSample();
+      }
+      uint32_t t0 = cycleCount();
+      c->run();
+      samples[i] = cycleCount() - t0;
+      total += samples[i];
+    }
+    sortSamples(samples, BENCH_REPS);
+
+    uint32_t median = samples[BENCH_REPS / 2];
+    char line[224];
+    snprintf(line, sizeof(line),
+             "BENCH name=%s target=" BENCH_TARGET " build=" BENCH_BUILD
+             " cond=%s unit=" BENCH_UNIT
+             " ops=%u reps=%d min=%u median=%u mean=%u per_op=%.1f",
+             c->name, cond, (unsigned)c->ops, BENCH_REPS, (unsigned)samples[0],
+             (unsigned)median, (unsigned)(total / BENCH_REPS),
+             (double)median / c->ops);
+    benchPrint(line);
+  }
+}
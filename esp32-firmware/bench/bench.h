@@ -0,0 +1,52 @@
+/*
+ * Microbenchmark harness shared by the ESP32 and the host
+ *
+ * Register a case with BENCH(name, ops) { ...body... }; the body runs once
+ * per sample and should perform `ops` operations. Each case gets a few
+ * warmup runs and then BENCH_REPS timed samples, measured with
+ * cycleCount() (CPU cycles on the ESP32, nanoseconds on the host). Results
+ * are printed one per line:
+ *
+ *   BENCH name=fill_span target=esp32s3 build=flash cond=idle unit=cycles
+ *         ops=1000 reps=15 min=... median=... mean=... per_op=...
+ *
+ * build is iram when the kernels are placed in IRAM (-DRENDER_IRAM); cond
+ * labels the system state a run was taken under (see bench_main.cpp).
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+
+#define BENCH_WARMUP 3
+#define BENCH_REPS 15
+
+struct BenchCase {
+  const char *name;
+  uint32_t ops;
+  void (*run)();
+  BenchCase *next;
+};
+
+// Appends to the registry in definition order
+struct BenchRegistrar {
+  explicit BenchRegistrar(BenchCase *c);
+};
+
+#define BENCH(name, ops)                                                       \
+  static void bench_##name();                                                  \
+  static BenchCase benchCase_##name = {#name, ops, bench_##name, nullptr};     \
+  static BenchRegistrar benchRegistrar_##name(&benchCase_##name);              \
+  static void bench_##name()
+
+// Keeps results alive so the compiler can't drop the work
+extern volatile uint32_t benchSink;
+
+// Runs every case whose name contains filter (all if null or empty).
+// beforeSample, if set, runs untimed before every sample and replaces the
+// warmup, so each sample starts from whatever state it leaves behind.
+void benchRunAll(const char *filter, const char *cond = "idle",
+                 void (*beforeSample)() = nullptr);
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ * Benchmark entry point: `pio run -e bench -t upload -t monitor` on the
+ * device, or the host build in bench/README.md. An optional argument (or a
+ * line sent over serial within two seconds of boot) filters cases by name.
+ *
+ * With -DBENCH_NETWORK on the device (--net on the host) every case runs
+ * three times: idle, during a background fetch loop, and right after a
+ * fetch (see net_load.h).
+ */
+
+#include "bench.h"
+#include "net_load.h"
+
+static void runConditions(const char *filter, bool network) {
+  benchRunAll(filter, "idle");
+  if (!network) {
+    return;
+  }
+  netLoadStart();
+  benchRunAll(filter, "during");
+  netLoadStop();
+  benchRunAll(filter, "after", netLoadOnce);
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+
+void setup() {
+  Serial.begin(115200);
+  delay(2000);
+  String filter = Serial.available() ? Serial.readStringUntil('\n') : "";
+  filter.trim();
+  Serial.printf("CPU %u MHz\n", getCpuFrequencyMhz());
+#ifdef BENCH_NETWORK
+  bool network = netLoadBegin();
+  if (!network) {
+    Serial.println("WiFi failed, idle only");
+  }
+#else
+  bool network = false;
+#endif
+  runConditions(filter.c_str(), network);
+  Serial.println("BENCH END");
+}
+
+void loop() {}
+#else
+#include <string.h>
+
+int main(int argc, char *argv[]) {
+  const char *filter = nullptr;
+  bool network = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--net") == 0) {
+      network = netLoadBegin();
+    } else {
+      filter = argv[i];
+    }
+  }
+  runConditions(filter, network);
+  return 0;
+}
+#endif
@@ -0,0 +1,98 @@
+#include "net_load.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+
+#include "secrets.h" // WIFI_SSID and WIFI_PASSWORD, as for the firmware
+
+#ifndef NET_LOAD_URL
+#define NET_LOAD_URL                                                           \
+  "https://raw.githubusercontent.com/Amkobano/e-ink-display-module/main/"      \
+  "data-collection/output/display_data.json"
+#endif
+#define NET_LOAD_CORE 0 // the benchmarks run on core 1 (loopTask)
+
+static volatile bool running = false;
+static TaskHandle_t task = nullptr;
+
+bool netLoadBegin() {
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  unsigned long start = millis();
+  while (WiFi.status() != WL_CONNECTED && millis() - start < 15000) {
+    delay(100);
+  }
+  return WiFi.status() == WL_CONNECTED;
+}
+
+void netLoadOnce() {
+  WiFiClientSecure client;
+  client.setInsecure();
+  HTTPClient http;
+  http.setTimeout(15000);
+  http.begin(client, NET_LOAD_URL);
+  if (http.GET() == HTTP_CODE_OK) {
+    http.getString();
+  }
+  http.end();
+}
+
+static void loadTask(void *) {
+  while (running) {
+    netLoadOnce();
+  }
+  task = nullptr;
+  vTaskDelete(nullptr);
+}
+
+void netLoadStart() {
+  running = true;
+  xTaskCreatePinnedToCore(loadTask, "net_load", 8192, nullptr, 1, &task,
+                          NET_LOAD_CORE);
+}
+
+void netLoadStop() {
+  running = false;
+  while (task) {
+    delay(10); // let the fetch in flight finish
+  }
+}
+#else
+#include <atomic>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+#define NET_LOAD_SWEEP_BYTES (64u << 20)
+
+static std::atomic<bool> running(false);
+static std::thread worker;
+
+bool netLoadBegin() { return true; }
+
+void netLoadOnce() {
+  static std::vector<uint8_t> sweep(NET_LOAD_SWEEP_BYTES);
+  for (size_t i = 0; i < sweep.size(); i += 64) {
+    sweep[i]++;
+  }
+}
+
+void netLoadStart() {
+  running = true;
+  worker = std::thread([] {
+    while (running) {
+      netLoadOnce();
+    }
+  });
+}
+
+void netLoadStop() {
+  running = false;
+  if (worker.joinable()) {
+    worker.join();
+  }
+}
+#endif
@@ -0,0 +1,23 @@
+/*
+ * Network load for the benchmarks: runs the firmware's HTTPS fetch so the
+ * render kernels can be timed while WiFi/TLS code competes for the
+ * instruction cache, or right after it has evicted them.
+ *
+ * On the host there is no radio; a sweep over a buffer larger than the
+ * last-level cache stands in for it, so the same conditions run there.
+ */
+
+#ifndef NET_LOAD_H
+#define NET_LOAD_H
+
+// Connects (device only); false if there is no network to load
+bool netLoadBegin();
+
+// One fetch, start to finish
+void netLoadOnce();
+
+// Fetches back to back in the background until netLoadStop()
+void netLoadStart();
+void netLoadStop();
+
+#endif
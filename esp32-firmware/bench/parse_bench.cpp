@@ -0,0 +1,67 @@
+// Payload parsing: display_data.json into the render model
+
+#include "bench.h"
+
+#include "render_model.h"
+#include <string.h>
+
+#if defined(ARDUINO) || __has_include(<ArduinoJson.h>)
+#include <ArduinoJson.h>
+
+// A full payload as published by the aggregator
+static const char PAYLOAD[] =
+    "{\"timestamp\":\"2026-03-01T00:53:50.745012\",\"location\":\"My City\","
+    "\"next_update\":\"2026-03-02T06:00:00\",\"prayer_times\":{"
+    "\"fajr\":\"06:28\",\"shuruq\":\"06:58\",\"dhuhr\":\"12:41\","
+    "\"asr\":\"15:36\",\"maghrib\":\"18:13\",\"isha\":\"19:39\"},"
+    "\"weather\":{\"current\":{\"temperature\":14,\"condition\":"
+    "\"light rain\",\"wind_speed\":4.1,\"icon\":\"10d\"},\"forecast\":["
+    "{\"date\":\"Mon\",\"high\":15,\"low\":5,\"condition\":\"Sunny\"},"
+    "{\"date\":\"Tue\",\"high\":16,\"low\":6,\"condition\":\"Clouds\"},"
+    "{\"date\":\"Wed\",\"high\":17,\"low\":7,\"condition\":\"Rain\"}]},"
+    "\"status\":\"success\"}";
+
+BENCH(json_parse, 1) {
+  JsonDocument doc;
+  benchSink = deserializeJson(doc, PAYLOAD, sizeof(PAYLOAD) - 1).code();
+}
+
+// Parse plus the copy into the model, as fetchPrayerTimes() and
+// buildRenderModel() do
+BENCH(json_to_model, 1) {
+  JsonDocument doc;
+  deserializeJson(doc, PAYLOAD, sizeof(PAYLOAD) - 1);
+  RenderModel model;
+  memset(&model, 0, sizeof(model));
+  const char *names[] = {"fajr", "shuruq", "dhuhr", "asr", "maghrib", "isha"};
+  JsonObject times = doc["prayer_times"];
+  for (int i = 0; i < 6; i++) {
+    modelSetString(model.prayers[i], sizeof(model.prayers[i]),
+                   times[names[i]] | "N/A");
+  }
+  JsonObject current = doc["weather"]["current"];
+  model.temperature = current["temperature"] | 0;
+  modelSetString(model.condition, sizeof(model.condition),
+                 current["condition"] | "N/A");
+  modelSetString(model.icon, sizeof(model.icon), current["icon"] | "");
+  JsonArray days = doc["weather"]["forecast"];
+  for (int i = 0; i < 3 && i < (int)days.size(); i++) {
+    modelSetString(model.forecast[i].date, sizeof(model.forecast[i].date),
+                   days[i]["date"] | "");
+    model.forecast[i].high = days[i]["high"] | 0;
+    model.forecast[i].low = days[i]["low"] | 0;
+    modelSetString(model.forecast[i].condition,
+                   sizeof(model.forecast[i].condition),
+                   days[i]["condition"] | "");
+  }
+  benchSink = model.forecast[2].high;
+}
+#endif
+
+// Comparing a new model with the stored one decides what to redraw
+BENCH(model_diff, 1) {
+  static RenderModel a;
+  static RenderModel b;
+  b.temperature++;
+  benchSink = changedWidgets(a, b);
+}
@@ -0,0 +1,198 @@
+// Render, hash and codec kernels on a full-size frame
+
+#include "bench.h"
+
+#include "font.h"
+#include "frame_codec.h"
+#include "framebuffer.h"
+#include "layout.h"
+#include "render_model.h"
+#include "vector_icon.h"
+#include "weather_icons.h"
+#include <stdlib.h>
+#include <string.h>
+#include <u8g2_fonts.h>
+
+#define BENCH_WIDTH 800
+#define BENCH_HEIGHT 480
+
+static uint8_t frameData[BENCH_WIDTH / 2 * BENCH_HEIGHT];
+static FrameBuffer fb(frameData, BENCH_WIDTH, BENCH_HEIGHT);
+
+static const RenderModel &sampleModel() {
+  static RenderModel model;
+  static bool ready = false;
+  if (!ready) {
+    memset(&model, 0, sizeof(model));
+    modelSetString(model.location, sizeof(model.location), "My City");
+    const char *times[] = {"06:28", "06:58", "12:41",
+                           "15:36", "18:13", "19:39"};
+    for (int i = 0; i < 6; i++) {
+      modelSetString(model.prayers[i], sizeof(model.prayers[i]), times[i]);
+    }
+    model.highlight = 2;
+    model.temperature = 14;
+    modelSetString(model.condition, sizeof(model.condition), "light rain");
+    modelSetString(model.icon, sizeof(model.icon), "10d");
+    const char *days[] = {"Mon", "Tue", "Wed"};
+    const char *conditions[] = {"Sunny", "Clouds", "Rain"};
+    for (int i = 0; i < 3; i++) {
+      modelSetString(model.forecast[i].date, sizeof(model.forecast[i].date),
+                     days[i]);
+      model.forecast[i].high = 15 + i;
+      model.forecast[i].low = 5 + i;
+      modelSetString(model.forecast[i].condition,
+                     sizeof(model.forecast[i].condition), conditions[i]);
+    }
+    ready = true;
+  }
+  return model;
+}
+
+struct Encoded {
+  uint8_t *data;
+  size_t size;
+  size_t capacity;
+};
+
+static bool encodedSink(void *ctx, const uint8_t *data, size_t len) {
+  Encoded *e = static_cast<Encoded *>(ctx);
+  if (e->size + len > e->capacity) {
+    return false;
+  }
+  memcpy(e->data + e->size, data, len);
+  e->size += len;
+  return true;
+}
+
+// The full screen, RLE-compressed, as stored in LittleFS
+static const Encoded &encodedFrame() {
+  static Encoded encoded = {nullptr, 0, 0};
+  if (!encoded.data) {
+    renderWidgets(fb, sampleModel(), WIDGET_ALL);
+    encoded.capacity = fb.size() / 4;
+    encoded.data = (uint8_t *)malloc(encoded.capacity);
+    if (!encoded.data || rleEncode(fb.data(), fb.size(), encodedSink,
+                                   &encoded) == 0) {
+      encoded.size = 0;
+    }
+  }
+  return encoded;
+}
+
+BENCH(fill, 1) { fb.fill(INK_WHITE); }
+
+BENCH(fill_rect, 1) { fb.fillRect(100, 100, 300, 200, INK_RED); }
+
+BENCH(fill_rect_dithered, 1) {
+  fb.fillRectDithered(100, 100, 300, 200, INK_BLUE);
+}
+
+BENCH(fill_span_short, 1000) {
+  for (int i = 0; i < 1000; i++) {
+    fb.fillSpan(i % 700 + (i & 1), i % BENCH_HEIGHT, 7, INK_BLACK);
+  }
+}
+
+BENCH(fill_span_long, BENCH_HEIGHT) {
+  for (int y = 0; y < BENCH_HEIGHT; y++) {
+    fb.fillSpan(1, y, BENCH_WIDTH - 2, INK_GREEN);
+  }
+}
+
+BENCH(line, 100) {
+  for (int i = 0; i < 100; i++) {
+    fb.drawLine(i, 0, 799 - i * 3, 479, INK_BLACK);
+  }
+}
+
+// Thick strokes are drawn as offset copies, like the icons do
+BENCH(thick_line, 100) {
+  for (int i = 0; i < 100; i++) {
+    int x = i * 7;
+    fb.drawLine(x, 40, x + 60, 440, INK_ORANGE);
+    fb.drawLine(x + 1, 40, x + 61, 440, INK_ORANGE);
+    fb.drawLine(x, 41, x + 60, 441, INK_ORANGE);
+    fb.drawLine(x + 1, 41, x + 61, 441, INK_ORANGE);
+  }
+}
+
+BENCH(fill_circle, 10) {
+  for (int i = 0; i < 10; i++) {
+    fb.fillCircle(100 + i * 60, 240, 60, INK_YELLOW);
+  }
+}
+
+BENCH(fill_circle_dithered, 10) {
+  for (int i = 0; i < 10; i++) {
+    fb.fillCircleDithered(100 + i * 60, 240, 60, INK_BLUE);
+  }
+}
+
+BENCH(glyph, 20) {
+  benchSink = drawText(fb, u8g2_font_helvR24_tf, 20, 200,
+                       "06:28 Fajr 12:41 Asr", INK_BLACK);
+}
+
+BENCH(icon, 1) { renderWidgets(fb, sampleModel(), WIDGET_ICON); }
+
+// Every icon at the weather and forecast sizes, the hand-written procedural
+// code against the vector bytecode
+static const char *const ICON_CODES[] = {"01d", "02d", "03d", "09d",
+                                         "11d", "13d", "50d", "xx"};
+static const char *const ICON_CONDITIONS[] = {
+    "Clear", "Clouds", "Clouds", "Rain", "Thunderstorm", "Snow", "Mist", "?"};
+static const IconId ICON_IDS[] = {ICON_CLEAR,   ICON_FEW_CLOUDS, ICON_CLOUDS,
+                                  ICON_RAIN,    ICON_THUNDER,    ICON_SNOW,
+                                  ICON_MIST,    ICON_UNKNOWN};
+
+BENCH(icon_procedural_large, 8) {
+  for (const char *code : ICON_CODES) {
+    drawWeatherIcon(fb, 595, 110, code);
+  }
+}
+
+BENCH(icon_vector_large, 8) {
+  for (IconId icon : ICON_IDS) {
+    drawIcon(fb, icon, 595, 110, 128);
+  }
+}
+
+BENCH(icon_procedural_small, 8) {
+  for (const char *condition : ICON_CONDITIONS) {
+    drawSmallWeatherIcon(fb, 472, 315, condition);
+  }
+}
+
+BENCH(icon_vector_small, 8) {
+  for (IconId icon : ICON_IDS) {
+    drawIcon(fb, icon, 472, 315, 48);
+  }
+}
+
+BENCH(widgets_all, 1) { renderWidgets(fb, sampleModel(), WIDGET_ALL); }
+
+BENCH(frame_hash, 1) { benchSink = fb.hash(); }
+
+BENCH(codec_decode, 1) {
+  const Encoded &encoded = encodedFrame();
+  benchSink = rleDecode(encoded.data, encoded.size, fb.data(), fb.size());
+}
+
+static bool countingSink(void *ctx, const uint8_t *data, size_t len) {
+  *static_cast<size_t *>(ctx) += len;
+  benchSink = data[0];
+  return true;
+}
+
+BENCH(codec_encode, 1) {
+  // The first (warmup) run puts the rendered screen back into the buffer
+  static bool ready = false;
+  if (!ready) {
+    const Encoded &encoded = encodedFrame();
+    rleDecode(encoded.data, encoded.size, fb.data(), fb.size());
+    ready = true;
+  }
+  size_t bytes = 0;
+  benchSink = rleEncode(fb.data(), fb.size(), countingSink, &bytes);
+}
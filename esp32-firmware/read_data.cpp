@@ -1,27 +1,394 @@
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "json.hpp" // The nlohmann/json library
 
 // For convenience, use the nlohmann::json namespace
 using json = nlohmann::json;
 
 /**
- * @brief Parses a JSON file to extract and print the Fajr prayer time.
- * 
- * This program uses the nlohmann/json library to parse a JSON file,
- * navigate to the nested "fajr" prayer time, and print it to the console.
- * It includes robust error handling for file I/O, JSON parsing, and missing keys.
- * 
+ * @brief A read-only memory mapping of the input file.
+ *
+ * The lazy query mode scans the file in place, so the only memory it
+ * needs besides the page cache is the values it prints.
+ */
+struct MappedFile {
+    const char* data = nullptr;
+    size_t size = 0;
+
+    bool open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        size = st.st_size;
+        if (size > 0) {
+            void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                return false;
+            }
+            madvise(p, size, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(p);
+        }
+        ::close(fd); // The mapping stays valid
+        return true;
+    }
+
+    ~MappedFile() {
+        if (data != nullptr) {
+            munmap(const_cast<char*>(data), size);
+        }
+    }
+};
+
+/**
+ * @brief Resolves JSON Pointers (RFC 6901) by scanning the text, without a DOM.
+ *
+ * Members and elements before the requested one are skipped by matching
+ * brackets and strings only, so nothing is allocated for them and the scan
+ * stops as soon as the value is found. Skipped subtrees are therefore not
+ * fully validated; the value that is found is, when it gets parsed.
+ *
+ * For the same reason, when an object repeats a key, the first member
+ * with that name is the one found. A full parse keeps the last. Keeping
+ * the last here would mean scanning every object on the path to its end,
+ * which for the archive's top-level keys is the whole file.
+ */
+class LazyScanner {
+public:
+    LazyScanner(const char* data, size_t size) : begin(data), end(data + size) {}
+
+    /**
+     * @brief Finds the value the pointer refers to.
+     * @param tokens The pointer's reference tokens, already unescaped.
+     * @param value Receives the value's text on success.
+     * @return true if found; otherwise error() says why.
+     */
+    bool find(const std::vector<std::string>& tokens, std::string& value) {
+        p = begin;
+        failure.clear();
+        skipWhitespace();
+        for (const std::string& token : tokens) {
+            if (!enter(token)) {
+                return false;
+            }
+        }
+        const char* start = p;
+        if (!skipValue()) {
+            return false;
+        }
+        value.assign(start, p - start);
+        return true;
+    }
+
+    const std::string& error() const { return failure; }
+
+private:
+    const char* begin;
+    const char* end;
+    const char* p = nullptr;
+    std::string failure;
+
+    bool fail(const std::string& message) {
+        failure = message + " at byte " + std::to_string(p - begin);
+        return false;
+    }
+
+    void skipWhitespace() {
+        while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) {
+            p++;
+        }
+    }
+
+    bool expect(char c) {
+        skipWhitespace();
+        if (p >= end || *p != c) {
+            return fail(std::string("expected '") + c + "'");
+        }
+        p++;
+        skipWhitespace();
+        return true;
+    }
+
+    // Leaves p after the closing quote; p is on the opening one
+    bool skipString() {
+        p++;
+        while (true) {
+            const char* quote = static_cast<const char*>(memchr(p, '"', end - p));
+            if (quote == nullptr) {
+                return fail("unterminated string");
+            }
+            // The quote is escaped if an odd number of backslashes precede it
+            const char* q = quote;
+            while (q > p && q[-1] == '\\') {
+                q--;
+            }
+            p = quote + 1;
+            if ((quote - q) % 2 == 0) {
+                return true;
+            }
+        }
+    }
+
+    // Skips one value of any kind, leaving p right after it
+    bool skipValue() {
+        if (p >= end) {
+            return fail("expected a value");
+        }
+        if (*p == '"') {
+            return skipString();
+        }
+        if (*p != '{' && *p != '[') {
+            // Number, true, false or null
+            const char* start = p;
+            while (p < end && *p != ',' && *p != '}' && *p != ']' &&
+                   *p != ' ' && *p != '\n' && *p != '\r' && *p != '\t') {
+                p++;
+            }
+            return p > start || fail("expected a value");
+        }
+        int depth = 0;
+        while (p < end) {
+            char c = *p;
+            if (c == '"') {
+                if (!skipString()) {
+                    return false;
+                }
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                depth++;
+            } else if (c == '}' || c == ']') {
+                if (--depth == 0) {
+                    p++;
+                    return true;
+                }
+            }
+            p++;
+        }
+        return fail("unbalanced brackets");
+    }
+
+    // Moves p to the member or element named by token
+    bool enter(const std::string& token) {
+        if (p < end && *p == '{') {
+            return enterObject(token);
+        }
+        if (p < end && *p == '[') {
+            return enterArray(token);
+        }
+        return fail("'" + token + "' not found: not an object or array");
+    }
+
+    bool enterObject(const std::string& token) {
+        p++;
+        skipWhitespace();
+        while (p < end && *p == '"') {
+            const char* keyStart = p;
+            if (!skipString()) {
+                return false;
+            }
+            bool match;
+            if (memchr(keyStart, '\\', p - keyStart) == nullptr) {
+                match = static_cast<size_t>(p - keyStart - 2) == token.size() &&
+                        memcmp(keyStart + 1, token.data(), token.size()) == 0;
+            } else {
+                // Escaped keys are rare; let the library decode them
+                match = json::parse(keyStart, p).get<std::string>() == token;
+            }
+            if (!expect(':')) {
+                return false;
+            }
+            if (match) {
+                return true;
+            }
+            if (!skipValue()) {
+                return false;
+            }
+            skipWhitespace();
+            if (p < end && *p == ',') {
+                p++;
+                skipWhitespace();
+            }
+        }
+        return fail("key '" + token + "' not found");
+    }
+
+    bool enterArray(const std::string& token) {
+        if (token.empty() || token.size() > 18 ||
+            token.find_first_not_of("0123456789") != std::string::npos ||
+            (token.size() > 1 && token[0] == '0')) {
+            return fail("'" + token + "' is not an array index");
+        }
+        unsigned long long index = std::stoull(token);
+        p++;
+        skipWhitespace();
+        for (unsigned long long i = 0; p < end && *p != ']'; i++) {
+            if (i == index) {
+                return true;
+            }
+            if (!skipValue()) {
+                return false;
+            }
+            skipWhitespace();
+            if (p < end && *p == ',') {
+                p++;
+                skipWhitespace();
+            }
+        }
+        return fail("index " + token + " out of range");
+    }
+};
+
+/**
+ * @brief Splits a JSON Pointer into its unescaped reference tokens.
+ * @return false if the pointer is neither empty nor starts with '/'.
+ */
+bool parsePointer(const std::string& pointer, std::vector<std::string>& tokens) {
+    tokens.clear();
+    if (pointer.empty()) {
+        return true; // The whole document
+    }
+    if (pointer[0] != '/') {
+        return false;
+    }
+    size_t start = 1;
+    while (true) {
+        size_t slash = pointer.find('/', start);
+        std::string token = pointer.substr(start, slash - start);
+        std::string unescaped;
+        for (size_t i = 0; i < token.size(); i++) {
+            if (token[i] == '~') {
+                if (i + 1 >= token.size() || (token[i + 1] != '0' && token[i + 1] != '1')) {
+                    return false;
+                }
+                unescaped += token[++i] == '0' ? '~' : '/';
+            } else {
+                unescaped += token[i];
+            }
+        }
+        tokens.push_back(unescaped);
+        if (slash == std::string::npos) {
+            return true;
+        }
+        start = slash + 1;
+    }
+}
+
+/**
+ * @brief Prints a value the same way in both modes: strings as-is, everything else as JSON.
+ */
+void printValue(const json& value) {
+    if (value.is_string()) {
+        std::cout << value.get<std::string>() << '\n';
+    } else {
+        std::cout << value.dump() << '\n';
+    }
+}
+
+/**
+ * @brief Resolves each pointer by scanning the memory-mapped file.
+ * @return 0 if every pointer resolved, 1 otherwise.
+ */
+int queryLazy(const std::string& filePath, const std::vector<std::string>& pointers) {
+    MappedFile file;
+    if (!file.open(filePath)) {
+        std::cerr << "Error: Could not open file '" << filePath << "'" << std::endl;
+        return 1;
+    }
+    LazyScanner scanner(file.data, file.size);
+    int status = 0;
+    std::vector<std::string> tokens;
+    std::string text;
+    for (const std::string& pointer : pointers) {
+        if (!parsePointer(pointer, tokens)) {
+            std::cerr << "Error: Invalid JSON Pointer '" << pointer << "'" << std::endl;
+            status = 1;
+            continue;
+        }
+        if (!scanner.find(tokens, text)) {
+            std::cerr << "Error: " << pointer << ": " << scanner.error() << std::endl;
+            status = 1;
+            continue;
+        }
+        try {
+            printValue(json::parse(text));
+        } catch (json::parse_error& e) {
+            std::cerr << "Error: " << pointer << ": " << e.what() << std::endl;
+            status = 1;
+        }
+    }
+    return status;
+}
+
+/**
+ * @brief Resolves each pointer against a fully parsed document, for comparison.
+ * @return 0 if every pointer resolved, 1 otherwise.
+ */
+int queryDom(const json& data, const std::vector<std::string>& pointers) {
+    int status = 0;
+    for (const std::string& pointer : pointers) {
+        try {
+            printValue(data.at(json::json_pointer(pointer)));
+        } catch (json::exception& e) {
+            std::cerr << "Error: " << pointer << ": " << e.what() << std::endl;
+            status = 1;
+        }
+    }
+    return status;
+}
+
+/**
+ * @brief Parses a JSON file to extract and print the Fajr prayer time, or queried values.
+ *
+ * Without arguments besides the file, this program uses the nlohmann/json
+ * library to parse the whole file, navigate to the nested "fajr" prayer
+ * time, and print it to the console. It includes robust error handling for
+ * file I/O, JSON parsing, and missing keys.
+ *
+ * With one or more -q options, each JSON Pointer (e.g. /prayer_times/fajr
+ * or /days/0/weather) is resolved and its value printed on its own line.
+ * The file is memory-mapped and scanned lazily: unrequested subtrees are
+ * skipped without building a DOM, so large payloads and archives are cheap
+ * to query. --dom resolves the same pointers against a full parse instead.
+ * The two agree unless an object repeats a key: the scan then returns the
+ * first member with that name and the full parse the last.
+ *
+ * Usage: read_data [--dom] [-q pointer]... [file]
+ *
  * @param argc The number of command-line arguments.
- * @param argv An array of command-line arguments. Expects the file path as an optional second argument.
+ * @param argv An array of command-line arguments.
  * @return int Returns 0 on success, 1 on failure.
  */
 int main(int argc, char* argv[]) {
-    // Determine the file path
+    // Determine the file path and the queries
     std::string filePath = "data-collection/output/display_data.json";
-    if (argc > 1) {
-        filePath = argv[1];
+    std::vector<std::string> pointers;
+    bool dom = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-q" && i + 1 < argc) {
+            pointers.push_back(argv[++i]);
+        } else if (arg == "--dom") {
+            dom = true;
+        } else {
+            filePath = arg;
+        }
+    }
+    if (!pointers.empty() && !dom) {
+        return queryLazy(filePath, pointers);
     }
 
     // 1. Open the file
@@ -41,6 +408,9 @@ int main(int argc, char* argv[]) {
                   << "Byte position: " << e.byte << std::endl;
         return 1;
     }
+    if (!pointers.empty()) {
+        return queryDom(data, pointers);
+    }
 
     // 3. Safely access the nested "fajr" value and print it
     try {
@@ -0,0 +1,19 @@
+#include "band_render.h"
+
+bool renderBands(FrameBuffer &band, BandPainter paint, void *paintCtx,
+                 BandSink sink, void *sinkCtx, uint32_t *hash) {
+  uint32_t h = 2166136261u;
+  for (int16_t top = 0; top < band.height(); top += band.bandRows()) {
+    band.setBand(top);
+    paint(paintCtx, band);
+    h = band.hash(h);
+    if (!sink(sinkCtx, band)) {
+      return false;
+    }
+  }
+  band.setBand(0);
+  if (hash) {
+    *hash = h;
+  }
+  return true;
+}
@@ -0,0 +1,32 @@
+/*
+ * Band rendering for panels whose frame doesn't fit in RAM
+ *
+ * A 1200x1600 frame is 960 KB at 4bpp. Instead of holding it, the frame is
+ * drawn a band of rows at a time into a FrameBuffer that holds only that
+ * band, and each finished band is handed to a sink (the panel's data
+ * stream) top to bottom. Every band re-runs the painter; widgets whose rect
+ * misses the band are skipped, glyphs outside it are not decoded and
+ * fills are clipped to its rows, so the total work stays close to that of
+ * one full-frame render.
+ */
+
+#ifndef BAND_RENDER_H
+#define BAND_RENDER_H
+
+#include "framebuffer.h"
+
+#include <stdint.h>
+
+// Draws the whole frame in frame coordinates; may be called once per band
+typedef void (*BandPainter)(void *ctx, FrameBuffer &band);
+
+// Receives each finished band; returns false to abort
+typedef bool (*BandSink)(void *ctx, const FrameBuffer &band);
+
+// Render every band of band's frame and pass it to the sink. hash (may be
+// null) receives the same value as FrameBuffer::hash() of a full-frame
+// render. Returns false if the sink aborted.
+bool renderBands(FrameBuffer &band, BandPainter paint, void *paintCtx,
+                 BandSink sink, void *sinkCtx, uint32_t *hash);
+
+#endif
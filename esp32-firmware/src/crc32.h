@@ -0,0 +1,14 @@
+/*
+ * CRC-32 (IEEE 802.3, as zlib), for the state blob and sync datagrams
+ */
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Pass the previous result as crc to checksum data in pieces; start with 0
+uint32_t crc32(uint32_t crc, const void *data, size_t len);
+
+#endif
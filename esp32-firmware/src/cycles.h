@@ -0,0 +1,28 @@
+/*
+ * Cycle counter for timing code on both targets
+ *
+ * On the ESP32 this is the CPU's CCOUNT register (wraps every ~18 s at
+ * 240 MHz); on the host it is a steady clock in nanoseconds, truncated the
+ * same way. Take differences of nearby samples only.
+ */
+
+#ifndef CYCLES_H
+#define CYCLES_H
+
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+
+static inline uint32_t cycleCount() { return ESP.getCycleCount(); }
+#else
+#include <chrono>
+
+static inline uint32_t cycleCount() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+#endif
+
+#endif
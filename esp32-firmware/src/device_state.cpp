@@ -0,0 +1,44 @@
+#include "device_state.h"
+
+#include "crc32.h"
+#include <string.h>
+
+void stateDefaults(DeviceState &state) {
+  memset(&state, 0, sizeof(state)); // padding too, the blob is CRC'd
+  state.rtc.nextWakeFetches = 1;
+}
+
+uint32_t stateCrc(const StateImage &image) {
+  uint32_t crc = crc32(0, &image.header, offsetof(StateHeader, crc));
+  return crc32(crc, &image.state, sizeof(image.state));
+}
+
+void stateSeal(StateImage &image, uint32_t generation) {
+  image.header.magic = STATE_MAGIC;
+  image.header.version = STATE_VERSION;
+  image.header.size = sizeof(DeviceState);
+  image.header.generation = generation;
+  image.header.crc = stateCrc(image);
+}
+
+bool stateValid(const StateImage &image) {
+  return image.header.magic == STATE_MAGIC &&
+         image.header.version == STATE_VERSION &&
+         image.header.size == sizeof(DeviceState) &&
+         image.header.crc == stateCrc(image);
+}
+
+const StateImage *stateNewest(const StateImage *a, const StateImage *b) {
+  bool aValid = a && stateValid(*a);
+  bool bValid = b && stateValid(*b);
+  if (aValid && bValid) {
+    // Generations only grow; the difference handles a wrap
+    return (int32_t)(a->header.generation - b->header.generation) >= 0 ? a
+                                                                       : b;
+  }
+  return aValid ? a : (bValid ? b : nullptr);
+}
+
+bool stateDurableChanged(const DeviceState &a, const DeviceState &b) {
+  return memcmp(&a.durable, &b.durable, sizeof(a.durable)) != 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * Everything a wake persists except frames, as one versioned blob
+ *
+ * The blob is a header (magic, version, size, generation, CRC-32) followed
+ * by a DeviceState. state_store.cpp keeps it in RTC memory across deep
+ * sleep and writes it to one of two flash sectors, alternating, whenever
+ * the durable part changed; the copy with the highest valid generation
+ * wins at boot, so a write cut short by power loss leaves the previous
+ * generation in place. Bump STATE_VERSION when DeviceState changes; an
+ * older blob is then ignored and the defaults are used.
+ */
+
+#ifndef DEVICE_STATE_H
+#define DEVICE_STATE_H
+
+#include "network_score.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define STATE_MAGIC 0x31545344 // "DST1"
+#define STATE_VERSION 5
+
+// Worth a flash write: must survive a power loss
+struct DurableState {
+  NetworkStats networkStats[MAX_NETWORKS];
+};
+
+// Only needed from one wake to the next; kept in RTC memory and only
+// written to flash along with a durable change
+struct VolatileState {
+  uint8_t nextWakeFetches;
+  char timeZone[48];
+  uint32_t wakes;
+  uint32_t flashBytes; // written by the last wake, state and frames
+  uint32_t payloadVersion; // MQTT/UDP payload on the panel, 0 if none
+  uint8_t fetchFailures;   // consecutive, 0 after a successful fetch
+  uint32_t retryAt;        // Unix time of the next retry when failing
+  bool errorShown;         // the error screen is on the panel
+  uint32_t pendingSince;   // Unix time the stored frame got ahead of the
+                           // panel (refresh_policy.h), 0 if it is shown
+  int16_t panelTemperature; // on the panel while a change is pending
+  uint16_t avoidedDay;      // local day of the year refreshesAvoided counts
+  uint16_t refreshesAvoided;
+};
+
+struct DeviceState {
+  DurableState durable;
+  VolatileState rtc;
+};
+
+struct StateHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t size;
+  uint32_t generation; // flash writes so far; 0 was never written
+  uint32_t crc;        // over the header up to here and the state
+};
+
+struct StateImage {
+  StateHeader header;
+  DeviceState state;
+};
+
+void stateDefaults(DeviceState &state);
+
+uint32_t stateCrc(const StateImage &image);
+void stateSeal(StateImage &image, uint32_t generation);
+bool stateValid(const StateImage &image);
+
+// The valid image with the higher generation; null if neither is valid
+const StateImage *stateNewest(const StateImage *a, const StateImage *b);
+
+bool stateDurableChanged(const DeviceState &a, const DeviceState &b);
+
+#endif
@@ -0,0 +1,177 @@
+#include "font.h"
+
+#include "render_hot.h"
+
+// u8g2 font header layout
+#define FONT_HEADER_SIZE 23
+#define FONT_BITS_PER_0 2
+#define FONT_BITS_PER_1 3
+#define FONT_BITS_PER_WIDTH 4
+#define FONT_BITS_PER_HEIGHT 5
+#define FONT_BITS_PER_X 6
+#define FONT_BITS_PER_Y 7
+#define FONT_BITS_PER_DELTA_X 8
+#define FONT_START_UPPER_A 17
+#define FONT_START_LOWER_A 19
+
+namespace {
+
+// LSB-first bit reader over a glyph's bitstream
+struct BitReader {
+  const uint8_t *ptr;
+  uint8_t bitPos;
+
+  uint8_t RENDER_HOT unsignedBits(uint8_t count) {
+    uint16_t val = *ptr >> bitPos;
+    uint8_t end = bitPos + count;
+    if (end >= 8) {
+      ptr++;
+      val |= (uint16_t)*ptr << (8 - bitPos);
+      end -= 8;
+    }
+    bitPos = end;
+    return val & ((1u << count) - 1);
+  }
+
+  int8_t signedBits(uint8_t count) {
+    return (int8_t)((int16_t)unsignedBits(count) - (1 << (count - 1)));
+  }
+};
+
+struct Glyph {
+  BitReader bits;
+  uint8_t width;
+  uint8_t height;
+  int8_t x;
+  int8_t y;
+  int8_t deltaX;
+};
+
+// Next code point from a UTF-8 string, or 0 at the end
+uint16_t nextCodePoint(const char *&s) {
+  while (*s) {
+    uint8_t c = (uint8_t)*s++;
+    if (c < 0x80) {
+      return c;
+    }
+    int extra = (c >= 0xE0) ? 2 : (c >= 0xC0) ? 1 : -1;
+    if (extra < 0) {
+      continue; // stray continuation byte
+    }
+    uint16_t cp = c & (extra == 2 ? 0x0F : 0x1F);
+    for (; extra > 0 && (*s & 0xC0) == 0x80; extra--) {
+      cp = (cp << 6) | (*s++ & 0x3F);
+    }
+    if (extra == 0) {
+      return cp;
+    }
+  }
+  return 0;
+}
+
+// The _tf fonts only carry the 8-bit range; anything else has no glyph
+bool RENDER_HOT findGlyph(const uint8_t *font, uint16_t encoding, Glyph &g) {
+  if (encoding > 255) {
+    return false;
+  }
+  const uint8_t *p = font + FONT_HEADER_SIZE;
+  if (encoding >= 'a') {
+    p += (font[FONT_START_LOWER_A] << 8) | font[FONT_START_LOWER_A + 1];
+  } else if (encoding >= 'A') {
+    p += (font[FONT_START_UPPER_A] << 8) | font[FONT_START_UPPER_A + 1];
+  }
+  // Each entry: encoding, offset to the next entry, bitstream
+  for (; p[1] != 0; p += p[1]) {
+    if (p[0] == encoding) {
+      g.bits.ptr = p + 2;
+      g.bits.bitPos = 0;
+      g.width = g.bits.unsignedBits(font[FONT_BITS_PER_WIDTH]);
+      g.height = g.bits.unsignedBits(font[FONT_BITS_PER_HEIGHT]);
+      g.x = g.bits.signedBits(font[FONT_BITS_PER_X]);
+      g.y = g.bits.signedBits(font[FONT_BITS_PER_Y]);
+      g.deltaX = g.bits.signedBits(font[FONT_BITS_PER_DELTA_X]);
+      return true;
+    }
+  }
+  return false;
+}
+
+void RENDER_HOT drawGlyph(FrameBuffer &fb, const uint8_t *font, Glyph &g,
+                          int16_t x, int16_t y, uint8_t ink) {
+  if (g.width == 0) {
+    return;
+  }
+  int16_t left = x + g.x;
+  int16_t top = y - (g.height + g.y);
+  uint8_t bits0 = font[FONT_BITS_PER_0];
+  uint8_t bits1 = font[FONT_BITS_PER_1];
+
+  // Alternating runs of background and foreground pixels, row-major,
+  // wrapping at the glyph width
+  uint8_t lx = 0;
+  uint8_t ly = 0;
+  while (ly < g.height) {
+    uint8_t background = g.bits.unsignedBits(bits0);
+    uint8_t foreground = g.bits.unsignedBits(bits1);
+    do {
+      for (uint8_t len = background; len > 0;) {
+        uint8_t n = g.width - lx;
+        if (len < n) {
+          lx += len;
+          break;
+        }
+        len -= n;
+        lx = 0;
+        ly++;
+      }
+      for (uint8_t len = foreground; len > 0;) {
+        uint8_t n = g.width - lx;
+        uint8_t run = len < n ? len : n;
+        fb.fillSpan(left + lx, top + ly, run, ink);
+        if (len < n) {
+          lx += len;
+          break;
+        }
+        len -= n;
+        lx = 0;
+        ly++;
+      }
+    } while (g.bits.unsignedBits(1) != 0);
+  }
+}
+
+} // namespace
+
+int16_t drawText(FrameBuffer &fb, const uint8_t *font, int16_t x, int16_t y,
+                 const char *text, uint8_t ink) {
+  Glyph g;
+  for (uint16_t cp = nextCodePoint(text); cp != 0; cp = nextCodePoint(text)) {
+    if (findGlyph(font, cp, g)) {
+      // Glyphs outside the frame buffer's band are not decoded at all
+      if (fb.rowsVisible(y - (g.height + g.y), g.height)) {
+        drawGlyph(fb, font, g, x, y, ink);
+      }
+      x += g.deltaX;
+    }
+  }
+  return x;
+}
+
+int16_t textWidth(const uint8_t *font, const char *text) {
+  int16_t w = 0;
+  Glyph last = {};
+  bool any = false;
+  Glyph g;
+  for (uint16_t cp = nextCodePoint(text); cp != 0; cp = nextCodePoint(text)) {
+    if (findGlyph(font, cp, g)) {
+      w += g.deltaX;
+      last = g;
+      any = true;
+    }
+  }
+  // Like u8g2, count the last glyph by its ink extent, not its advance
+  if (any && last.width != 0) {
+    w += last.width + last.x - last.deltaX;
+  }
+  return w;
+}
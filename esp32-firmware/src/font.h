@@ -0,0 +1,23 @@
+/*
+ * Text rendering from u8g2 font data
+ *
+ * Decodes the run-length glyph bitmaps of the u8g2 fonts shipped with
+ * U8g2_for_Adafruit_GFX (u8g2_fonts.h) straight into a FrameBuffer, so the
+ * same code draws text on the device and in host tools. Matches the
+ * library's transparent font mode with the cursor on the baseline.
+ */
+
+#ifndef FONT_H
+#define FONT_H
+
+#include "framebuffer.h"
+#include <stdint.h>
+
+// Draws UTF-8 text with its baseline at y. Returns the x after the last glyph.
+int16_t drawText(FrameBuffer &fb, const uint8_t *font, int16_t x, int16_t y,
+                 const char *text, uint8_t ink);
+
+// Pixel width as reported by U8G2_FOR_ADAFRUIT_GFX::getUTF8Width()
+int16_t textWidth(const uint8_t *font, const char *text);
+
+#endif
@@ -0,0 +1,148 @@
+#include "frame_codec.h"
+
+#include "render_hot.h"
+#include <string.h>
+
+#define RLE_MAX_LITERAL 128
+#define RLE_MIN_RUN 3
+#define RLE_SHORT_RUN_MAX 128 // 0x80-0xFE covers runs of 2..128
+
+namespace {
+
+// Small staging buffer so the sink sees a few large writes, not one per token
+struct RleWriter {
+  RleSink sink;
+  void *ctx;
+  uint8_t buf[256];
+  size_t fill = 0;
+  size_t total = 0;
+  bool ok = true;
+
+  void put(uint8_t b) {
+    if (fill == sizeof(buf)) {
+      flush();
+    }
+    buf[fill++] = b;
+  }
+
+  void put(const uint8_t *data, size_t len) {
+    while (len > 0) {
+      if (fill == sizeof(buf)) {
+        flush();
+      }
+      size_t n = sizeof(buf) - fill;
+      if (n > len) {
+        n = len;
+      }
+      memcpy(buf + fill, data, n);
+      fill += n;
+      data += n;
+      len -= n;
+    }
+  }
+
+  void flush() {
+    if (fill > 0 && ok) {
+      ok = sink(ctx, buf, fill);
+      total += fill;
+    }
+    fill = 0;
+  }
+};
+
+void emitLiteral(RleWriter &out, const uint8_t *data, size_t len) {
+  while (len > 0) {
+    size_t n = len > RLE_MAX_LITERAL ? RLE_MAX_LITERAL : len;
+    out.put((uint8_t)(n - 1));
+    out.put(data, n);
+    data += n;
+    len -= n;
+  }
+}
+
+void emitRun(RleWriter &out, uint8_t value, size_t len) {
+  if (len <= RLE_SHORT_RUN_MAX) {
+    out.put((uint8_t)(0x80 | (len - 2)));
+  } else {
+    out.put(0xFF);
+    size_t extra = len - (RLE_SHORT_RUN_MAX + 1);
+    do {
+      uint8_t b = extra & 0x7F;
+      extra >>= 7;
+      out.put(extra ? (b | 0x80) : b);
+    } while (extra);
+  }
+  out.put(value);
+}
+
+} // namespace
+
+size_t rleEncode(const uint8_t *src, size_t len, RleSink sink, void *ctx) {
+  RleWriter out;
+  out.sink = sink;
+  out.ctx = ctx;
+
+  size_t literalStart = 0;
+  size_t i = 0;
+  while (i < len) {
+    size_t run = 1;
+    while (i + run < len && src[i + run] == src[i]) {
+      run++;
+    }
+    if (run >= RLE_MIN_RUN) {
+      emitLiteral(out, src + literalStart, i - literalStart);
+      emitRun(out, src[i], run);
+      i += run;
+      literalStart = i;
+    } else {
+      i += run;
+    }
+  }
+  emitLiteral(out, src + literalStart, len - literalStart);
+  out.flush();
+
+  return out.ok ? out.total : 0;
+}
+
+bool RENDER_HOT rleDecode(const uint8_t *src, size_t srcLen, uint8_t *dst,
+                          size_t dstLen) {
+  size_t in = 0;
+  size_t out = 0;
+  while (in < srcLen) {
+    uint8_t c = src[in++];
+    if (c < 0x80) {
+      size_t n = (size_t)c + 1;
+      if (in + n > srcLen || out + n > dstLen) {
+        return false;
+      }
+      memcpy(dst + out, src + in, n);
+      in += n;
+      out += n;
+      continue;
+    }
+
+    size_t n;
+    if (c == 0xFF) {
+      size_t extra = 0;
+      int shift = 0;
+      uint8_t b;
+      do {
+        if (in >= srcLen || shift > 28) {
+          return false;
+        }
+        b = src[in++];
+        extra |= (size_t)(b & 0x7F) << shift;
+        shift += 7;
+      } while (b & 0x80);
+      n = extra + RLE_SHORT_RUN_MAX + 1;
+    } else {
+      n = (size_t)(c & 0x7F) + 2;
+    }
+    if (in >= srcLen || out + n > dstLen) {
+      return false;
+    }
+    memset(dst + out, src[in++], n);
+    out += n;
+  }
+  return out == dstLen;
+}
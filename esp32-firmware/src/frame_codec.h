@@ -0,0 +1,27 @@
+/*
+ * Run-length codec for packed frame buffers
+ *
+ * PackBits-style byte stream:
+ *   0x00-0x7F  literal, (c + 1) raw bytes follow
+ *   0x80-0xFE  run of ((c & 0x7F) + 2) copies of the next byte
+ *   0xFF       long run: LEB128 varint n, then the byte, length n + 129
+ *
+ * A mostly white 800x480 frame (192000 bytes) compresses to a few KB.
+ */
+
+#ifndef FRAME_CODEC_H
+#define FRAME_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Receives encoded bytes; returns false to abort encoding
+typedef bool (*RleSink)(void *ctx, const uint8_t *data, size_t len);
+
+// Encode src into the sink. Returns the encoded size, or 0 on sink failure.
+size_t rleEncode(const uint8_t *src, size_t len, RleSink sink, void *ctx);
+
+// Decode exactly dstLen bytes. Returns false on truncated or oversized input.
+bool rleDecode(const uint8_t *src, size_t srcLen, uint8_t *dst, size_t dstLen);
+
+#endif
@@ -0,0 +1,159 @@
+#include "frame_store.h"
+
+#include "frame_codec.h"
+#include <Arduino.h>
+#include <LittleFS.h>
+
+#define FRAME_FILE "/frame.bin"
+#define NEXT_FRAME_FILE "/next.bin"
+#define FRAME_TMP_FILE "/frame.tmp"
+#define FRAME_MAGIC 0x324D5246 // "FRM2"
+
+struct FrameHeader {
+  uint32_t magic;
+  uint16_t modelVersion;
+  int16_t width;
+  int16_t height;
+  uint32_t hash;
+  uint32_t validAt; // epoch of the wake a pre-rendered frame is for
+  uint32_t encodedSize;
+  RenderModel model;
+};
+
+static size_t bytesWritten = 0;
+
+static bool fileSink(void *ctx, const uint8_t *data, size_t len) {
+  return static_cast<File *>(ctx)->write(data, len) == len;
+}
+
+bool frameStoreBegin() {
+  if (!LittleFS.begin(true)) {
+    Serial.println("LittleFS mount failed");
+    return false;
+  }
+  return true;
+}
+
+static bool readFrameFile(const char *path, FrameBuffer &fb,
+                          FrameHeader &header) {
+  File f = LittleFS.open(path, "r");
+  if (!f) {
+    return false;
+  }
+
+  if (f.read((uint8_t *)&header, sizeof(header)) != sizeof(header) ||
+      header.magic != FRAME_MAGIC || header.modelVersion != MODEL_VERSION ||
+      header.width != fb.width() || header.height != fb.height()) {
+    Serial.printf("Stored frame %s is stale, ignoring\n", path);
+    f.close();
+    return false;
+  }
+
+  uint8_t *encoded = (uint8_t *)malloc(header.encodedSize);
+  if (!encoded) {
+    f.close();
+    return false;
+  }
+  bool ok = f.read(encoded, header.encodedSize) == header.encodedSize &&
+            rleDecode(encoded, header.encodedSize, fb.data(), fb.size());
+  free(encoded);
+  f.close();
+
+  // Guards against a frame that decodes but no longer matches its header
+  if (!ok || fb.hash() != header.hash) {
+    Serial.printf("Stored frame %s is corrupt, ignoring\n", path);
+    return false;
+  }
+  return true;
+}
+
+static bool writeFrameFile(const char *path, const FrameBuffer &fb,
+                           const RenderModel &model, uint32_t hash,
+                           uint32_t validAt) {
+  File f = LittleFS.open(FRAME_TMP_FILE, "w");
+  if (!f) {
+    return false;
+  }
+
+  FrameHeader header = {};
+  header.magic = FRAME_MAGIC;
+  header.modelVersion = MODEL_VERSION;
+  header.width = fb.width();
+  header.height = fb.height();
+  header.hash = hash;
+  header.validAt = validAt;
+  header.model = model;
+  f.write((const uint8_t *)&header, sizeof(header));
+
+  header.encodedSize = rleEncode(fb.data(), fb.size(), fileSink, &f);
+  bool ok = header.encodedSize > 0;
+  if (ok) {
+    // Patch in the size now that we know it
+    f.seek(0);
+    ok = f.write((const uint8_t *)&header, sizeof(header)) == sizeof(header);
+  }
+  f.close();
+
+  // Write-then-rename so a reset mid-write keeps the previous frame
+  if (!ok || !LittleFS.rename(FRAME_TMP_FILE, path)) {
+    LittleFS.remove(FRAME_TMP_FILE);
+    Serial.printf("Failed to store frame %s\n", path);
+    return false;
+  }
+
+  bytesWritten += sizeof(header) + header.encodedSize;
+  Serial.printf("Stored frame %s: %u bytes compressed\n", path,
+                (unsigned)header.encodedSize);
+  return true;
+}
+
+bool loadLastFrame(FrameBuffer &fb, RenderModel &model, uint32_t &hash) {
+  FrameHeader header;
+  if (!readFrameFile(FRAME_FILE, fb, header)) {
+    return false;
+  }
+  model = header.model;
+  hash = header.hash;
+  return true;
+}
+
+bool saveLastFrame(const FrameBuffer &fb, const RenderModel &model,
+                   uint32_t hash) {
+  // A new frame on the panel invalidates whatever was predicted from the old
+  clearNextFrame();
+  return writeFrameFile(FRAME_FILE, fb, model, hash, 0);
+}
+
+void clearLastFrame() {
+  LittleFS.remove(FRAME_FILE);
+  clearNextFrame();
+}
+
+bool loadNextFrame(FrameBuffer &fb, RenderModel &model, uint32_t &hash,
+                   uint32_t &validAt) {
+  FrameHeader header;
+  if (!readFrameFile(NEXT_FRAME_FILE, fb, header)) {
+    return false;
+  }
+  model = header.model;
+  hash = header.hash;
+  validAt = header.validAt;
+  return true;
+}
+
+bool saveNextFrame(const FrameBuffer &fb, const RenderModel &model,
+                   uint32_t hash, uint32_t validAt) {
+  return writeFrameFile(NEXT_FRAME_FILE, fb, model, hash, validAt);
+}
+
+bool promoteNextFrame() {
+  return LittleFS.rename(NEXT_FRAME_FILE, FRAME_FILE);
+}
+
+size_t frameBytesWritten() { return bytesWritten; }
+
+void clearNextFrame() {
+  if (LittleFS.exists(NEXT_FRAME_FILE)) {
+    LittleFS.remove(NEXT_FRAME_FILE);
+  }
+}
@@ -0,0 +1,39 @@
+/*
+ * Last rendered frame, kept compressed in LittleFS together with the
+ * render model it was drawn from and its hash. While a coalesced change is
+ * pending (refresh_policy.h) it is ahead of the panel: the next refresh
+ * shows it.
+ *
+ * A second slot holds the frame pre-rendered for the next wake, tagged with
+ * the wake time it is valid for.
+ */
+
+#ifndef FRAME_STORE_H
+#define FRAME_STORE_H
+
+#include "framebuffer.h"
+#include "render_model.h"
+
+bool frameStoreBegin();
+
+// Decodes the stored frame into fb. False if missing, stale or corrupt.
+bool loadLastFrame(FrameBuffer &fb, RenderModel &model, uint32_t &hash);
+
+bool saveLastFrame(const FrameBuffer &fb, const RenderModel &model,
+                   uint32_t hash);
+
+// Call whenever the panel shows something other than the stored frame
+void clearLastFrame();
+
+bool loadNextFrame(FrameBuffer &fb, RenderModel &model, uint32_t &hash,
+                   uint32_t &validAt);
+bool saveNextFrame(const FrameBuffer &fb, const RenderModel &model,
+                   uint32_t hash, uint32_t validAt);
+// Makes the pre-rendered frame the last frame once it is on the panel
+bool promoteNextFrame();
+void clearNextFrame();
+
+// Bytes written to LittleFS since boot, for the per-wake report
+size_t frameBytesWritten();
+
+#endif
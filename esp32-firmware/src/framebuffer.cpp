@@ -0,0 +1,406 @@
+#include "framebuffer.h"
+
+#include "render_hot.h"
+#include <string.h>
+
+void FrameBuffer::fill(uint8_t ink) {
+  memset(buf, (ink << 4) | ink, size());
+}
+
+void FrameBuffer::setBand(int16_t bandTop) {
+  top = bandTop;
+  rows = h - top < capacity ? h - top : capacity;
+}
+
+void RENDER_HOT FrameBuffer::setPixel(int16_t x, int16_t y, uint8_t ink) {
+  y -= top;
+  if (x < 0 || y < 0 || x >= w || y >= rows) {
+    return;
+  }
+  uint8_t &b = buf[(size_t)y * (w / 2) + x / 2];
+  b = (x & 1) ? (b & 0xF0) | ink : (b & 0x0F) | (ink << 4);
+}
+
+uint8_t FrameBuffer::getPixel(int16_t x, int16_t y) const {
+  y -= top;
+  if (x < 0 || y < 0 || x >= w || y >= rows) {
+    return INK_WHITE;
+  }
+  uint8_t b = buf[(size_t)y * (w / 2) + x / 2];
+  return (x & 1) ? (b & 0x0F) : (b >> 4);
+}
+
+void RENDER_HOT FrameBuffer::fillSpan(int16_t x, int16_t y, int16_t len,
+                                      uint8_t ink) {
+  y -= top;
+  if (y < 0 || y >= rows || len <= 0) {
+    return;
+  }
+  int16_t x1 = x + len; // exclusive
+  if (x < 0) {
+    x = 0;
+  }
+  if (x1 > w) {
+    x1 = w;
+  }
+  if (x >= x1) {
+    return;
+  }
+
+  uint8_t *row = buf + (size_t)y * (w / 2);
+  // Leading odd pixel lives in the low nibble
+  if (x & 1) {
+    row[x / 2] = (row[x / 2] & 0xF0) | ink;
+    x++;
+  }
+  // Whole bytes in the middle
+  int16_t bytes = (x1 - x) / 2;
+  if (bytes > 0) {
+    memset(row + x / 2, (ink << 4) | ink, bytes);
+    x += bytes * 2;
+  }
+  // Trailing even pixel lives in the high nibble
+  if (x < x1) {
+    row[x / 2] = (row[x / 2] & 0x0F) | (ink << 4);
+  }
+}
+
+void RENDER_HOT FrameBuffer::fillSpanDithered(int16_t x, int16_t y,
+                                              int16_t len, uint8_t ink) {
+  // The pattern follows frame coordinates, so bands line up
+  if (y < top || y >= top + rows || len <= 0) {
+    return;
+  }
+  int16_t x1 = x + len;
+  if (x < 0) {
+    x = 0;
+  }
+  if (x1 > w) {
+    x1 = w;
+  }
+  // First pixel with (x + y) even
+  if ((x + y) & 1) {
+    x++;
+  }
+  uint8_t *row = buf + (size_t)(y - top) * (w / 2);
+  // Every painted pixel sits in the same nibble position on this row
+  if (x & 1) {
+    for (; x < x1; x += 2) {
+      row[x / 2] = (row[x / 2] & 0xF0) | ink;
+    }
+  } else {
+    for (; x < x1; x += 2) {
+      row[x / 2] = (row[x / 2] & 0x0F) | (ink << 4);
+    }
+  }
+}
+
+void FrameBuffer::fillRect(int16_t x, int16_t y, int16_t rw, int16_t rh,
+                           uint8_t ink) {
+  int16_t y1 = y + rh < top + rows ? y + rh : top + rows;
+  for (int16_t py = y > top ? y : top; py < y1; py++) {
+    fillSpan(x, py, rw, ink);
+  }
+}
+
+void FrameBuffer::fillRectDithered(int16_t x, int16_t y, int16_t rw,
+                                   int16_t rh, uint8_t ink) {
+  int16_t y1 = y + rh < top + rows ? y + rh : top + rows;
+  for (int16_t py = y > top ? y : top; py < y1; py++) {
+    fillSpanDithered(x, py, rw, ink);
+  }
+}
+
+void FrameBuffer::fillCircleDithered(int16_t cx, int16_t cy, int16_t r,
+                                     uint8_t ink) {
+  // Same pixel set as dx*dx + dy*dy <= r*r, one span per row
+  int32_t r2 = (int32_t)r * r;
+  int16_t dx = r;
+  for (int16_t dy = 0; dy <= r; dy++) {
+    while ((int32_t)dx * dx + (int32_t)dy * dy > r2) {
+      dx--;
+    }
+    fillSpanDithered(cx - dx, cy - dy, 2 * dx + 1, ink);
+    if (dy != 0) {
+      fillSpanDithered(cx - dx, cy + dy, 2 * dx + 1, ink);
+    }
+  }
+}
+
+void FrameBuffer::drawVLine(int16_t x, int16_t y, int16_t len, uint8_t ink) {
+  int16_t y1 = y + len < top + rows ? y + len : top + rows;
+  for (int16_t py = y > top ? y : top; py < y1; py++) {
+    setPixel(x, py, ink);
+  }
+}
+
+static inline void swap16(int16_t &a, int16_t &b) {
+  int16_t t = a;
+  a = b;
+  b = t;
+}
+
+void RENDER_HOT FrameBuffer::drawLine(int16_t x0, int16_t y0, int16_t x1,
+                                      int16_t y1, uint8_t ink) {
+  if (y0 == y1) {
+    if (x0 > x1) {
+      swap16(x0, x1);
+    }
+    fillSpan(x0, y0, x1 - x0 + 1, ink);
+    return;
+  }
+  if (x0 == x1) {
+    if (y0 > y1) {
+      swap16(y0, y1);
+    }
+    drawVLine(x0, y0, y1 - y0 + 1, ink);
+    return;
+  }
+
+  // Bresenham
+  bool steep = (y1 > y0 ? y1 - y0 : y0 - y1) > (x1 > x0 ? x1 - x0 : x0 - x1);
+  if (steep) {
+    swap16(x0, y0);
+    swap16(x1, y1);
+  }
+  if (x0 > x1) {
+    swap16(x0, x1);
+    swap16(y0, y1);
+  }
+  int16_t dx = x1 - x0;
+  int16_t dy = y1 > y0 ? y1 - y0 : y0 - y1;
+  int16_t err = dx / 2;
+  int16_t ystep = y0 < y1 ? 1 : -1;
+  for (; x0 <= x1; x0++) {
+    if (steep) {
+      setPixel(y0, x0, ink);
+    } else {
+      setPixel(x0, y0, ink);
+    }
+    err -= dy;
+    if (err < 0) {
+      y0 += ystep;
+      err += dx;
+    }
+  }
+}
+
+void FrameBuffer::drawCircle(int16_t cx, int16_t cy, int16_t r, uint8_t ink) {
+  setPixel(cx, cy + r, ink);
+  setPixel(cx, cy - r, ink);
+  setPixel(cx + r, cy, ink);
+  setPixel(cx - r, cy, ink);
+  drawCircleCorners(cx, cy, r, 0xF, ink);
+}
+
+void FrameBuffer::drawCircleCorners(int16_t cx, int16_t cy, int16_t r,
+                                    uint8_t corners, uint8_t ink) {
+  int16_t f = 1 - r;
+  int16_t ddx = 1;
+  int16_t ddy = -2 * r;
+  int16_t x = 0;
+  int16_t y = r;
+  while (x < y) {
+    if (f >= 0) {
+      y--;
+      ddy += 2;
+      f += ddy;
+    }
+    x++;
+    ddx += 2;
+    f += ddx;
+    if (corners & 0x4) {
+      setPixel(cx + x, cy + y, ink);
+      setPixel(cx + y, cy + x, ink);
+    }
+    if (corners & 0x2) {
+      setPixel(cx + x, cy - y, ink);
+      setPixel(cx + y, cy - x, ink);
+    }
+    if (corners & 0x8) {
+      setPixel(cx - y, cy + x, ink);
+      setPixel(cx - x, cy + y, ink);
+    }
+    if (corners & 0x1) {
+      setPixel(cx - y, cy - x, ink);
+      setPixel(cx - x, cy - y, ink);
+    }
+  }
+}
+
+void FrameBuffer::fillCircle(int16_t cx, int16_t cy, int16_t r, uint8_t ink) {
+  // Adafruit_GFX fills with vertical lines; the shape is symmetric about the
+  // diagonal, so the same pixels come out of horizontal spans, which are
+  // much cheaper in this packed layout
+  fillSpan(cx - r, cy, 2 * r + 1, ink);
+  int16_t f = 1 - r;
+  int16_t ddx = 1;
+  int16_t ddy = -2 * r;
+  int16_t x = 0;
+  int16_t y = r;
+  int16_t px = x;
+  int16_t py = y;
+  while (x < y) {
+    if (f >= 0) {
+      y--;
+      ddy += 2;
+      f += ddy;
+    }
+    x++;
+    ddx += 2;
+    f += ddx;
+    if (x < y + 1) {
+      fillSpan(cx - y, cy + x, 2 * y + 1, ink);
+      fillSpan(cx - y, cy - x, 2 * y + 1, ink);
+    }
+    if (y != py) {
+      fillSpan(cx - px, cy + py, 2 * px + 1, ink);
+      fillSpan(cx - px, cy - py, 2 * px + 1, ink);
+      py = y;
+    }
+    px = x;
+  }
+}
+
+void FrameBuffer::fillCircleHalves(int16_t cx, int16_t cy, int16_t r,
+                                   uint8_t halves, int16_t stretch,
+                                   uint8_t ink) {
+  int16_t f = 1 - r;
+  int16_t ddx = 1;
+  int16_t ddy = -2 * r;
+  int16_t x = 0;
+  int16_t y = r;
+  int16_t px = x;
+  int16_t py = y;
+  stretch++;
+  while (x < y) {
+    if (f >= 0) {
+      y--;
+      ddy += 2;
+      f += ddy;
+    }
+    x++;
+    ddx += 2;
+    f += ddx;
+    if (x < y + 1) {
+      if (halves & 1) {
+        drawVLine(cx + x, cy - y, 2 * y + stretch, ink);
+      }
+      if (halves & 2) {
+        drawVLine(cx - x, cy - y, 2 * y + stretch, ink);
+      }
+    }
+    if (y != py) {
+      if (halves & 1) {
+        drawVLine(cx + py, cy - px, 2 * px + stretch, ink);
+      }
+      if (halves & 2) {
+        drawVLine(cx - py, cy - px, 2 * px + stretch, ink);
+      }
+      py = y;
+    }
+    px = x;
+  }
+}
+
+void FrameBuffer::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                               int16_t x2, int16_t y2, uint8_t ink) {
+  // Sort by y (y0 <= y1 <= y2)
+  if (y0 > y1) {
+    swap16(y0, y1);
+    swap16(x0, x1);
+  }
+  if (y1 > y2) {
+    swap16(y2, y1);
+    swap16(x2, x1);
+  }
+  if (y0 > y1) {
+    swap16(y0, y1);
+    swap16(x0, x1);
+  }
+
+  int16_t a, b;
+  if (y0 == y2) { // all on one line
+    a = b = x0;
+    if (x1 < a) {
+      a = x1;
+    } else if (x1 > b) {
+      b = x1;
+    }
+    if (x2 < a) {
+      a = x2;
+    } else if (x2 > b) {
+      b = x2;
+    }
+    fillSpan(a, y0, b - a + 1, ink);
+    return;
+  }
+
+  int16_t dx01 = x1 - x0, dy01 = y1 - y0, dx02 = x2 - x0, dy02 = y2 - y0,
+          dx12 = x2 - x1, dy12 = y2 - y1;
+  int32_t sa = 0;
+  int32_t sb = 0;
+  // Upper part; includes y1 only if the lower part is flat
+  int16_t last = (y1 == y2) ? y1 : y1 - 1;
+  int16_t y;
+  for (y = y0; y <= last; y++) {
+    a = x0 + sa / dy01;
+    b = x0 + sb / dy02;
+    sa += dx01;
+    sb += dx02;
+    if (a > b) {
+      swap16(a, b);
+    }
+    fillSpan(a, y, b - a + 1, ink);
+  }
+  // Lower part
+  sa = (int32_t)dx12 * (y - y1);
+  sb = (int32_t)dx02 * (y - y0);
+  for (; y <= y2; y++) {
+    a = x1 + sa / dy12;
+    b = x0 + sb / dy02;
+    sa += dx12;
+    sb += dx02;
+    if (a > b) {
+      swap16(a, b);
+    }
+    fillSpan(a, y, b - a + 1, ink);
+  }
+}
+
+void FrameBuffer::drawRoundRect(int16_t x, int16_t y, int16_t rw, int16_t rh,
+                                int16_t r, uint8_t ink) {
+  int16_t maxRadius = ((rw < rh) ? rw : rh) / 2;
+  if (r > maxRadius) {
+    r = maxRadius;
+  }
+  fillSpan(x + r, y, rw - 2 * r, ink);          // top
+  fillSpan(x + r, y + rh - 1, rw - 2 * r, ink); // bottom
+  drawVLine(x, y + r, rh - 2 * r, ink);          // left
+  drawVLine(x + rw - 1, y + r, rh - 2 * r, ink); // right
+  drawCircleCorners(x + r, y + r, r, 1, ink);
+  drawCircleCorners(x + rw - r - 1, y + r, r, 2, ink);
+  drawCircleCorners(x + rw - r - 1, y + rh - r - 1, r, 4, ink);
+  drawCircleCorners(x + r, y + rh - r - 1, r, 8, ink);
+}
+
+void FrameBuffer::fillRoundRect(int16_t x, int16_t y, int16_t rw, int16_t rh,
+                                int16_t r, uint8_t ink) {
+  int16_t maxRadius = ((rw < rh) ? rw : rh) / 2;
+  if (r > maxRadius) {
+    r = maxRadius;
+  }
+  fillRect(x + r, y, rw - 2 * r, rh, ink);
+  fillCircleHalves(x + rw - r - 1, y + r, r, 1, rh - 2 * r - 1, ink);
+  fillCircleHalves(x + r, y + r, r, 2, rh - 2 * r - 1, ink);
+}
+
+uint32_t RENDER_HOT FrameBuffer::hash(uint32_t seed) const {
+  uint32_t hash = seed;
+  size_t n = size();
+  for (size_t i = 0; i < n; i++) {
+    hash ^= buf[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
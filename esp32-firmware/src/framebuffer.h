@@ -0,0 +1,101 @@
+/*
+ * 4-bit-per-pixel frame buffer in the native 7-color panel format
+ *
+ * Two pixels per byte, left pixel in the high nibble, exactly what
+ * GxEPD2_730c_GDEY073D46::writeNative() expects. Plain C++ with no Arduino
+ * dependencies so the same kernels run on the host.
+ *
+ * The buffer may hold only a band of rows of a larger frame (see
+ * band_render.h). Drawing always uses frame coordinates; whatever falls
+ * outside the band is clipped.
+ */
+
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Native panel color codes (one nibble per pixel)
+#define INK_BLACK 0x0
+#define INK_WHITE 0x1
+#define INK_GREEN 0x2
+#define INK_BLUE 0x3
+#define INK_RED 0x4
+#define INK_YELLOW 0x5
+#define INK_ORANGE 0x6
+
+class FrameBuffer {
+public:
+  FrameBuffer(uint8_t *buffer, int16_t width, int16_t height)
+      : buf(buffer), w(width), h(height), top(0), rows(height),
+        capacity(height) {}
+  // A buffer of bandRows rows, starting as the frame's first band
+  FrameBuffer(uint8_t *buffer, int16_t width, int16_t height,
+              int16_t bandRows)
+      : buf(buffer), w(width), h(height), top(0),
+        rows(bandRows < height ? bandRows : height), capacity(bandRows) {}
+
+  int16_t width() const { return w; }
+  int16_t height() const { return h; }
+  // Bytes of the band, i.e. of the whole frame unless banded
+  uint8_t *data() { return buf; }
+  const uint8_t *data() const { return buf; }
+  size_t size() const { return (size_t)w * rows / 2; }
+
+  // Rows of the frame the buffer currently holds
+  int16_t bandTop() const { return top; }
+  int16_t bandRows() const { return rows; }
+  bool isBanded() const { return rows != h; }
+  // Moves the band; the last band of a frame may be shorter
+  void setBand(int16_t bandTop);
+  // Whether any of rows [y, y + n) fall inside the band
+  bool rowsVisible(int16_t y, int16_t n) const {
+    return y < top + rows && y + n > top;
+  }
+
+  void fill(uint8_t ink);
+  void setPixel(int16_t x, int16_t y, uint8_t ink);
+  uint8_t getPixel(int16_t x, int16_t y) const;
+
+  // Horizontal run of w pixels starting at (x, y), clipped to the frame
+  void fillSpan(int16_t x, int16_t y, int16_t w, uint8_t ink);
+  // Same run, but only pixels where (x + y) is even are painted
+  void fillSpanDithered(int16_t x, int16_t y, int16_t w, uint8_t ink);
+
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t ink);
+  void fillRectDithered(int16_t x, int16_t y, int16_t w, int16_t h,
+                        uint8_t ink);
+  void fillCircleDithered(int16_t cx, int16_t cy, int16_t r, uint8_t ink);
+
+  // Outline and fill primitives, pixel-compatible with Adafruit_GFX
+  void drawVLine(int16_t x, int16_t y, int16_t h, uint8_t ink);
+  void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t ink);
+  void drawCircle(int16_t cx, int16_t cy, int16_t r, uint8_t ink);
+  void fillCircle(int16_t cx, int16_t cy, int16_t r, uint8_t ink);
+  void fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                    int16_t x2, int16_t y2, uint8_t ink);
+  void drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r,
+                     uint8_t ink);
+  void fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r,
+                     uint8_t ink);
+
+  // FNV-1a over the packed pixels; identical frames give identical hashes.
+  // Chain the bands of a frame through seed to get the full frame's hash.
+  uint32_t hash(uint32_t seed = 2166136261u) const;
+
+private:
+  void drawCircleCorners(int16_t cx, int16_t cy, int16_t r, uint8_t corners,
+                         uint8_t ink);
+  void fillCircleHalves(int16_t cx, int16_t cy, int16_t r, uint8_t halves,
+                        int16_t stretch, uint8_t ink);
+
+  uint8_t *buf;
+  int16_t w;
+  int16_t h;
+  int16_t top;
+  int16_t rows;
+  int16_t capacity;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#include "http_date.h"
+
+#include <string.h>
+
+static int digits(const char *s, int n) {
+  int value = 0;
+  for (int i = 0; i < n; i++) {
+    if (s[i] < '0' || s[i] > '9') {
+      return -1;
+    }
+    value = value * 10 + (s[i] - '0');
+  }
+  return value;
+}
+
+// Howard Hinnant's days_from_civil, so no timegm() is needed
+int64_t daysFromCivil(int year, int month, int day) {
+  year -= month <= 2;
+  int64_t era = (year >= 0 ? year : year - 399) / 400;
+  int yoe = year - era * 400;
+  int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+int64_t parseHttpDate(const char *value) {
+  static const char MONTHS[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+  // "Sun, 06 Nov 1994 08:49:37 GMT"
+  if (strlen(value) != 29 || value[3] != ',' || value[4] != ' ' ||
+      value[7] != ' ' || value[11] != ' ' || value[16] != ' ' ||
+      value[19] != ':' || value[22] != ':' || strcmp(value + 25, " GMT")) {
+    return -1;
+  }
+  int month = 0;
+  while (month < 12 && strncmp(MONTHS + month * 3, value + 8, 3) != 0) {
+    month++;
+  }
+  int day = digits(value + 5, 2);
+  int year = digits(value + 12, 4);
+  int hour = digits(value + 17, 2);
+  int minute = digits(value + 20, 2);
+  int second = digits(value + 23, 2);
+  if (month == 12 || day < 1 || day > 31 || year < 1970 || hour < 0 ||
+      hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 60) {
+    return -1;
+  }
+  return daysFromCivil(year, month + 1, day) * 86400 + hour * 3600 +
+         minute * 60 + second;
+}
+
+int64_t httpDateClockMs(int64_t date, uint32_t roundTripMs) {
+  return date * 1000 + 500 + roundTripMs / 2;
+}
@@ -0,0 +1,28 @@
+/*
+ * Setting the clock from an HTTP response's Date header
+ *
+ * Every fetch gets a Date from a server that keeps its own clock on time,
+ * so fetching wakes need no NTP exchange of their own. Date has whole
+ * seconds and is stamped at some point during the request's round trip;
+ * the estimate takes the middle of both, which puts it within half a
+ * second plus half the round trip of the server's clock.
+ */
+
+#ifndef HTTP_DATE_H
+#define HTTP_DATE_H
+
+#include <stdint.h>
+
+// Seconds since the Unix epoch from an IMF-fixdate ("Sun, 06 Nov 1994
+// 08:49:37 GMT"), the form servers must send; -1 for anything else
+int64_t parseHttpDate(const char *value);
+
+// Days from 1970-01-01 to a proleptic Gregorian date; also numbers the
+// days of the offline calendar (provision.h)
+int64_t daysFromCivil(int year, int month, int day);
+
+// Milliseconds since the epoch when a response with this Date arrived,
+// roundTripMs after the request was sent
+int64_t httpDateClockMs(int64_t date, uint32_t roundTripMs);
+
+#endif
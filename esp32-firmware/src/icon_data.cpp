@@ -0,0 +1,82 @@
+// Generated by tools/icon_compiler.py from icons/*.svg; do not edit.
+
+#include "icon_data.h"
+
+// clear.svg: 9 shapes, 53 bytes
+static const uint8_t ICON_CLEAR_PROGRAM[] = {
+    0x16, 0x00, 0x00, 0x28, 0x36, 0x30, 0x00, 0x40, 0x00, 0x04, 0x36, 0x22,
+    0x22, 0x2d, 0x2d, 0x04, 0x36, 0x00, 0x30, 0x00, 0x40, 0x04, 0x36, 0xde,
+    0x22, 0xd3, 0x2d, 0x04, 0x36, 0xd0, 0x00, 0xc0, 0x00, 0x04, 0x36, 0xde,
+    0xde, 0xd3, 0xd3, 0x04, 0x36, 0x00, 0xd0, 0x00, 0xc0, 0x04, 0x36, 0x22,
+    0xde, 0x2d, 0xd3, 0x04, 0x00,
+};
+
+// clouds.svg: 4 shapes, 18 bytes
+static const uint8_t ICON_CLOUDS_PROGRAM[] = {
+    0x18, 0xec, 0x0a, 0x24, 0x18, 0x1e, 0x0a, 0x1c, 0x18, 0x0a, 0xf0, 0x20,
+    0x58, 0xc8, 0x0a, 0x74, 0x28, 0x00,
+};
+
+// few_clouds.svg: 13 shapes, 70 bytes
+static const uint8_t ICON_FEW_CLOUDS_PROGRAM[] = {
+    0x16, 0x23, 0xe7, 0x16, 0x36, 0x3e, 0xe7, 0x49, 0xe7, 0x03, 0x36, 0x36,
+    0xfa, 0x3e, 0x02, 0x03, 0x36, 0x23, 0x02, 0x23, 0x0d, 0x03, 0x36, 0x10,
+    0xfa, 0x08, 0x02, 0x03, 0x36, 0x08, 0xe7, 0xfd, 0xe7, 0x03, 0x36, 0x10,
+    0xd4, 0x08, 0xcc, 0x03, 0x36, 0x23, 0xcc, 0x23, 0xc1, 0x03, 0x36, 0x36,
+    0xd4, 0x3e, 0xcc, 0x03, 0x18, 0xec, 0x0a, 0x20, 0x18, 0x19, 0x0f, 0x1a,
+    0x18, 0x05, 0xf8, 0x1c, 0x58, 0xcc, 0x0a, 0x68, 0x23, 0x00,
+};
+
+// mist.svg: 5 shapes, 26 bytes
+static const uint8_t ICON_MIST_PROGRAM[] = {
+    0x50, 0xce, 0xe2, 0x65, 0x03, 0x50, 0xce, 0xf1, 0x65, 0x03, 0x50, 0xce,
+    0x00, 0x65, 0x03, 0x50, 0xce, 0x0f, 0x65, 0x03, 0x50, 0xce, 0x1e, 0x65,
+    0x03, 0x00,
+};
+
+// rain.svg: 8 shapes, 42 bytes
+static const uint8_t ICON_RAIN_PROGRAM[] = {
+    0x18, 0xec, 0xec, 0x1c, 0x18, 0x14, 0xec, 0x18, 0x18, 0x00, 0xdc, 0x18,
+    0x58, 0xd0, 0xec, 0x60, 0x1c, 0x33, 0xe4, 0x14, 0xda, 0x32, 0x04, 0x33,
+    0xf8, 0x14, 0xee, 0x32, 0x04, 0x33, 0x0c, 0x14, 0x02, 0x32, 0x04, 0x33,
+    0x20, 0x14, 0x16, 0x32, 0x04, 0x00,
+};
+
+// snow.svg: 16 shapes, 95 bytes
+static const uint8_t ICON_SNOW_PROGRAM[] = {
+    0x33, 0xce, 0x00, 0x32, 0x00, 0x03, 0x33, 0xe7, 0xd5, 0x19, 0x2b, 0x03,
+    0x33, 0x19, 0xd5, 0xe7, 0x2b, 0x03, 0x33, 0x2b, 0xf9, 0x1e, 0x00, 0x02,
+    0x33, 0x1e, 0x00, 0x2b, 0x07, 0x02, 0x33, 0x1c, 0x22, 0x0f, 0x1a, 0x02,
+    0x33, 0x0f, 0x1a, 0x0f, 0x29, 0x02, 0x33, 0xf1, 0x29, 0xf1, 0x1a, 0x02,
+    0x33, 0xf1, 0x1a, 0xe4, 0x22, 0x02, 0x33, 0xd5, 0x07, 0xe2, 0x00, 0x02,
+    0x33, 0xe2, 0x00, 0xd5, 0xf9, 0x02, 0x33, 0xe4, 0xde, 0xf1, 0xe6, 0x02,
+    0x33, 0xf1, 0xe6, 0xf1, 0xd7, 0x02, 0x33, 0x0f, 0xd7, 0x0f, 0xe6, 0x02,
+    0x33, 0x0f, 0xe6, 0x1c, 0xde, 0x02, 0x13, 0x00, 0x00, 0x08, 0x00,
+};
+
+// thunder.svg: 6 shapes, 34 bytes
+static const uint8_t ICON_THUNDER_PROGRAM[] = {
+    0x18, 0xec, 0xec, 0x1c, 0x18, 0x14, 0xec, 0x18, 0x18, 0x00, 0xdc, 0x18,
+    0x58, 0xd0, 0xec, 0x60, 0x1c, 0x45, 0x03, 0xfb, 0x0a, 0x12, 0x0a, 0x08,
+    0x28, 0x45, 0x03, 0x05, 0x20, 0x1c, 0x20, 0xf8, 0x46, 0x00,
+};
+
+// unknown.svg: 9 shapes, 52 bytes
+static const uint8_t ICON_UNKNOWN_PROGRAM[] = {
+    0x20, 0x00, 0x00, 0x3c, 0x02, 0x30, 0xf2, 0xf0, 0xf7, 0xe7, 0x07, 0x30,
+    0xf7, 0xe7, 0x00, 0xe3, 0x07, 0x30, 0x00, 0xe3, 0x09, 0xe7, 0x07, 0x30,
+    0x09, 0xe7, 0x0e, 0xf0, 0x07, 0x30, 0x0e, 0xf0, 0x0a, 0xf9, 0x07, 0x30,
+    0x0a, 0xf9, 0x00, 0x00, 0x07, 0x30, 0x00, 0x00, 0x00, 0x0a, 0x07, 0x10,
+    0x00, 0x18, 0x05, 0x00,
+};
+
+const uint8_t *const ICON_PROGRAMS[ICON_COUNT] = {
+    ICON_CLEAR_PROGRAM,
+    ICON_CLOUDS_PROGRAM,
+    ICON_FEW_CLOUDS_PROGRAM,
+    ICON_MIST_PROGRAM,
+    ICON_RAIN_PROGRAM,
+    ICON_SNOW_PROGRAM,
+    ICON_THUNDER_PROGRAM,
+    ICON_UNKNOWN_PROGRAM,
+};
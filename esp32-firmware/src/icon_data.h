@@ -0,0 +1,23 @@
+// Generated by tools/icon_compiler.py from icons/*.svg; do not edit.
+
+#ifndef ICON_DATA_H
+#define ICON_DATA_H
+
+#include <stdint.h>
+
+enum IconId : uint8_t {
+  ICON_CLEAR,
+  ICON_CLOUDS,
+  ICON_FEW_CLOUDS,
+  ICON_MIST,
+  ICON_RAIN,
+  ICON_SNOW,
+  ICON_THUNDER,
+  ICON_UNKNOWN,
+  ICON_COUNT,
+};
+
+// Bytecode for drawVectorIcon(), indexed by IconId
+extern const uint8_t *const ICON_PROGRAMS[ICON_COUNT];
+
+#endif
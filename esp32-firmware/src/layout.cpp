@@ -0,0 +1,272 @@
+#include "layout.h"
+
+#include "font.h"
+#include <stdio.h>
+#include <string.h>
+#include <u8g2_fonts.h>
+
+// Draw the weather icons from the compiled vector icons instead of the
+// procedural ones. Off until the device bench shows the rasterizer is
+// faster: on the host it is slower at both sizes (see bench/README.md).
+#ifndef VECTOR_ICONS
+#define VECTOR_ICONS 0
+#endif
+
+#if VECTOR_ICONS
+#include "vector_icon.h"
+#else
+#include "weather_icons.h"
+#endif
+
+// Draws text horizontally centered on cx
+static void drawCentered(FrameBuffer &fb, const uint8_t *font, int cx, int y,
+                         const char *text) {
+  int w = textWidth(font, text);
+  drawText(fb, font, cx - w / 2, y, text, INK_BLACK);
+}
+
+#if VECTOR_ICONS
+// Icon sizes in pixels: the weather icon and the forecast boxes' icons
+#define ICON_SIZE 128
+#define SMALL_ICON_SIZE 48
+
+static bool startsWith(const char *s, const char *prefix) {
+  return strncmp(s, prefix, strlen(prefix)) == 0;
+}
+
+static void lowerCopy(char *dst, size_t size, const char *src) {
+  size_t i = 0;
+  for (; i + 1 < size && src[i]; i++) {
+    char c = src[i];
+    dst[i] = (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+  }
+  dst[i] = '\0';
+}
+
+// Icon for a forecast's condition text
+static IconId conditionIcon(const char *conditionText) {
+  char condition[sizeof(ForecastModel::condition)];
+  lowerCopy(condition, sizeof(condition), conditionText);
+  if (strstr(condition, "clear") || strstr(condition, "sun")) {
+    return ICON_CLEAR;
+  }
+  if (strstr(condition, "cloud")) {
+    return ICON_CLOUDS;
+  }
+  if (strstr(condition, "rain") || strstr(condition, "drizzle")) {
+    return ICON_RAIN;
+  }
+  if (strstr(condition, "snow")) {
+    return ICON_SNOW;
+  }
+  if (strstr(condition, "thunder") || strstr(condition, "storm")) {
+    return ICON_THUNDER;
+  }
+  if (strstr(condition, "mist") || strstr(condition, "fog") ||
+      strstr(condition, "haze")) {
+    return ICON_MIST;
+  }
+  return ICON_UNKNOWN;
+}
+
+// Icon for an OpenWeatherMap icon code (01d, 10n, ...)
+static IconId weatherIcon(const char *iconCode) {
+  static const struct {
+    char code[3];
+    IconId icon;
+  } codes[] = {
+      {"01", ICON_CLEAR},   {"02", ICON_FEW_CLOUDS}, {"03", ICON_CLOUDS},
+      {"04", ICON_CLOUDS},  {"09", ICON_RAIN},       {"10", ICON_RAIN},
+      {"11", ICON_THUNDER}, {"13", ICON_SNOW},       {"50", ICON_MIST},
+  };
+  for (const auto &c : codes) {
+    if (startsWith(iconCode, c.code)) {
+      return c.icon;
+    }
+  }
+  return ICON_UNKNOWN;
+}
+#endif
+
+// ========== LEFT SIDE: Prayer Times (Google Material Design) ==========
+static const int sectionX = 30;
+static const int sectionWidth = 340;
+static const int startY = 35;
+
+static void drawHeader(FrameBuffer &fb, const RenderModel &model) {
+  // Header with large title (light weight for Google style)
+  drawText(fb, u8g2_font_helvR24_tf, sectionX, startY + 28, "Prayer Times",
+           INK_BLACK);
+
+  // Location - subtle, below title
+  if (model.location[0] != '\0') {
+    drawText(fb, u8g2_font_helvR12_tf, sectionX, startY + 48, model.location,
+             INK_BLACK);
+  }
+}
+
+static void drawPrayerList(FrameBuffer &fb, const RenderModel &model) {
+  // Prayer list - Material Design style (no borders, divider lines)
+  int listStartY = startY + 75;
+  int rowHeight = 60;
+
+  // Prayer data
+  const char *prayerNames[] = {"Fajr", "Sunrise", "Dhuhr",
+                               "Asr",  "Maghrib", "Isha"};
+
+  for (int i = 0; i < 6; i++) {
+    int rowY = listStartY + i * rowHeight;
+    int rowCenterY =
+        rowY + rowHeight / 2 -
+        4; // Vertical center of row (-4 to account for divider offset)
+
+    // Divider line above each item (except first)
+    if (i > 0) {
+      fb.drawLine(sectionX, rowY - 8, sectionX + sectionWidth, rowY - 8,
+                  INK_BLACK);
+    }
+
+    // Accent bar left of the next prayer
+    if (i == model.highlight) {
+      fb.fillRoundRect(sectionX - 16, rowCenterY - 16, 6, 30, 3, INK_ORANGE);
+    }
+
+    // Prayer name - regular weight, left aligned, vertically centered
+    drawText(fb, u8g2_font_helvR18_tf, sectionX, rowCenterY + 7,
+             prayerNames[i], INK_BLACK);
+
+    // Time - large, bold, right aligned, vertically centered
+    int timeWidth = textWidth(u8g2_font_helvB24_tf, model.prayers[i]);
+    drawText(fb, u8g2_font_helvB24_tf, sectionX + sectionWidth - timeWidth,
+             rowCenterY + 10, model.prayers[i], INK_BLACK);
+  }
+}
+
+// ========== RIGHT SIDE: Weather ==========
+static const int weatherStartY = 50;
+// Weather section spans from divider to right edge: 390 to 800 = 410px
+// Center point at 390 + 410/2 = 595
+static const int weatherCenterX = 595;
+
+static void drawTemperature(FrameBuffer &fb, const RenderModel &model) {
+  // Temperature - large and bold, centered below icon
+  char tempStr[12];
+  snprintf(tempStr, sizeof(tempStr), "%d C", model.temperature);
+  int textW = textWidth(u8g2_font_helvB24_tf, tempStr);
+  drawText(fb, u8g2_font_helvB24_tf, weatherCenterX - textW / 2,
+           weatherStartY + 145, tempStr, INK_BLACK);
+  // Degree symbol
+  fb.drawCircle(weatherCenterX - textW / 2 + 58, weatherStartY + 117, 5,
+                INK_BLACK);
+}
+
+static void drawCondition(FrameBuffer &fb, const RenderModel &model) {
+  // Condition - centered below temperature
+  drawCentered(fb, u8g2_font_helvR14_tf, weatherCenterX, weatherStartY + 175,
+               model.condition);
+}
+
+// ========== 3-DAY FORECAST ==========
+static void drawForecastBox(FrameBuffer &fb, const RenderModel &model, int i) {
+  int forecastY = weatherStartY + 200;
+  int boxWidth = 115;
+  int boxHeight = 130;
+  int boxSpacing = 8;
+  int totalWidth = 3 * boxWidth + 2 * boxSpacing;
+  int startX = weatherCenterX - totalWidth / 2; // Center the 3 boxes
+
+  const ForecastModel &day = model.forecast[i];
+  int boxX = startX + i * (boxWidth + boxSpacing);
+  int boxCenterX = boxX + boxWidth / 2;
+
+  // Simple rounded rectangle with consistent 2px border
+  int r = 10; // Corner radius
+  fb.drawRoundRect(boxX, forecastY, boxWidth, boxHeight, r, INK_BLACK);
+  fb.drawRoundRect(boxX + 1, forecastY + 1, boxWidth - 2, boxHeight - 2, r - 1,
+                   INK_BLACK);
+
+  // Day name at top (bold, centered) - format DD.MM
+  char dayLabel[6] = "";
+  if (strlen(day.date) >= 10) {
+    // Convert from YYYY-MM-DD to DD.MM
+    snprintf(dayLabel, sizeof(dayLabel), "%.2s.%.2s", day.date + 8,
+             day.date + 5);
+  }
+  drawCentered(fb, u8g2_font_helvB18_tf, boxCenterX, forecastY + 26,
+               dayLabel);
+
+  // Weather icon in the middle (larger)
+#if VECTOR_ICONS
+  drawIcon(fb, conditionIcon(day.condition), boxCenterX, forecastY + 65,
+           SMALL_ICON_SIZE);
+#else
+  drawSmallWeatherIcon(fb, boxCenterX, forecastY + 65, day.condition);
+#endif
+
+  // High / Low temps at bottom - larger font
+  char temps[16];
+  snprintf(temps, sizeof(temps), "%d / %d", day.high, day.low);
+  drawCentered(fb, u8g2_font_helvB18_tf, boxCenterX, forecastY + 118, temps);
+}
+
+void renderBackground(FrameBuffer &fb) {
+  fb.fill(INK_WHITE);
+  // Vertical divider line - subtle, not part of any widget
+  fb.drawLine(385, startY + 20, 385, 450, INK_BLACK);
+}
+
+void renderWidgets(FrameBuffer &fb, const RenderModel &model,
+                   uint8_t widgets) {
+  bool full = widgets == WIDGET_ALL;
+  if (full) {
+    renderBackground(fb);
+  }
+  // Cull widgets outside the frame buffer's band (see band_render.h)
+  for (uint8_t i = 0; i < WIDGET_COUNT; i++) {
+    const WidgetRect &r = widgetRect(i);
+    if (!fb.rowsVisible(r.y, r.h)) {
+      widgets &= ~(1 << i);
+    }
+  }
+  if (!full) {
+    for (uint8_t i = 0; i < WIDGET_COUNT; i++) {
+      if (widgets & (1 << i)) {
+        const WidgetRect &r = widgetRect(i);
+        fb.fillRect(r.x, r.y, r.w, r.h, INK_WHITE);
+      }
+    }
+  }
+
+  if (widgets & WIDGET_HEADER) {
+    drawHeader(fb, model);
+  }
+  if (widgets & WIDGET_PRAYERS) {
+    drawPrayerList(fb, model);
+  }
+  if (widgets & WIDGET_ICON) {
+    // Weather icon (centered at top)
+#if VECTOR_ICONS
+    drawIcon(fb, weatherIcon(model.icon), weatherCenterX, weatherStartY + 60,
+             ICON_SIZE);
+#else
+    drawWeatherIcon(fb, weatherCenterX, weatherStartY + 60, model.icon);
+#endif
+  }
+  if (widgets & WIDGET_TEMPERATURE) {
+    drawTemperature(fb, model);
+  }
+  if (widgets & WIDGET_CONDITION) {
+    drawCondition(fb, model);
+  }
+  for (int i = 0; i < 3; i++) {
+    if (widgets & (WIDGET_FORECAST_0 << i)) {
+      drawForecastBox(fb, model, i);
+    }
+  }
+}
+
+void renderMessage(FrameBuffer &fb, const char *title, const char *message) {
+  fb.fill(INK_WHITE);
+  drawText(fb, u8g2_font_helvB24_tf, 60, 200, title, INK_BLACK);
+  drawText(fb, u8g2_font_helvR18_tf, 60, 260, message, INK_BLACK);
+}
@@ -0,0 +1,24 @@
+/*
+ * Screen layout: draws a RenderModel into a frame buffer
+ *
+ * Shared by the firmware and host tools. Widget positions must stay inside
+ * the rects in render_model.cpp so partial redraws stay clean.
+ */
+
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include "framebuffer.h"
+#include "render_model.h"
+
+// Clear and redraw the widgets in the mask; WIDGET_ALL redraws the screen
+void renderWidgets(FrameBuffer &fb, const RenderModel &model, uint8_t widgets);
+
+// Everything outside the widgets; a frame drawn widget by widget starts
+// from this
+void renderBackground(FrameBuffer &fb);
+
+// Full-screen title and message, used for errors
+void renderMessage(FrameBuffer &fb, const char *title, const char *message);
+
+#endif
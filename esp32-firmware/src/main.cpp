@@ -3,44 +3,164 @@
  * Fetches data from GitHub and displays on e-ink
  *
  * WiFi credentials stored in secrets.h (gitignored)
- * Font: Open Sans (similar to Jost) via U8g2_for_Adafruit_GFX
+ * Fonts: u8g2 Helvetica data from U8g2_for_Adafruit_GFX, drawn by font.cpp
  */
 
+#include "band_render.h"
+#include "frame_store.h"
+#include "framebuffer.h"
+#include "http_date.h"
+#include "layout.h"
+#include "mqtt_fetch.h"
+#include "network_store.h"
+#include "payload_stream.h"
 #include "pins.h"
+#include "profiler.h"
+#include "provision_store.h"
+#include "refresh_policy.h"
+#include "render_model.h"
+#include "schedule.h"
 #include "secrets.h" // Contains WIFI_SSID and WIFI_PASSWORD (gitignored)
+#include "state_store.h"
+#include "sync_fetch.h"
+#include "telemetry.h"
+#include "trace_store.h"
+#include "wake_phases.h"
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <GxEPD2_7C.h>
 #include <HTTPClient.h>
-#include <U8g2_for_Adafruit_GFX.h>
+#include <LittleFS.h>
 #include <WiFi.h>
 #include <WiFiClientSecure.h>
+#include <sys/time.h>
 #include <time.h>
 
 // ============================================
 // CONFIGURATION
 // ============================================
 // GitHub raw URL for your JSON data
+#ifdef DATA_URL_OVERRIDE
+// e.g. tools/standin_server.py on the LAN
+const char *DATA_URL = DATA_URL_OVERRIDE;
+#else
 const char *DATA_URL =
     "https://raw.githubusercontent.com/Amkobano/e-ink-display-module/main/"
     "data-collection/output/display_data.json";
+#endif
+
+#ifdef DATA_URL_PLAIN
+// tools/lan_gateway serves the same paths over plain HTTP: no TLS handshake
+typedef WiFiClient DataClient;
+#else
+typedef WiFiClientSecure DataClient;
+#endif
 
 // Wake time: 3 AM local time
 #define WAKE_HOUR 0
 #define WAKE_MINUTE 10
 
+// Also wake at each prayer time to move the next-prayer highlight
+#define HIGHLIGHT_NEXT_PRAYER 1
+// Render the next highlight frame before sleeping, so that wake only has to
+// stream it to the panel
+#define PRERENDER_NEXT_FRAME 1
+// How far the clock may be off the planned wake for the pre-render to count
+#define PRERENDER_TOLERANCE_SEC 600
+// Failed fetches in a row that keep the last frame on the panel while
+// retrying (schedule.h); the next one shows the error screen
+#define FAILURES_BEFORE_ERROR 8
+// Run the panel refresh (~30 s BUSY) in its own task, so the rest of the
+// wake (storing the frame, planning, pre-rendering the next frame, the
+// telemetry upload) runs meanwhile; 0 waits for it first, to compare
+#define OVERLAP_REFRESH 1
+// Refresh only for changes worth it (see refresh_policy.h): the location,
+// prayer times, highlight and weather icon always, the temperature once it
+// is REFRESH_TEMPERATURE_BAND degrees off the panel, a forecast box once it
+// shows another day. Anything else waits for the next refresh, at most
+// REFRESH_MAX_STALE_MIN; 0 refreshes for every change
+#define COALESCE_REFRESH 1
+#define REFRESH_ALWAYS (WIDGET_HEADER | WIDGET_PRAYERS | WIDGET_ICON)
+#define REFRESH_TEMPERATURE_BAND 2
+#define REFRESH_MAX_STALE_MIN 360
+
+// Known networks are tried best-scored first, at most this many per wake
+#define WIFI_MAX_ATTEMPTS 3
+#define WIFI_FIRST_TIMEOUT_MS 10000
+#define WIFI_FALLBACK_TIMEOUT_MS 6000
+#define CONNECT_TIMEOUT_MS 5000
+
+// Parse and draw each payload section while the rest downloads; set to 0 to
+// compare against download, parse, draw in sequence (see Wake-to-refresh)
+#define PIPELINE_RENDER 1
+#define PIPELINE_RENDER_CORE 0 // the download runs on core 1 (loopTask)
+#define PIPELINE_STALL_MS 15000
+
+// Build with -DMQTT_BROKER=\"192.168.1.10\" to take the payload from the
+// retained messages the aggregator publishes on a LAN broker instead of
+// HTTPS (see mqtt_fetch.h). The topic is the aggregator's MQTT_TOPIC. The
+// payload arrives as one message, so there is nothing to pipeline.
+#define MQTT_PORT 1883
+#define MQTT_TOPIC "eink/my-city"
+#ifdef MQTT_BROKER
+#undef PIPELINE_RENDER
+#define PIPELINE_RENDER 0
+#endif
+
+// Build with -DSYNC_SERVER=\"192.168.1.10\" to get the render model from
+// tools/sync_server in a few UDP datagrams instead (see udp_sync.h): no
+// HTTPS, JSON or NTP, and the radio is off again right after the exchange
+#ifdef SYNC_SERVER
+#undef PIPELINE_RENDER
+#define PIPELINE_RENDER 0
+#endif
+
+// Build with -DPANEL_BAND_ROWS=N for panels whose frame doesn't fit in RAM:
+// the frame buffer then holds N rows, and every refresh renders the screen
+// band by band and streams each band to the panel (see band_render.h).
+// Without a whole frame nothing can be stored or patched, so pre-rendered,
+// pipelined and partial redraws and coalescing are off.
+#ifdef PANEL_BAND_ROWS
+#undef PRERENDER_NEXT_FRAME
+#define PRERENDER_NEXT_FRAME 0
+#undef PIPELINE_RENDER
+#define PIPELINE_RENDER 0
+#undef COALESCE_REFRESH
+#define COALESCE_REFRESH 0
+#endif
+
+// Run at 80 MHz while waiting on WiFi, HTTP bytes and the panel, and at
+// 240 MHz for TLS, parsing, rendering and compression (see wake_phases.h)
+#define CPU_FREQUENCY_SCALING 1
+
+// Build with -DWAKE_TRACE to record every wake in flash (see trace_store.h)
+// The profile environment (-DWAKE_PROFILE) samples where the wake's CPU
+// time goes and prints the samples before sleeping (see profiler.h)
+
 // Timezone: Germany (CET/CEST with automatic DST)
 const char *NTP_SERVER = "pool.ntp.org";
 const long GMT_OFFSET_SEC = 3600;     // UTC+1 for CET
 const int DAYLIGHT_OFFSET_SEC = 3600; // +1 hour for CEST (summer)
 // ============================================
 
-// Display: Waveshare 7.3" 7-color (GDEY073D46), 800x480 pixels
-GxEPD2_7C<GxEPD2_730c_GDEY073D46, GxEPD2_730c_GDEY073D46::HEIGHT>
+// Display: Waveshare 7.3" 7-color (GDEY073D46), 800x480 pixels. Provisioning
+// images name the panel they were built for; see loadProvision().
+#define PANEL_NAME "GDEY073D46"
+// Frames are rendered into our own buffer below and written natively, so the
+// library's paged buffer only needs a few rows.
+GxEPD2_7C<GxEPD2_730c_GDEY073D46, GxEPD2_730c_GDEY073D46::HEIGHT / 8>
     display(GxEPD2_730c_GDEY073D46(EPD_CS, EPD_DC, EPD_RST, EPD_BUSY));
 
-// U8g2 fonts for Adafruit GFX - provides clean modern fonts like Open Sans
-U8G2_FOR_ADAFRUIT_GFX u8g2Fonts;
+// Full-screen frame buffer in native 4bpp format, or one band of it
+#define SCREEN_WIDTH GxEPD2_730c_GDEY073D46::WIDTH
+#define SCREEN_HEIGHT GxEPD2_730c_GDEY073D46::HEIGHT
+#ifdef PANEL_BAND_ROWS
+static uint8_t frameData[SCREEN_WIDTH / 2 * PANEL_BAND_ROWS];
+FrameBuffer frame(frameData, SCREEN_WIDTH, SCREEN_HEIGHT, PANEL_BAND_ROWS);
+#else
+static uint8_t frameData[SCREEN_WIDTH / 2 * SCREEN_HEIGHT];
+FrameBuffer frame(frameData, SCREEN_WIDTH, SCREEN_HEIGHT);
+#endif
 
 // Prayer times storage
 struct PrayerTimes {
@@ -72,48 +192,250 @@ ForecastDay forecast[3];
 
 String errorMsg = "";
 
+// Model of the stored frame: the one on the panel, or the one the next
+// refresh shows while a coalesced change is pending
+RenderModel shownModel;
+bool haveShownModel = false;
+
+// Schedule, network stats and counters; loaded at boot, saved once
+// before sleeping (see state_store.h)
+DeviceState deviceState;
+
+#ifdef WAKE_TRACE
+WakeTrace wakeTrace;
+#define TRACE(type, a, b) traceEvent(wakeTrace, millis(), type, a, b)
+#else
+// Arguments are type-checked but never evaluated
+#define TRACE(type, a, b)                                                      \
+  do {                                                                         \
+    if (false) {                                                               \
+      (void)(a);                                                               \
+      (void)(b);                                                               \
+    }                                                                          \
+  } while (0)
+#endif
+
+#ifdef QEMU_BUILD
+// Espressif QEMU has no WiFi radio and no panel. The payload is read from
+// LittleFS (tools/qemu_run.sh puts it there), the clock is set to a fixed
+// time and frames go to a byte sink. The wake ends with the phase report
+// instead of deep sleep.
+#define QEMU_PAYLOAD_FILE "/display_data.json"
+#define QEMU_EPOCH 1772362800 // 2026-03-01 12:00 CET
+#define QEMU_TZ "CET-1CEST,M3.5.0,M10.5.0/3"
+
+bool qemuLoadPayload(String &payload) {
+  File f = LittleFS.open(QEMU_PAYLOAD_FILE, "r");
+  if (!f) {
+    errorMsg = "No " QEMU_PAYLOAD_FILE;
+    return false;
+  }
+  payload = f.readString();
+  f.close();
+  return true;
+}
+
+void qemuSetClock() {
+  setenv("TZ", QEMU_TZ, 1);
+  tzset();
+  struct timeval tv = {QEMU_EPOCH, 0};
+  settimeofday(&tv, nullptr);
+}
+
+// Stands in for the SPI data phase of writeNative(): one write per byte
+static volatile uint8_t qemuSpiData;
+void qemuPanelSink(const uint8_t *data, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    qemuSpiData = data[i];
+  }
+  Serial.printf("QEMU panel: %u bytes\n", (unsigned)len);
+}
+#endif
+
+void syncTime();
+void restoreTimeZone();
+// Set this wake, from NTP, an HTTP Date header or the sync server
+bool clockSynced = false;
+
+// This device's part of a fleet, from the "provision" partition
+ProvisionConfig provision;
+bool provisioned = false;
+
+// Known WiFi networks, loaded from NVS by connectWiFi()
+NetworkEntry networks[MAX_NETWORKS];
+uint8_t networkCount = 0;
+int8_t activeNetwork = -1;
+// Radio on, for net_ms in the telemetry
+unsigned long netStart;
+
 bool connectWiFi() {
-  Serial.print("Connecting to WiFi");
+  phaseBegin(PHASE_CONNECT);
+  netStart = millis();
+#ifdef QEMU_BUILD
+  Serial.println("QEMU: no WiFi, using the stored payload");
+  return true;
+#endif
+  networkCount =
+      loadNetworks(networks, provisioned ? &provision : nullptr,
+                   provisionTag(), deviceState.durable.networkStats);
+  for (uint8_t i = 0; i < networkCount; i++) {
+    networks[i].stats = deviceState.durable.networkStats[i];
+  }
+  uint8_t order[MAX_NETWORKS];
+  rankNetworks(networks, networkCount, order);
   WiFi.mode(WIFI_STA);
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
 
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 40) {
-    delay(500);
-    Serial.print(".");
-    attempts++;
-  }
+  for (uint8_t k = 0; k < networkCount && k < WIFI_MAX_ATTEMPTS; k++) {
+    NetworkEntry &n = networks[order[k]];
+    int16_t score = networkScore(n.stats);
+    Serial.printf("Connecting to %s (score %d)", n.ssid, score);
+    unsigned long timeout =
+        k == 0 ? WIFI_FIRST_TIMEOUT_MS : WIFI_FALLBACK_TIMEOUT_MS;
+    unsigned long start = millis();
+    WiFi.begin(n.ssid, n.password);
+    for (int polls = 1;
+         WiFi.status() != WL_CONNECTED && millis() - start < timeout;
+         polls++) {
+      delay(50); // fine enough to time the association
+      if (polls % 10 == 0) {
+        Serial.print(".");
+      }
+    }
 
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println(" Connected!");
-    Serial.print("IP: ");
-    Serial.println(WiFi.localIP());
-    return true;
+    if (WiFi.status() == WL_CONNECTED) {
+      uint16_t assocMs = millis() - start;
+      Serial.println(" Connected!");
+      Serial.print("IP: ");
+      Serial.println(WiFi.localIP());
+      recordAssociation(n.stats, WiFi.RSSI(), assocMs);
+      TRACE(TRACE_WIFI_OK, WiFi.RSSI(), assocMs);
+      activeNetwork = order[k];
+      modelSetString(telemetry.ap, sizeof(telemetry.ap), n.ssid);
+      telemetry.apScore = score;
+      telemetry.rssi = WiFi.RSSI();
+      telemetry.assocMs = assocMs;
+      return true;
+    }
+
+    Serial.println(" FAILED!");
+    recordFailure(n.stats);
+    TRACE(TRACE_WIFI_FAIL, WiFi.status(), millis() - start);
+    WiFi.disconnect(true);
   }
 
-  Serial.println(" FAILED!");
   errorMsg = "WiFi failed";
   return false;
 }
 
-bool fetchPrayerTimes() {
+// Host name and port of DATA_URL; false if the name doesn't fit
+bool dataHost(char *name, size_t size, uint16_t &port) {
+  const char *host = strstr(DATA_URL, "://");
+  host = host ? host + 3 : DATA_URL;
+  size_t len = strcspn(host, ":/");
+  if (len >= size) {
+    return false;
+  }
+  memcpy(name, host, len);
+  name[len] = '\0';
+#ifdef DATA_URL_PLAIN
+  port = host[len] == ':' ? atoi(host + len + 1) : 80;
+#else
+  port = host[len] == ':' ? atoi(host + len + 1) : 443;
+#endif
+  return true;
+}
+
+// Sets the clock from a response's Date header; false if there was none,
+// or on the first wake, where NTP also sets the time zone
+bool setClockFromHttpDate(const String &value, unsigned long roundTripMs) {
+  int64_t date = parseHttpDate(value.c_str());
+  if (date < 0 || deviceState.rtc.timeZone[0] == '\0') {
+    return false;
+  }
+  struct timeval before;
+  gettimeofday(&before, nullptr);
+  int64_t ms = httpDateClockMs(date, roundTripMs);
+  struct timeval tv = {(time_t)(ms / 1000), (suseconds_t)(ms % 1000 * 1000)};
+  settimeofday(&tv, nullptr);
+  restoreTimeZone();
+  clockSynced = true;
+  // How far the RTC drifted since the last sync
+  long long offMs =
+      (long long)before.tv_sec * 1000 + before.tv_usec / 1000 - ms;
+  Serial.printf("Clock set from HTTP Date (round trip %lu ms), was %+lld ms "
+                "off\n",
+                roundTripMs, offMs);
+  TRACE(TRACE_TIME_SYNC, 1, (uint32_t)tv.tv_sec);
+  return true;
+}
+
+#ifdef WAKE_TRACE
+// Resolve the data host up front so the trace separates DNS from TLS/HTTP;
+// HTTPClient then hits the lwIP cache
+void traceDns() {
+  char name[64];
+  uint16_t port;
+  if (!dataHost(name, sizeof(name), port)) {
+    return;
+  }
+  IPAddress ip;
+  unsigned long start = millis();
+  bool ok = WiFi.hostByName(name, ip) == 1;
+  TRACE(TRACE_DNS, ok, millis() - start);
+}
+#endif
+
+// Sends the request; on 200 the body is ready to read from http
+bool requestPayload(HTTPClient &http, DataClient &client,
+                    unsigned long &fetchStart) {
   Serial.println("Fetching JSON from GitHub Raw...");
+  phaseBegin(PHASE_FETCH);
 
-  // Sync time first to get a valid timestamp for cache busting
-  syncTime();
+  // Build cache-busting URL: DATA_URL + "?t=" + timestamp. The RTC keeps
+  // the time from the last wake; a cold boot only gets it from the
+  // response, so any value that changes will do until then.
   time_t now = time(nullptr);
-
-  // Build cache-busting URL: DATA_URL + "?t=" + timestamp
-  String urlWithCacheBuster = String(DATA_URL) + "?t=" + String(now);
+  String urlWithCacheBuster =
+      String(DATA_URL) + "?t=" +
+      String(now >= 1000000000 ? (uint32_t)now : esp_random());
   Serial.println("URL: " + urlWithCacheBuster);
 
-  WiFiClientSecure client;
+#ifndef DATA_URL_PLAIN
   client.setInsecure(); // Skip certificate verification (OK for public content)
-
-  HTTPClient http;
-  http.setTimeout(15000); // 15 second timeout
+#endif
+
+#ifdef WAKE_TRACE
+  traceDns();
+#endif
+
+  // Connect (and for HTTPS, handshake) first, which HTTPClient then
+  // reuses, so the request's round trip can be timed on its own for the
+  // Date header. If this fails, GET() tries again and reports the error.
+  fetchStart = millis();
+  char host[64];
+  uint16_t port;
+  if (dataHost(host, sizeof(host), port)) {
+    client.connect(host, port, CONNECT_TIMEOUT_MS);
+  }
   http.begin(client, urlWithCacheBuster);
+  http.setTimeout(15000); // 15 second timeout
+  const char *headers[] = {"Date"};
+  http.collectHeaders(headers, 1);
+  unsigned long requestStart = millis();
   int httpCode = http.GET();
+  unsigned long roundTripMs = millis() - requestStart;
+  TRACE(TRACE_HTTP, httpCode, millis() - fetchStart);
+  if (httpCode > 0 && !setClockFromHttpDate(http.header("Date"), roundTripMs)) {
+    phaseBegin(PHASE_CONNECT);
+    syncTime(); // first wake, or a server without Date
+    phaseBegin(PHASE_FETCH);
+  }
+#if defined(WAKE_TRACE) && !defined(DATA_URL_PLAIN)
+  if (httpCode < 0) {
+    char tlsError[64];
+    TRACE(TRACE_TLS, client.lastError(tlsError, sizeof(tlsError)), 0);
+  }
+#endif
 
   if (httpCode != HTTP_CODE_OK) {
     Serial.print("HTTP error: ");
@@ -122,23 +444,90 @@ bool fetchPrayerTimes() {
     http.end();
     return false;
   }
+  return true;
+}
 
-  String payload = http.getString();
-  http.end();
+void recordTransfer(size_t bytes, uint32_t hash, unsigned long fetchStart) {
+  // Includes the TLS handshake, so this is what a wake actually gets
+  unsigned long fetchMs = millis() - fetchStart;
+  telemetry.netMs = millis() - netStart;
+  TRACE(TRACE_BODY, bytes, hash);
+  if (activeNetwork >= 0 && fetchMs > 0) {
+    uint32_t kbps = bytes * 8UL / fetchMs;
+    telemetry.kbps = kbps > 0xFFFF ? 0xFFFF : kbps;
+    recordThroughput(networks[activeNetwork].stats, telemetry.kbps);
+  }
+}
 
-  Serial.println("Parsing JSON...");
-  JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, payload);
+#ifdef MQTT_BROKER
+bool showHighlightFromLastFrame();
+void goToSleep();
 
-  if (error) {
-    Serial.print("JSON error: ");
-    Serial.println(error.c_str());
-    errorMsg = "JSON error";
+// Version of the payload just fetched; it becomes the panel's payload
+// version only once the payload was parsed and displayed, so a malformed
+// one is fetched and fails again instead of counting as unchanged
+uint32_t fetchedPayloadVersion = 0;
+
+// When the broker's payload version is the one on the panel, the last
+// frame is kept (moving only the highlight) and the wake ends here
+bool downloadPayloadMqtt(String &payload) {
+  syncTime();
+  phaseBegin(PHASE_FETCH);
+  Serial.printf("Fetching mqtt://%s:%d/%s\n", MQTT_BROKER, MQTT_PORT,
+                MQTT_TOPIC);
+  unsigned long fetchStart = millis();
+  MqttResult result = mqttFetch(MQTT_BROKER, MQTT_PORT, MQTT_TOPIC,
+                                deviceState.rtc.payloadVersion, payload);
+  if (result == MQTT_UNCHANGED) {
+    telemetry.netMs = millis() - netStart;
+    Serial.printf("Payload version %08x unchanged\n",
+                  deviceState.rtc.payloadVersion);
+    if (showHighlightFromLastFrame()) {
+      deviceState.rtc.fetchFailures = 0;
+      goToSleep();
+    }
+    result = mqttFetch(MQTT_BROKER, MQTT_PORT, MQTT_TOPIC, 0, payload);
+  }
+  // Recorded as HTTP 200 or no response, so wake_sim replays it the same
+  TRACE(TRACE_HTTP, result == MQTT_PAYLOAD ? HTTP_CODE_OK : 0,
+        millis() - fetchStart);
+  if (result != MQTT_PAYLOAD) {
+    errorMsg = "MQTT failed";
     return false;
   }
+  uint32_t hash = traceHash(payload.c_str(), payload.length());
+  recordTransfer(payload.length(), hash, fetchStart);
+  fetchedPayloadVersion = hash;
+  return true;
+}
+#endif
 
-  // Extract all prayer times
-  JsonObject times = doc["prayer_times"];
+bool downloadPayload(String &payload) {
+#ifdef QEMU_BUILD
+  syncTime();
+  phaseBegin(PHASE_FETCH);
+  return qemuLoadPayload(payload);
+#endif
+#ifdef MQTT_BROKER
+  return downloadPayloadMqtt(payload);
+#endif
+  DataClient client;
+  HTTPClient http;
+  unsigned long fetchStart;
+  if (!requestPayload(http, client, fetchStart)) {
+    return false;
+  }
+
+  phaseBegin(PHASE_TRANSFER);
+  payload = http.getString();
+  http.end();
+  recordTransfer(payload.length(),
+                 traceHash(payload.c_str(), payload.length()), fetchStart);
+  return true;
+}
+
+// Payload sections, shared by the whole-body and the streaming parse
+bool applyPrayerTimes(JsonObject times) {
   if (times.isNull()) {
     errorMsg = "No prayer_times";
     return false;
@@ -150,7 +539,6 @@ bool fetchPrayerTimes() {
   prayerTimes.asr = times["asr"] | "N/A";
   prayerTimes.maghrib = times["maghrib"] | "N/A";
   prayerTimes.isha = times["isha"] | "N/A";
-  prayerTimes.location = doc["location"] | "";
 
   Serial.println("Prayer times loaded:");
   Serial.println("  Fajr:    " + prayerTimes.fajr);
@@ -159,448 +547,802 @@ bool fetchPrayerTimes() {
   Serial.println("  Asr:     " + prayerTimes.asr);
   Serial.println("  Maghrib: " + prayerTimes.maghrib);
   Serial.println("  Isha:    " + prayerTimes.isha);
+  return true;
+}
 
+void applyWeather(JsonObject weather) {
+  if (weather.isNull()) {
+    return;
+  }
   // Extract weather data (now nested under "current")
-  JsonObject weather = doc["weather"];
-  if (!weather.isNull()) {
-    JsonObject current = weather["current"];
-    if (!current.isNull()) {
-      weatherData.temperature = current["temperature"] | 0;
-      weatherData.condition = current["condition"] | "N/A";
-      weatherData.windSpeed = current["wind_speed"] | 0.0f;
-      weatherData.icon = current["icon"] | "";
-
-      Serial.println("Weather loaded:");
-      Serial.println("  Temp:      " + String(weatherData.temperature) + "°C");
-      Serial.println("  Condition: " + weatherData.condition);
-      Serial.println("  Wind:      " + String(weatherData.windSpeed) + " m/s");
-      Serial.println("  Icon:      " + weatherData.icon);
-    }
+  JsonObject current = weather["current"];
+  if (!current.isNull()) {
+    weatherData.temperature = current["temperature"] | 0;
+    weatherData.condition = current["condition"] | "N/A";
+    weatherData.windSpeed = current["wind_speed"] | 0.0f;
+    weatherData.icon = current["icon"] | "";
+
+    Serial.println("Weather loaded:");
+    Serial.println("  Temp:      " + String(weatherData.temperature) + "°C");
+    Serial.println("  Condition: " + weatherData.condition);
+    Serial.println("  Wind:      " + String(weatherData.windSpeed) + " m/s");
+    Serial.println("  Icon:      " + weatherData.icon);
+  }
 
-    // Extract 3-day forecast
-    JsonArray forecastArray = weather["forecast"];
-    if (!forecastArray.isNull()) {
-      Serial.println("Forecast loaded:");
-      for (int i = 0; i < 3 && i < forecastArray.size(); i++) {
-        JsonObject day = forecastArray[i];
-        forecast[i].date = day["date"] | "";
-        forecast[i].high = day["high"] | 0;
-        forecast[i].low = day["low"] | 0;
-        forecast[i].condition = day["condition"] | "";
-
-        Serial.println("  " + forecast[i].date + ": " +
-                       String(forecast[i].high) + "/" +
-                       String(forecast[i].low) + "°C " + forecast[i].condition);
-      }
+  // Extract 3-day forecast
+  JsonArray forecastArray = weather["forecast"];
+  if (!forecastArray.isNull()) {
+    Serial.println("Forecast loaded:");
+    for (int i = 0; i < 3 && i < forecastArray.size(); i++) {
+      JsonObject day = forecastArray[i];
+      forecast[i].date = day["date"] | "";
+      forecast[i].high = day["high"] | 0;
+      forecast[i].low = day["low"] | 0;
+      forecast[i].condition = day["condition"] | "";
+
+      Serial.println("  " + forecast[i].date + ": " +
+                     String(forecast[i].high) + "/" +
+                     String(forecast[i].low) + "°C " + forecast[i].condition);
     }
   }
+}
+
+bool fetchPrayerTimes() {
+  String payload;
+  if (!downloadPayload(payload)) {
+    return false;
+  }
+
+  phaseBegin(PHASE_PARSE);
+  Serial.println("Parsing JSON...");
+  JsonDocument doc;
+  DeserializationError error = deserializeJson(doc, payload);
+  TRACE(TRACE_PARSE, !error, 0);
+
+  if (error) {
+    Serial.print("JSON error: ");
+    Serial.println(error.c_str());
+    errorMsg = "JSON error";
+    return false;
+  }
 
+  prayerTimes.location = doc["location"] | "";
+  if (!applyPrayerTimes(doc["prayer_times"])) {
+    return false;
+  }
+  applyWeather(doc["weather"]);
   return true;
 }
 
-// Draw a dithered (grey) filled circle using checkerboard pattern
-void fillCircleDithered(int cx, int cy, int radius) {
-  for (int py = cy - radius; py <= cy + radius; py++) {
-    for (int px = cx - radius; px <= cx + radius; px++) {
-      int dx = px - cx;
-      int dy = py - cy;
-      if (dx * dx + dy * dy <= radius * radius) {
-        // Checkerboard pattern: alternate black/white
-        if ((px + py) % 2 == 0) {
-          display.drawPixel(px, py, GxEPD_BLACK);
-        }
-        // Leave other pixels as background (white)
-      }
-    }
+// Snapshot of the parsed data in the flat form the layout renders from
+RenderModel buildRenderModel() {
+  RenderModel model;
+  memset(&model, 0, sizeof(model)); // padding too, models are hashed
+  modelSetString(model.location, sizeof(model.location),
+                 prayerTimes.location.c_str());
+  const String *times[] = {&prayerTimes.fajr,    &prayerTimes.shuruq,
+                           &prayerTimes.dhuhr,   &prayerTimes.asr,
+                           &prayerTimes.maghrib, &prayerTimes.isha};
+  for (int i = 0; i < 6; i++) {
+    modelSetString(model.prayers[i], sizeof(model.prayers[i]),
+                   times[i]->c_str());
+  }
+  model.temperature = weatherData.temperature;
+  modelSetString(model.condition, sizeof(model.condition),
+                 weatherData.condition.c_str());
+  modelSetString(model.icon, sizeof(model.icon), weatherData.icon.c_str());
+
+  for (int i = 0; i < 3; i++) {
+    modelSetString(model.forecast[i].date, sizeof(model.forecast[i].date),
+                   forecast[i].date.c_str());
+    model.forecast[i].high = forecast[i].high;
+    model.forecast[i].low = forecast[i].low;
+    modelSetString(model.forecast[i].condition,
+                   sizeof(model.forecast[i].condition),
+                   forecast[i].condition.c_str());
+  }
+
+  struct tm now;
+  model.highlight = -1;
+  if (HIGHLIGHT_NEXT_PRAYER && getLocalTime(&now, 0)) {
+    model.highlight = nextPrayerIndex(model, now.tm_hour * 60 + now.tm_min);
   }
+  return model;
 }
 
-// Draw a dithered (grey) filled rectangle using checkerboard pattern
-void fillRectDithered(int x, int y, int w, int h) {
-  for (int py = y; py < y + h; py++) {
-    for (int px = x; px < x + w; px++) {
-      if ((px + py) % 2 == 0) {
-        display.drawPixel(px, py, GxEPD_BLACK);
-      }
-    }
+// Milliseconds since boot, for the timeline printed before sleep
+unsigned long refreshStartMs = 0;
+volatile unsigned long refreshEndMs = 0;
+unsigned long refreshWaitMs = 0; // the wake blocked on it
+#if OVERLAP_REFRESH
+SemaphoreHandle_t refreshDone = nullptr;
+
+static void refreshTask(void *) {
+  display.epd2.refresh(false);
+  display.epd2.powerOff();
+  refreshEndMs = millis();
+  xSemaphoreGive(refreshDone);
+  vTaskDelete(nullptr);
+}
+#endif
+
+// Full refresh of what was written to the panel. With OVERLAP_REFRESH it
+// returns at once; the panel takes nothing else until finishRefresh().
+void startRefresh() {
+  refreshStartMs = millis();
+#if OVERLAP_REFRESH
+  refreshDone = xSemaphoreCreateBinary();
+  xTaskCreatePinnedToCore(refreshTask, "refresh", 4096, nullptr, 1, nullptr,
+                          0);
+#else
+  display.epd2.refresh(false);
+  display.epd2.powerOff();
+  refreshEndMs = millis();
+  refreshWaitMs += refreshEndMs - refreshStartMs;
+#endif
+}
+
+void finishRefresh() {
+#if OVERLAP_REFRESH
+  if (refreshDone == nullptr) {
+    return;
   }
+  phaseBegin(PHASE_PANEL);
+  unsigned long t0 = millis();
+  xSemaphoreTake(refreshDone, portMAX_DELAY);
+  refreshWaitMs += millis() - t0;
+  vSemaphoreDelete(refreshDone);
+  refreshDone = nullptr;
+#endif
 }
 
-// Draw small weather icon for forecast (based on condition text)
-void drawSmallWeatherIcon(int x, int y, String condition) {
-  condition.toLowerCase();
+// Send the frame buffer to the panel and start a full refresh (~30 s)
+void pushFrame() {
+  finishRefresh();
+  deviceState.rtc.pendingSince = 0;
+  deviceState.rtc.errorShown = false;
+  phaseBegin(PHASE_PANEL);
+  Serial.printf("Wake-to-refresh: %lu ms\n", millis());
+#ifdef QEMU_BUILD
+  qemuPanelSink(frame.data(), frame.size());
+  return;
+#endif
+  display.epd2.writeNative(frame.data(), nullptr, 0, 0, SCREEN_WIDTH,
+                           SCREEN_HEIGHT, false, false, false);
+  startRefresh();
+}
 
-  // Clear/Sunny
-  if (condition.indexOf("clear") >= 0 || condition.indexOf("sun") >= 0) {
-    // Orange sun - larger and bolder
-    display.fillCircle(x, y, 14, GxEPD_ORANGE);
-    for (int i = 0; i < 8; i++) {
-      float angle = i * PI / 4;
-      int x1 = x + cos(angle) * 18;
-      int y1 = y + sin(angle) * 18;
-      int x2 = x + cos(angle) * 26;
-      int y2 = y + sin(angle) * 26;
-      display.drawLine(x1, y1, x2, y2, GxEPD_ORANGE);
-      display.drawLine(x1 + 1, y1, x2 + 1, y2, GxEPD_ORANGE);
-    }
+#ifdef PANEL_BAND_ROWS
+static void paintModel(void *ctx, FrameBuffer &band) {
+  phaseBegin(PHASE_RENDER);
+  renderWidgets(band, *static_cast<const RenderModel *>(ctx), WIDGET_ALL);
+}
+
+static void paintError(void *ctx, FrameBuffer &band) {
+  phaseBegin(PHASE_RENDER);
+  renderMessage(band, "Error", static_cast<const char *>(ctx));
+}
+
+static bool panelBandSink(void *, const FrameBuffer &band) {
+  phaseBegin(PHASE_PANEL);
+#ifdef QEMU_BUILD
+  qemuPanelSink(band.data(), band.size());
+  return true;
+#endif
+  // In paged mode the driver continues one frame's data stream across
+  // full-width writes of consecutive rows
+  display.epd2.writeNative(band.data(), nullptr, 0, band.bandTop(),
+                           SCREEN_WIDTH, band.bandRows(), false, false,
+                           false);
+  return true;
+}
+
+// Render the screen band by band, streaming each band to the panel, then
+// run a full refresh
+void pushBands(BandPainter paint, void *ctx) {
+  finishRefresh();
+  deviceState.rtc.pendingSince = 0;
+  deviceState.rtc.errorShown = false;
+  unsigned long t0 = millis();
+#ifndef QEMU_BUILD
+  display.epd2.setPaged();
+#endif
+  uint32_t hash;
+  renderBands(frame, paint, ctx, panelBandSink, nullptr, &hash);
+  Serial.printf("Bands: %d x %d rows, %08x, render+stream %lu ms\n",
+                (SCREEN_HEIGHT + PANEL_BAND_ROWS - 1) / PANEL_BAND_ROWS,
+                PANEL_BAND_ROWS, hash, millis() - t0);
+  phaseBegin(PHASE_PANEL);
+  Serial.printf("Wake-to-refresh: %lu ms\n", millis());
+#ifdef QEMU_BUILD
+  return;
+#endif
+  startRefresh();
+}
+#endif
+
+#if COALESCE_REFRESH
+// Coalesced refreshes today, counted in the RTC state
+uint16_t &refreshesAvoidedToday() {
+  struct tm now;
+  if (getLocalTime(&now, 0) &&
+      deviceState.rtc.avoidedDay != (uint16_t)now.tm_yday) {
+    deviceState.rtc.avoidedDay = now.tm_yday;
+    deviceState.rtc.refreshesAvoided = 0;
   }
-  // Clouds
-  else if (condition.indexOf("cloud") >= 0) {
-    // Grey cloud - dithered for grey effect
-    fillCircleDithered(x - 8, y, 12);
-    fillCircleDithered(x + 8, y + 2, 10);
-    fillCircleDithered(x, y - 6, 10);
-    fillRectDithered(x - 18, y, 36, 14);
-  }
-  // Rain
-  else if (condition.indexOf("rain") >= 0 ||
-           condition.indexOf("drizzle") >= 0) {
-    // Grey cloud + blue drops
-    fillCircleDithered(x - 6, y - 8, 10);
-    fillCircleDithered(x + 6, y - 6, 8);
-    fillRectDithered(x - 16, y - 8, 32, 10);
-    // Rain drops - thicker
-    for (int i = 0; i < 3; i++) {
-      int dx = x - 10 + i * 10;
-      display.fillCircle(dx, y + 10, 2, GxEPD_BLUE);
-      display.fillCircle(dx - 1, y + 14, 2, GxEPD_BLUE);
-    }
+  return deviceState.rtc.refreshesAvoided;
+}
+
+// True if the change from the stored frame can wait. The first deferred
+// change starts the pending time, which any refresh ends (pushFrame).
+bool deferRefresh(const RenderModel &last, const RenderModel &model,
+                  bool frameChanged) {
+  static const RefreshPolicy policy = {REFRESH_ALWAYS,
+                                       REFRESH_TEMPERATURE_BAND,
+                                       REFRESH_MAX_STALE_MIN * 60L};
+  struct tm local;
+  if (!getLocalTime(&local, 0)) {
+    return false; // no clock for the staleness
   }
-  // Snow
-  else if (condition.indexOf("snow") >= 0) {
-    // Blue snowflake - thicker lines
-    for (int i = 0; i < 3; i++) {
-      float angle = i * PI / 3;
-      int x1 = x - cos(angle) * 16;
-      int y1 = y - sin(angle) * 16;
-      int x2 = x + cos(angle) * 16;
-      int y2 = y + sin(angle) * 16;
-      display.drawLine(x1, y1, x2, y2, GxEPD_BLUE);
-      display.drawLine(x1 + 1, y1, x2 + 1, y2, GxEPD_BLUE);
-    }
-    display.fillCircle(x, y, 5, GxEPD_BLUE);
-  }
-  // Thunderstorm
-  else if (condition.indexOf("thunder") >= 0 ||
-           condition.indexOf("storm") >= 0) {
-    // Grey cloud + yellow lightning
-    fillCircleDithered(x - 6, y - 10, 10);
-    fillCircleDithered(x + 6, y - 8, 8);
-    fillRectDithered(x - 16, y - 10, 32, 10);
-    // Yellow lightning bolt
-    display.fillTriangle(x - 4, y + 2, x + 6, y + 2, x + 2, y + 12,
-                         GxEPD_YELLOW);
-    display.fillTriangle(x, y + 10, x + 8, y + 10, x - 4, y + 22, GxEPD_YELLOW);
-  }
-  // Mist/Fog
-  else if (condition.indexOf("mist") >= 0 || condition.indexOf("fog") >= 0 ||
-           condition.indexOf("haze") >= 0) {
-    for (int i = 0; i < 4; i++) {
-      display.drawLine(x - 16, y - 10 + i * 7, x + 16, y - 10 + i * 7,
-                       GxEPD_BLACK);
-      display.drawLine(x - 16, y - 10 + i * 7 + 1, x + 16, y - 10 + i * 7 + 1,
-                       GxEPD_BLACK);
-    }
+  uint32_t now = time(nullptr);
+  bool pending = deviceState.rtc.pendingSince != 0;
+  // The hysteresis band is around what the panel shows, not what was
+  // deferred, so small steps can't add up unnoticed
+  RenderModel shown = last;
+  if (pending) {
+    shown.temperature = deviceState.rtc.panelTemperature;
   }
-  // Default - question mark
-  else {
-    display.drawCircle(x, y, 12, GxEPD_BLACK);
-    display.drawCircle(x, y, 11, GxEPD_BLACK);
-  }
-}
-
-// Draw weather icon based on OpenWeatherMap icon code
-void drawWeatherIcon(int x, int y, String iconCode) {
-  int size = 120; // Large icon size
-
-  // Clear/sunny (01d, 01n)
-  if (iconCode.startsWith("01")) {
-    // Sun - solid ORANGE circle with ORANGE rays
-    display.fillCircle(x, y, size / 3, GxEPD_ORANGE);
-    // Rays - all ORANGE, thick
-    for (int i = 0; i < 8; i++) {
-      float angle = i * PI / 4;
-      int x1 = x + cos(angle) * (size / 3 + 8);
-      int y1 = y + sin(angle) * (size / 3 + 8);
-      int x2 = x + cos(angle) * (size / 2 + 5);
-      int y2 = y + sin(angle) * (size / 2 + 5);
-      display.drawLine(x1, y1, x2, y2, GxEPD_ORANGE);
-      display.drawLine(x1 + 1, y1, x2 + 1, y2, GxEPD_ORANGE);
-      display.drawLine(x1, y1 + 1, x2, y2 + 1, GxEPD_ORANGE);
-      display.drawLine(x1 + 1, y1 + 1, x2 + 1, y2 + 1, GxEPD_ORANGE);
-    }
+  uint8_t significant = significantWidgets(policy, shown, model);
+  uint32_t waited = pending ? now - deviceState.rtc.pendingSince : 0;
+  if (significant != 0 || waited >= (uint32_t)policy.maxStaleSeconds) {
+    return false;
   }
-  // Few clouds (02d, 02n)
-  else if (iconCode.startsWith("02")) {
-    // Small sun (all ORANGE) behind cloud
-    display.fillCircle(x + 35, y - 25, 22, GxEPD_ORANGE);
-    for (int i = 0; i < 8; i++) {
-      float angle = i * PI / 4;
-      int x1 = x + 35 + cos(angle) * 26;
-      int y1 = y - 25 + sin(angle) * 26;
-      int x2 = x + 35 + cos(angle) * 38;
-      int y2 = y - 25 + sin(angle) * 38;
-      display.drawLine(x1, y1, x2, y2, GxEPD_ORANGE);
-      display.drawLine(x1 + 1, y1, x2 + 1, y2, GxEPD_ORANGE);
-    }
-    // Cloud in front (DITHERED GREY)
-    fillCircleDithered(x - 20, y + 10, 32);
-    fillCircleDithered(x + 25, y + 15, 26);
-    fillCircleDithered(x + 5, y - 8, 28);
-    fillRectDithered(x - 52, y + 10, 104, 35);
-  }
-  // Scattered/broken clouds (03d, 03n, 04d, 04n)
-  else if (iconCode.startsWith("03") || iconCode.startsWith("04")) {
-    // Cloud shape (DITHERED GREY) - larger
-    fillCircleDithered(x - 20, y + 10, 36);
-    fillCircleDithered(x + 30, y + 10, 28);
-    fillCircleDithered(x + 10, y - 16, 32);
-    fillRectDithered(x - 56, y + 10, 116, 40);
-  }
-  // Rain (09d, 09n, 10d, 10n)
-  else if (iconCode.startsWith("09") || iconCode.startsWith("10")) {
-    // Cloud (DITHERED GREY) + rain drops (BLUE)
-    fillCircleDithered(x - 20, y - 20, 28);
-    fillCircleDithered(x + 20, y - 20, 24);
-    fillCircleDithered(x, y - 36, 24);
-    fillRectDithered(x - 48, y - 20, 96, 28);
-    // Rain drops (BLUE) - larger and thicker
-    for (int i = 0; i < 4; i++) {
-      int dx = x - 30 + i * 20;
-      display.drawLine(dx, y + 20, dx - 10, y + 50, GxEPD_BLUE);
-      display.drawLine(dx + 1, y + 20, dx - 9, y + 50, GxEPD_BLUE);
-      display.drawLine(dx + 2, y + 20, dx - 8, y + 50, GxEPD_BLUE);
-      display.drawLine(dx + 3, y + 20, dx - 7, y + 50, GxEPD_BLUE);
-    }
+
+  if (!pending) {
+    deviceState.rtc.pendingSince = now;
+    deviceState.rtc.panelTemperature = last.temperature;
   }
-  // Thunderstorm (11d, 11n)
-  else if (iconCode.startsWith("11")) {
-    // Cloud (DITHERED GREY) + lightning (YELLOW)
-    fillCircleDithered(x - 20, y - 20, 28);
-    fillCircleDithered(x + 20, y - 20, 24);
-    fillCircleDithered(x, y - 36, 24);
-    fillRectDithered(x - 48, y - 20, 96, 28);
-    // Lightning bolt (YELLOW) - larger
-    display.fillTriangle(x - 5, y + 10, x + 18, y + 10, x + 8, y + 40,
-                         GxEPD_YELLOW);
-    display.fillTriangle(x + 5, y + 32, x + 28, y + 32, x - 8, y + 70,
-                         GxEPD_YELLOW);
-  }
-  // Snow (13d, 13n)
-  else if (iconCode.startsWith("13")) {
-    // Snowflake pattern (BLUE) - larger
-    for (int i = 0; i < 3; i++) {
-      float angle = i * PI / 3;
-      display.drawLine(x - cos(angle) * 50, y - sin(angle) * 50,
-                       x + cos(angle) * 50, y + sin(angle) * 50, GxEPD_BLUE);
-      display.drawLine(x - cos(angle) * 50 + 1, y - sin(angle) * 50,
-                       x + cos(angle) * 50 + 1, y + sin(angle) * 50,
-                       GxEPD_BLUE);
-      display.drawLine(x - cos(angle) * 50 + 2, y - sin(angle) * 50,
-                       x + cos(angle) * 50 + 2, y + sin(angle) * 50,
-                       GxEPD_BLUE);
-    }
-    // Small branches on snowflake
-    for (int i = 0; i < 6; i++) {
-      float angle = i * PI / 3;
-      int mx = x + cos(angle) * 30;
-      int my = y + sin(angle) * 30;
-      display.drawLine(mx, my, mx + cos(angle + PI / 6) * 15,
-                       my + sin(angle + PI / 6) * 15, GxEPD_BLUE);
-      display.drawLine(mx, my, mx + cos(angle - PI / 6) * 15,
-                       my + sin(angle - PI / 6) * 15, GxEPD_BLUE);
-    }
-    display.fillCircle(x, y, 8, GxEPD_BLUE);
-  }
-  // Mist/fog (50d, 50n)
-  else if (iconCode.startsWith("50")) {
-    // Horizontal lines - larger
-    for (int i = 0; i < 5; i++) {
-      display.drawLine(x - 50, y - 30 + i * 15, x + 50, y - 30 + i * 15,
-                       GxEPD_BLACK);
-      display.drawLine(x - 50, y - 30 + i * 15 + 1, x + 50, y - 30 + i * 15 + 1,
-                       GxEPD_BLACK);
-      display.drawLine(x - 50, y - 30 + i * 15 + 2, x + 50, y - 30 + i * 15 + 2,
-                       GxEPD_BLACK);
+  if (frameChanged) {
+    refreshesAvoidedToday()++;
+  }
+  Serial.printf("Coalesced: widgets %02x changed, none significant, "
+                "pending %lu s\n",
+                changedWidgets(last, model), (unsigned long)waited);
+  return true;
+}
+#endif
+
+// Refreshes the panel with the frame drawn from model, unless it is what
+// the panel already shows or the change can wait (COALESCE_REFRESH).
+// Returns false if the refresh was skipped.
+bool presentFrame(const RenderModel *last, uint32_t lastHash,
+                  const RenderModel &model, uint32_t hash) {
+  shownModel = model;
+  haveShownModel = true;
+  bool unchanged = last && hash == lastHash;
+  if (unchanged && deviceState.rtc.pendingSince == 0) {
+    Serial.println("Frame unchanged, skipping refresh");
+    return false;
+  }
+#if COALESCE_REFRESH
+  if (last && deferRefresh(*last, model, !unchanged)) {
+    if (!unchanged) {
+      // The next refresh, e.g. a highlight wake's, shows it
+      phaseBegin(PHASE_STORE);
+      saveLastFrame(frame, model, hash);
     }
+    return false;
   }
-  // Default - question mark
-  else {
-    display.drawCircle(x, y, size / 2, GxEPD_BLACK);
-    u8g2Fonts.setFont(u8g2_font_helvB24_tf);
-    u8g2Fonts.setCursor(x - 12, y + 12);
-    u8g2Fonts.print("?");
+#endif
+
+  pushFrame();
+  phaseBegin(PHASE_STORE);
+  saveLastFrame(frame, model, hash);
+  Serial.println("Display updated!");
+  return true;
+}
+
+// Returns false if the frame was unchanged and the refresh skipped
+bool displayModel(const RenderModel &model) {
+#ifdef PANEL_BAND_ROWS
+  // No stored frame to compare against: always a full render and refresh
+  pushBands(paintModel, const_cast<RenderModel *>(&model));
+  shownModel = model;
+  haveShownModel = true;
+  return true;
+#else
+  // Start from the stored frame when there is one, redrawing only the
+  // widgets whose inputs changed since it was rendered
+  phaseBegin(PHASE_STORE);
+  unsigned long t0 = micros();
+  RenderModel lastModel;
+  uint32_t lastHash = 0;
+  bool haveLast = loadLastFrame(frame, lastModel, lastHash);
+  uint8_t widgets = WIDGET_ALL;
+  if (haveLast) {
+    widgets = expandDirtyWidgets(changedWidgets(lastModel, model));
   }
+  unsigned long t1 = micros();
+
+  phaseBegin(PHASE_RENDER);
+  if (widgets != 0) {
+    renderWidgets(frame, model, widgets);
+  }
+  unsigned long t2 = micros();
+  uint32_t hash = frame.hash();
+  unsigned long t3 = micros();
+
+  Serial.printf("Render: %d widgets, load %lu us, draw %lu us, hash %lu us\n",
+                __builtin_popcount(widgets), t1 - t0, t2 - t1, t3 - t2);
+  return presentFrame(haveLast ? &lastModel : nullptr, lastHash, model, hash);
+#endif
 }
 
 void displayPrayerTimes() {
   Serial.println("Updating display...");
-  display.setRotation(0);
-  display.setFullWindow();
-  display.firstPage();
-
-  do {
-    display.fillScreen(GxEPD_WHITE);
-
-    // Initialize U8g2 fonts for this page
-    u8g2Fonts.begin(display);
-    u8g2Fonts.setForegroundColor(GxEPD_BLACK);
-    u8g2Fonts.setBackgroundColor(GxEPD_WHITE);
-
-    // ========== LEFT SIDE: Prayer Times (Google Material Design) ==========
-    int sectionX = 30;
-    int sectionWidth = 340;
-    int startY = 35;
-
-    // Header with large title
-    u8g2Fonts.setFont(u8g2_font_helvR24_tf); // Light weight for Google style
-    u8g2Fonts.setCursor(sectionX, startY + 28);
-    u8g2Fonts.print("Prayer Times");
-
-    // Location - subtle, below title
-    if (prayerTimes.location.length() > 0) {
-      u8g2Fonts.setFont(u8g2_font_helvR12_tf);
-      u8g2Fonts.setCursor(sectionX, startY + 48);
-      u8g2Fonts.print(prayerTimes.location);
+  bool pushed = displayModel(buildRenderModel());
+  TRACE(TRACE_REFRESH, pushed, TRACE_REFRESH_DATA);
+}
+
+#ifdef SYNC_SERVER
+bool showHighlightFromLastFrame();
+
+// The whole fetch is one sync exchange, whose reply also sets the clock.
+// The model only needs the highlight from that clock before it is drawn.
+bool syncAndDisplay() {
+  phaseBegin(PHASE_FETCH);
+  Serial.printf("Syncing with udp://%s:%d\n", SYNC_SERVER, SYNC_PORT);
+  unsigned long fetchStart = millis();
+  RenderModel model;
+  uint32_t version = 0;
+  uint32_t serverTime = 0;
+  SyncStatus status =
+      syncFetch(SYNC_SERVER, SYNC_PORT, deviceState.rtc.payloadVersion, model,
+                version, serverTime);
+  if (status != SYNC_GAVE_UP) {
+    // Without a stored zone (first wake) NTP sets both
+    if (deviceState.rtc.timeZone[0] == '\0') {
+      syncTime();
+    } else {
+      struct timeval tv = {(time_t)serverTime, 0};
+      settimeofday(&tv, nullptr);
+      restoreTimeZone();
+      clockSynced = true;
+      TRACE(TRACE_TIME_SYNC, 1, serverTime);
+    }
+  }
+  bool patched = false;
+  if (status == SYNC_SAME) {
+    Serial.printf("Payload version %08x unchanged\n", version);
+    patched = showHighlightFromLastFrame();
+    if (!patched) {
+      status = syncFetch(SYNC_SERVER, SYNC_PORT, 0, model, version, serverTime);
     }
+  }
+  // Nothing else on this wake needs the radio
+  WiFi.disconnect(true);
+  WiFi.mode(WIFI_OFF);
+  telemetry.netMs = millis() - netStart;
+  // Recorded as HTTP 200 or no response, so wake_sim replays it the same
+  TRACE(TRACE_HTTP, status == SYNC_GAVE_UP ? 0 : HTTP_CODE_OK,
+        millis() - fetchStart);
+  if (status == SYNC_GAVE_UP) {
+    errorMsg = "Sync failed";
+    return false;
+  }
+  if (patched) {
+    return true;
+  }
 
-    // Prayer list - Material Design style (no borders, divider lines)
-    int listStartY = startY + 75;
-    int rowHeight = 60;
-
-    // Prayer data
-    String prayerNames[] = {"Fajr", "Sunrise", "Dhuhr",
-                            "Asr",  "Maghrib", "Isha"};
-    String prayerTimesArr[] = {prayerTimes.fajr,    prayerTimes.shuruq,
-                               prayerTimes.dhuhr,   prayerTimes.asr,
-                               prayerTimes.maghrib, prayerTimes.isha};
-
-    for (int i = 0; i < 6; i++) {
-      int rowY = listStartY + i * rowHeight;
-      int rowCenterY =
-          rowY + rowHeight / 2 -
-          4; // Vertical center of row (-4 to account for divider offset)
-
-      // Divider line above each item (except first)
-      if (i > 0) {
-        display.drawLine(sectionX, rowY - 8, sectionX + sectionWidth, rowY - 8,
-                         GxEPD_BLACK);
-      }
+  TRACE(TRACE_BODY, sizeof(model), version);
+  deviceState.rtc.payloadVersion = version;
+  model.highlight = -1;
+  struct tm now;
+  if (HIGHLIGHT_NEXT_PRAYER && getLocalTime(&now, 0)) {
+    model.highlight = nextPrayerIndex(model, now.tm_hour * 60 + now.tm_min);
+  }
+  Serial.println("Updating display...");
+  bool pushed = displayModel(model);
+  TRACE(TRACE_REFRESH, pushed, TRACE_REFRESH_DATA);
+  return true;
+}
+#endif
+
+#if PIPELINE_RENDER
+// Each screen region is drawn on a render task as soon as the payload
+// section it depends on is complete, while the rest is still downloading.
+// Jobs draw at the transfer phase's clock; that only costs time if the
+// body arrives faster than the regions draw.
+struct RenderJob {
+  RenderModel model;
+  uint8_t widgets; // 0 stops the task
+};
 
-      // Prayer name - regular weight, left aligned, vertically centered
-      u8g2Fonts.setFont(u8g2_font_helvR18_tf);
-      u8g2Fonts.setCursor(sectionX, rowCenterY + 7);
-      u8g2Fonts.print(prayerNames[i]);
+struct Pipeline {
+  PayloadSplitter splitter;
+  RenderModel lastModel;
+  uint32_t lastHash;
+  bool haveLast;
+  bool havePrayers;
+  bool parseError;
+  uint8_t ready; // widgets whose sections have arrived
+  uint8_t drawn;
+  int8_t drawnHighlight;
+};
 
-      // Time - large, bold, right aligned, vertically centered
-      u8g2Fonts.setFont(u8g2_font_helvB24_tf);
-      int timeWidth = u8g2Fonts.getUTF8Width(prayerTimesArr[i].c_str());
-      u8g2Fonts.setCursor(sectionX + sectionWidth - timeWidth, rowCenterY + 10);
-      u8g2Fonts.print(prayerTimesArr[i]);
+static Pipeline pipeline; // too big for the loop task's stack
+static QueueHandle_t renderJobs;
+static SemaphoreHandle_t renderStopped;
+static volatile uint32_t pipelineRenderUs;
+
+static void renderTask(void *) {
+  RenderJob job;
+  while (xQueueReceive(renderJobs, &job, portMAX_DELAY) == pdTRUE &&
+         job.widgets != 0) {
+    unsigned long t0 = micros();
+    renderWidgets(frame, job.model, job.widgets);
+    pipelineRenderUs += micros() - t0;
+    phaseBoostRelease(); // taken when the job was queued
+  }
+  xSemaphoreGive(renderStopped);
+  vTaskDelete(nullptr);
+}
+
+static void queueReadyWidgets() {
+  RenderJob job;
+  job.model = buildRenderModel();
+  uint8_t dirty =
+      pipeline.haveLast
+          ? expandDirtyWidgets(changedWidgets(pipeline.lastModel, job.model))
+          : WIDGET_ALL;
+  job.widgets = drawableWidgets(dirty, pipeline.ready, pipeline.drawn);
+  if (job.widgets == 0) {
+    return;
+  }
+  if (job.widgets & WIDGET_PRAYERS) {
+    pipeline.drawnHighlight = job.model.highlight;
+  }
+  pipeline.drawn |= job.widgets;
+  // The transfer phase runs at the low clock; queued jobs keep it high
+  // until the render task has drawn them
+  phaseBoostAcquire();
+  xQueueSend(renderJobs, &job, portMAX_DELAY);
+}
+
+static void applyPayloadSection(uint8_t widgets, const char *key,
+                                const char *value, size_t len) {
+  JsonDocument doc;
+  if (deserializeJson(doc, value, len)) {
+    Serial.printf("JSON error in %s\n", key);
+    pipeline.parseError = true;
+    return;
+  }
+  if (widgets == WIDGET_HEADER) {
+    const char *location = doc.as<const char *>();
+    prayerTimes.location = location ? location : "";
+  } else if (widgets == WIDGET_PRAYERS) {
+    pipeline.havePrayers = applyPrayerTimes(doc.as<JsonObject>());
+    if (!pipeline.havePrayers) {
+      return;
     }
+  } else {
+    applyWeather(doc.as<JsonObject>());
+  }
+  pipeline.ready |= widgets;
+  queueReadyWidgets();
+}
 
-    // ========== RIGHT SIDE: Weather ==========
-    int weatherStartY = 50;
-    // Weather section spans from divider to right edge: 390 to 800 = 410px
-    // Center point at 390 + 410/2 = 595
-    int weatherCenterX = 595;
-
-    // Vertical divider line - subtle
-    display.drawLine(385, startY + 20, 385, 450, GxEPD_BLACK);
-
-    // Weather icon (centered at top)
-    drawWeatherIcon(weatherCenterX, weatherStartY + 60, weatherData.icon);
-
-    // Temperature - large and bold, centered below icon
-    u8g2Fonts.setFont(u8g2_font_helvB24_tf);
-    String tempStr = String(weatherData.temperature) + " C";
-    int textWidth = u8g2Fonts.getUTF8Width(tempStr.c_str());
-    u8g2Fonts.setCursor(weatherCenterX - textWidth / 2, weatherStartY + 145);
-    u8g2Fonts.print(tempStr);
-    // Degree symbol
-    display.drawCircle(weatherCenterX - textWidth / 2 + 58, weatherStartY + 117,
-                       5, GxEPD_BLACK);
-
-    // Condition - centered below temperature
-    u8g2Fonts.setFont(u8g2_font_helvR14_tf);
-    textWidth = u8g2Fonts.getUTF8Width(weatherData.condition.c_str());
-    u8g2Fonts.setCursor(weatherCenterX - textWidth / 2, weatherStartY + 175);
-    u8g2Fonts.print(weatherData.condition);
-
-    // ========== 3-DAY FORECAST ==========
-    int forecastY = weatherStartY + 200;
-    int boxWidth = 115;
-    int boxHeight = 130;
-    int boxSpacing = 8;
-    int totalWidth = 3 * boxWidth + 2 * boxSpacing;
-    int startX = weatherCenterX - totalWidth / 2; // Center the 3 boxes
-
-    for (int i = 0; i < 3; i++) {
-      int boxX = startX + i * (boxWidth + boxSpacing);
-      int boxCenterX = boxX + boxWidth / 2;
-
-      // Simple rounded rectangle with consistent 2px border
-      int r = 10; // Corner radius
-      // Draw outer rounded rectangle
-      display.drawRoundRect(boxX, forecastY, boxWidth, boxHeight, r,
-                            GxEPD_BLACK);
-      display.drawRoundRect(boxX + 1, forecastY + 1, boxWidth - 2,
-                            boxHeight - 2, r - 1, GxEPD_BLACK);
-
-      // Day name at top (bold, centered) - format DD.MM
-      u8g2Fonts.setFont(u8g2_font_helvB18_tf);
-      String dayLabel = "";
-      if (forecast[i].date.length() >= 10) {
-        // Convert from YYYY-MM-DD to DD.MM
-        String month = forecast[i].date.substring(5, 7);
-        String day = forecast[i].date.substring(8, 10);
-        dayLabel = day + "." + month;
+static void onPayloadSection(const char *key, const char *value, size_t len,
+                             void *) {
+  uint8_t widgets = payloadSectionWidgets(key);
+  if (widgets == 0) {
+    return;
+  }
+  // Parsed at the high clock too, in the middle of the transfer phase
+  phaseBoostAcquire();
+  applyPayloadSection(widgets, key, value, len);
+  phaseBoostRelease();
+}
+
+// Downloads the payload into the splitter as it arrives
+bool streamPayload() {
+  PayloadSplitter &splitter = pipeline.splitter;
+#ifdef QEMU_BUILD
+  String payload;
+  if (!downloadPayload(payload)) {
+    return false;
+  }
+  phaseBegin(PHASE_TRANSFER);
+  payloadFeed(splitter, (const uint8_t *)payload.c_str(), payload.length(),
+              onPayloadSection, nullptr);
+  return true;
+#endif
+  DataClient client;
+  HTTPClient http;
+  http.useHTTP10(true); // no chunked encoding, the body is the raw stream
+  unsigned long fetchStart;
+  if (!requestPayload(http, client, fetchStart)) {
+    return false;
+  }
+
+  phaseBegin(PHASE_TRANSFER);
+  WiFiClient &body = http.getStream();
+  int length = http.getSize(); // -1 until the server closes
+  size_t total = 0;
+  uint32_t hash = TRACE_HASH_SEED;
+  uint8_t buf[512];
+  unsigned long lastData = millis();
+  while ((length < 0 || total < (size_t)length) &&
+         !payloadComplete(splitter)) {
+    int avail = body.available();
+    if (avail <= 0) {
+      if (!body.connected() || millis() - lastData > PIPELINE_STALL_MS) {
+        break;
       }
-      int tw = u8g2Fonts.getUTF8Width(dayLabel.c_str());
-      u8g2Fonts.setCursor(boxCenterX - tw / 2, forecastY + 26);
-      u8g2Fonts.print(dayLabel);
-
-      // Weather icon in the middle (larger)
-      drawSmallWeatherIcon(boxCenterX, forecastY + 65, forecast[i].condition);
-
-      // High / Low temps at bottom - larger font
-      u8g2Fonts.setFont(u8g2_font_helvB18_tf);
-      String temps = String(forecast[i].high) + " / " + String(forecast[i].low);
-      tw = u8g2Fonts.getUTF8Width(temps.c_str());
-      u8g2Fonts.setCursor(boxCenterX - tw / 2, forecastY + 118);
-      u8g2Fonts.print(temps);
+      delay(1);
+      continue;
     }
+    size_t n = body.readBytes(buf, min((size_t)avail, sizeof(buf)));
+    lastData = millis();
+    total += n;
+    hash = traceHash(buf, n, hash);
+    if (!payloadFeed(splitter, buf, n, onPayloadSection, nullptr)) {
+      break;
+    }
+  }
+  http.end();
+  recordTransfer(total, hash, fetchStart);
+  return true;
+}
+
+// Fetch, parse and draw in one pass; false with errorMsg set on failure
+bool fetchAndDisplay() {
+  phaseBegin(PHASE_STORE);
+  memset(&pipeline, 0, sizeof(pipeline));
+  payloadBegin(pipeline.splitter);
+  pipeline.haveLast =
+      loadLastFrame(frame, pipeline.lastModel, pipeline.lastHash);
+  if (!pipeline.haveLast) {
+    renderBackground(frame);
+  }
+  pipelineRenderUs = 0;
+  renderJobs = xQueueCreate(4, sizeof(RenderJob));
+  renderStopped = xSemaphoreCreateBinary();
+  xTaskCreatePinnedToCore(renderTask, "render", 8192, nullptr, 1, nullptr,
+                          PIPELINE_RENDER_CORE);
+
+  bool downloaded = streamPayload();
+  uint32_t overlapUs = pipelineRenderUs;
+
+  // The task finishes the jobs already queued first
+  RenderJob stop;
+  stop.widgets = 0;
+  xQueueSend(renderJobs, &stop, portMAX_DELAY);
+  xSemaphoreTake(renderStopped, portMAX_DELAY);
+  vQueueDelete(renderJobs);
+  vSemaphoreDelete(renderStopped);
+  if (!downloaded) {
+    return false;
+  }
 
-  } while (display.nextPage());
+  bool parsed = payloadComplete(pipeline.splitter) && !pipeline.parseError;
+  TRACE(TRACE_PARSE, parsed, 0);
+  if (!parsed) {
+    Serial.println("JSON error: incomplete or malformed payload");
+    errorMsg = "JSON error";
+    return false;
+  }
+  if (!pipeline.havePrayers) {
+    errorMsg = "No prayer_times";
+    return false;
+  }
 
-  Serial.println("Display updated!");
+  // Whatever had to wait for the end of the body, and the prayer list
+  // again if the highlight moved on while downloading
+  phaseBegin(PHASE_RENDER);
+  unsigned long t0 = micros();
+  RenderModel model = buildRenderModel();
+  if ((pipeline.drawn & WIDGET_PRAYERS) &&
+      model.highlight != pipeline.drawnHighlight) {
+    pipeline.drawn &= ~expandDirtyWidgets(WIDGET_PRAYERS);
+  }
+  uint8_t dirty =
+      pipeline.haveLast
+          ? expandDirtyWidgets(changedWidgets(pipeline.lastModel, model))
+          : WIDGET_ALL;
+  uint8_t rest = drawableWidgets(dirty, WIDGET_ALL, pipeline.drawn);
+  if (rest != 0) {
+    renderWidgets(frame, model, rest);
+  }
+  uint32_t hash = frame.hash();
+  Serial.printf("Pipeline: %u sections, %d widgets during the download "
+                "(%lu us), %d after it (%lu us)\n",
+                pipeline.splitter.sections, __builtin_popcount(pipeline.drawn),
+                (unsigned long)overlapUs, __builtin_popcount(rest),
+                micros() - t0);
+
+  bool pushed =
+      presentFrame(pipeline.haveLast ? &pipeline.lastModel : nullptr,
+                   pipeline.lastHash, model, hash);
+  TRACE(TRACE_REFRESH, pushed, TRACE_REFRESH_DATA);
+  return true;
+}
+#endif
+
+// Highlight-only wake: stream the frame rendered before sleeping
+bool showPreRenderedFrame() {
+  phaseBegin(PHASE_STORE);
+  unsigned long t0 = millis();
+  RenderModel model;
+  uint32_t hash;
+  uint32_t validAt;
+  if (!loadNextFrame(frame, model, hash, validAt)) {
+    return false;
+  }
+  long skew = (long)(time(nullptr) - (time_t)validAt);
+  if (labs(skew) > PRERENDER_TOLERANCE_SEC) {
+    Serial.printf("Pre-rendered frame is %ld s off, ignoring\n", skew);
+    clearNextFrame();
+    return false;
+  }
+  Serial.printf("Pre-rendered frame loaded in %lu ms\n", millis() - t0);
+
+  pushFrame();
+  TRACE(TRACE_REFRESH, 1, TRACE_REFRESH_PRERENDER);
+  phaseBegin(PHASE_STORE);
+  promoteNextFrame();
+  shownModel = model;
+  haveShownModel = true;
+  return true;
 }
 
-void displayError() {
-  display.setRotation(0);
-  display.setFullWindow();
-  display.firstPage();
+// Highlight-only wake without a usable pre-render: patch the last frame
+bool showHighlightFromLastFrame() {
+#ifdef PANEL_BAND_ROWS
+  return false; // nothing stored to patch
+#else
+  RenderModel model;
+  uint32_t hash;
+  struct tm now;
+  if (!loadLastFrame(frame, model, hash) || !getLocalTime(&now, 0)) {
+    return false;
+  }
+  model.highlight = nextPrayerIndex(model, now.tm_hour * 60 + now.tm_min);
+  bool pushed = displayModel(model);
+  TRACE(TRACE_REFRESH, pushed, TRACE_REFRESH_PATCHED);
+  return true;
+#endif
+}
 
-  do {
-    display.fillScreen(GxEPD_WHITE);
+// Draw the frame the next highlight wake will show, while everything is
+// still initialized. Needs the frame buffer to hold the shown frame.
+void preRenderNextFrame(const WakePlan &plan) {
+  phaseBegin(PHASE_RENDER);
+  unsigned long t0 = micros();
+  RenderModel next = shownModel;
+  next.highlight = plan.highlight;
+  uint8_t widgets = expandDirtyWidgets(changedWidgets(shownModel, next));
+  if (widgets != 0) {
+    renderWidgets(frame, next, widgets);
+  }
+  uint32_t validAt = (uint32_t)(time(nullptr) + plan.sleepSeconds);
+  phaseBegin(PHASE_STORE);
+  saveNextFrame(frame, next, frame.hash(), validAt);
+  Serial.printf("Pre-rendered next frame in %lu us\n", micros() - t0);
+}
 
-    // Initialize U8g2 fonts
-    u8g2Fonts.begin(display);
-    u8g2Fonts.setForegroundColor(GxEPD_BLACK);
-    u8g2Fonts.setBackgroundColor(GxEPD_WHITE);
+#ifdef RENDER_BENCH
+// Times redraws of one, several and all widgets on top of a full frame
+void benchmarkRender() {
+  RenderModel model = buildRenderModel();
+  renderWidgets(frame, model, WIDGET_ALL);
+
+  struct {
+    const char *name;
+    uint8_t widgets;
+  } cases[] = {
+      {"one (temperature)", WIDGET_TEMPERATURE},
+      {"several (temp, condition, day 3)",
+       WIDGET_TEMPERATURE | WIDGET_CONDITION | WIDGET_FORECAST_2},
+      {"all", WIDGET_ALL},
+  };
+  for (auto &c : cases) {
+    uint8_t widgets = expandDirtyWidgets(c.widgets);
+    unsigned long t0 = micros();
+    renderWidgets(frame, model, widgets);
+    frame.hash();
+    unsigned long t1 = micros();
+    Serial.printf("Render bench %-34s %d widgets %7lu us\n", c.name,
+                  __builtin_popcount(widgets), t1 - t0);
+  }
+}
+#endif
 
-    u8g2Fonts.setFont(u8g2_font_helvB24_tf);
-    u8g2Fonts.setCursor(60, 200);
-    u8g2Fonts.print("Error");
+void displayError() {
+  // The panel no longer shows the stored frame after this
+  phaseBegin(PHASE_STORE);
+  clearLastFrame();
+  haveShownModel = false;
+  deviceState.rtc.payloadVersion = 0;
+
+#ifdef PANEL_BAND_ROWS
+  pushBands(paintError, const_cast<char *>(errorMsg.c_str()));
+#else
+  phaseBegin(PHASE_RENDER);
+  renderMessage(frame, "Error", errorMsg.c_str());
+  pushFrame();
+#endif
+  deviceState.rtc.errorShown = true;
+  TRACE(TRACE_REFRESH, 1, TRACE_REFRESH_ERROR);
+}
 
-    u8g2Fonts.setFont(u8g2_font_helvR18_tf);
-    u8g2Fonts.setCursor(60, 260);
-    u8g2Fonts.print(errorMsg);
+// Today's prayer times from the provisioning image's offline calendar, in
+// place of the error screen. False without an image, a clock or the day.
+bool showCalendar() {
+  struct tm now;
+  CalendarDay day;
+  RenderModel model;
+  if (!provisioned || !getLocalTime(&now, 0) ||
+      !provisionCalendarDay(daysFromCivil(now.tm_year + 1900, now.tm_mon + 1,
+                                          now.tm_mday),
+                            day) ||
+      !modelFromCalendar(provision.location, day, model)) {
+    return false;
+  }
+  Serial.println("Showing today from the offline calendar");
+  if (HIGHLIGHT_NEXT_PRAYER) {
+    model.highlight = nextPrayerIndex(model, now.tm_hour * 60 + now.tm_min);
+  }
+  // Not a payload, but the stored frame is what highlight wakes go on from
+  deviceState.rtc.payloadVersion = 0;
+  bool pushed = displayModel(model);
+  TRACE(TRACE_REFRESH, pushed, TRACE_REFRESH_CALENDAR);
+  return true;
+}
 
-  } while (display.nextPage());
+// Keeps the last frame through the first failures and retries soon after;
+// without a stored frame (or after too many) shows the offline calendar or
+// the error screen, once
+void handleFetchFailure() {
+  uint8_t &failures = deviceState.rtc.fetchFailures;
+  if (failures < 255) {
+    failures++;
+  }
+  long delay = retryDelay(failures, esp_random());
+  deviceState.rtc.retryAt = time(nullptr) + delay;
+  Serial.printf("Fetch failed (%s), %u in a row, retry in %ld s\n",
+                errorMsg.c_str(), failures, delay);
+
+  RenderModel model;
+  uint32_t hash;
+  // The stored frame only matters while it may still be kept
+  bool haveFrame =
+      failures <= FAILURES_BEFORE_ERROR && loadLastFrame(frame, model, hash);
+  switch (failureAction(failures, haveFrame, deviceState.rtc.errorShown,
+                        FAILURES_BEFORE_ERROR)) {
+  case FAILURE_KEEP_FRAME:
+    // Highlight wakes go on from it until the retry
+    Serial.println("Keeping the last frame on the panel");
+    shownModel = model;
+    haveShownModel = true;
+    break;
+  case FAILURE_SHOW_ERROR:
+    if (!showCalendar()) {
+      displayError();
+    }
+    break;
+  case FAILURE_ERROR_SHOWN:
+    // Redrawing the same screen every retry costs a 30 s refresh each
+    Serial.println("Error screen already up, not redrawn");
+    break;
+  }
 }
 
 void syncTime() {
+#ifdef QEMU_BUILD
+  qemuSetClock();
+  return;
+#endif
   Serial.println("Syncing time with NTP...");
   configTime(GMT_OFFSET_SEC, DAYLIGHT_OFFSET_SEC, NTP_SERVER);
 
@@ -612,63 +1354,231 @@ void syncTime() {
     attempts++;
   }
   Serial.println(" Done!");
+  clockSynced = time(nullptr) >= 1000000000;
+  TRACE(TRACE_TIME_SYNC, clockSynced, time(nullptr));
+
+  // Wakes without WiFi restore the zone from here
+  const char *tz = getenv("TZ");
+  strlcpy(deviceState.rtc.timeZone, tz ? tz : "",
+          sizeof(deviceState.rtc.timeZone));
 }
 
-unsigned long calculateSleepSeconds() {
+void restoreTimeZone() {
+  if (deviceState.rtc.timeZone[0] != '\0') {
+    setenv("TZ", deviceState.rtc.timeZone, 1);
+    tzset();
+  }
+}
+
+WakePlan calculateWakePlan() {
   struct tm timeinfo;
+  long retryIn = 0;
+  if (deviceState.rtc.fetchFailures > 0) {
+    // Counts on the RTC clock even when it was never synced
+    retryIn = max((long)(deviceState.rtc.retryAt - time(nullptr)), 1L);
+  }
   if (!getLocalTime(&timeinfo)) {
     Serial.println("Failed to get time, using 24h fallback");
-    return 86400; // Fallback: 24 hours
+    return {retryIn ? retryIn : 86400, true, -1}; // the retry, or 24 hours
   }
 
   Serial.printf("Current time: %02d:%02d:%02d\n", timeinfo.tm_hour,
                 timeinfo.tm_min, timeinfo.tm_sec);
 
-  // Calculate seconds until next 3 AM
-  int currentSeconds =
+  // Next daily data wake, or an earlier prayer time for the highlight
+  long currentSeconds =
       timeinfo.tm_hour * 3600 + timeinfo.tm_min * 60 + timeinfo.tm_sec;
-  int targetSeconds = WAKE_HOUR * 3600 + WAKE_MINUTE * 60;
-
-  int sleepSeconds = targetSeconds - currentSeconds;
-
-  // If target time has passed today, wake up tomorrow
-  if (sleepSeconds <= 0) {
-    sleepSeconds += 86400; // Add 24 hours
+  long targetSeconds = WAKE_HOUR * 3600 + WAKE_MINUTE * 60;
+  if (provisioned) {
+    targetSeconds =
+        (targetSeconds + provision.wakeOffsetMin * 60L + 86400) % 86400;
   }
+  if (retryIn) {
+    // The retry replaces the daily data wake
+    targetSeconds = (currentSeconds + retryIn) % 86400;
+  }
+  WakePlan plan = planNextWake(shownModel, currentSeconds, targetSeconds,
+                               HIGHLIGHT_NEXT_PRAYER && haveShownModel);
+
+  time_t wakeAt = time(nullptr) + plan.sleepSeconds;
+  struct tm wakeInfo;
+  localtime_r(&wakeAt, &wakeInfo);
+  Serial.printf("Sleeping for %ld seconds (%.1f hours) until %02d:%02d (%s)\n",
+                plan.sleepSeconds, plan.sleepSeconds / 3600.0,
+                wakeInfo.tm_hour, wakeInfo.tm_min,
+                plan.fetch ? (retryIn ? "retry" : "fetch") : "highlight");
+
+  return plan;
+}
 
-  Serial.printf("Sleeping for %d seconds (%.1f hours) until %02d:%02d\n",
-                sleepSeconds, sleepSeconds / 3600.0, WAKE_HOUR, WAKE_MINUTE);
-
-  return sleepSeconds;
+// Where the refresh fell in the wake: with OVERLAP_REFRESH the wake's own
+// work hides behind the BUSY period and it sleeps when both are done
+void printTimeline(unsigned long workDoneMs) {
+  if (refreshStartMs == 0) {
+    return; // no refresh this wake
+  }
+  unsigned long busy = refreshEndMs - refreshStartMs;
+  Serial.printf("Timeline: refresh %lu-%lu ms, wake work done at %lu ms, "
+                "asleep at %lu ms, %lu ms of the refresh overlapped\n",
+                refreshStartMs, (unsigned long)refreshEndMs, workDoneMs,
+                millis(), busy - min(busy, refreshWaitMs));
 }
 
 void goToSleep() {
+  phaseBegin(PHASE_SLEEP);
   Serial.println("Preparing for deep sleep...");
 
-  // Sync time to calculate wake time
-  syncTime();
-  unsigned long sleepSeconds = calculateSleepSeconds();
+  // Sync time to calculate wake time, unless the fetch already did
+  if (!clockSynced && WiFi.status() == WL_CONNECTED) {
+    syncTime();
+  }
+  WakePlan plan = calculateWakePlan();
+  if (PRERENDER_NEXT_FRAME && !plan.fetch) {
+    preRenderNextFrame(plan);
+  }
+  deviceState.rtc.nextWakeFetches = plan.fetch;
 
+  phaseBegin(PHASE_STORE);
+  for (uint8_t i = 0; i < networkCount; i++) {
+    deviceState.durable.networkStats[i] = networks[i].stats;
+  }
+#if COALESCE_REFRESH
+  telemetry.refreshesAvoided = refreshesAvoidedToday();
+#endif
+  if (provisioned) {
+    modelSetString(telemetry.device, sizeof(telemetry.device),
+                   provision.deviceId);
+  }
+  telemetry.flashBytes = stateSave(deviceState) + frameBytesWritten();
+  printTelemetry();
+#ifdef TELEMETRY_URL
+  if (WiFi.status() == WL_CONNECTED) {
+    phaseBegin(PHASE_FETCH);
+    uploadTelemetry(TELEMETRY_URL);
+  }
+#endif
+
+  phaseBegin(PHASE_SLEEP);
+#ifdef QEMU_BUILD
+  TRACE(TRACE_SLEEP, plan.sleepSeconds, plan.fetch);
+#ifdef WAKE_TRACE
+  saveTrace(wakeTrace);
+#endif
+  printPhases();
+#ifdef WAKE_PROFILE
+  profilerDump();
+#endif
+  Serial.println("QEMU: wake cycle done");
+  while (true) {
+    delay(1000);
+  }
+#endif
   WiFi.disconnect(true);
   WiFi.mode(WIFI_OFF);
+  unsigned long workDoneMs = millis();
+  finishRefresh();
+  printTimeline(workDoneMs);
+#ifdef WAKE_PROFILE
+  profilerDump();
+#endif
+  // After the refresh, so the trace's awake time includes it
+  TRACE(TRACE_SLEEP, plan.sleepSeconds, plan.fetch);
+#ifdef WAKE_TRACE
+  saveTrace(wakeTrace);
+#endif
   display.hibernate();
 
   Serial.println("Going to deep sleep...");
-  esp_sleep_enable_timer_wakeup(sleepSeconds * 1000000ULL);
+  printPhases();
+  esp_sleep_enable_timer_wakeup(plan.sleepSeconds * 1000000ULL);
   esp_deep_sleep_start();
 }
 
+// The provisioning image's settings over the compiled-in ones
+void loadProvision() {
+  provisioned = provisionLoad(provision);
+  if (!provisioned) {
+    return;
+  }
+  if (provision.dataUrl[0] != '\0') {
+    DATA_URL = provision.dataUrl;
+  }
+  if (strcasecmp(provision.panel, PANEL_NAME) != 0) {
+    // Carry on: the rest of the image still applies to this device
+    Serial.printf("Provision: image is for a %s panel, this firmware drives "
+                  "a %s\n",
+                  provision.panel, PANEL_NAME);
+  }
+}
+
 void setup() {
+#ifdef WAKE_PROFILE
+  profilerBegin();
+#endif
   Serial.begin(115200);
   delay(1000);
+#ifdef QEMU_BUILD
+  phaseScalingBegin(false); // cycle counts come from instruction counting
+#else
+  phaseScalingBegin(CPU_FREQUENCY_SCALING);
+#endif
   // Initialize display
+#ifndef QEMU_BUILD
   display.init(115200, true, 2, false);
+#endif
+  frameStoreBegin();
+  stateLoad(deviceState);
+  loadProvision();
+#ifdef WAKE_TRACE
+  // The RTC keeps wall time through deep sleep; 0 on a cold boot
+  time_t bootTime = time(nullptr) - millis() / 1000;
+  traceBegin(wakeTrace, bootTime >= 1000000000 ? bootTime : 0,
+             esp_sleep_get_wakeup_cause());
+  // Send 't' during the boot delay to dump stored traces, 'x' to also clear
+  if (Serial.available()) {
+    char cmd = Serial.read();
+    if (cmd == 't' || cmd == 'x') {
+      dumpTraces();
+      if (cmd == 'x') {
+        clearTraces();
+      }
+    }
+  }
+#endif
+
+  // Highlight-only wakes never touch the network
+  if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER &&
+      !deviceState.rtc.nextWakeFetches) {
+    restoreTimeZone();
+    if ((PRERENDER_NEXT_FRAME && showPreRenderedFrame()) ||
+        showHighlightFromLastFrame()) {
+      goToSleep();
+    }
+    Serial.println("No usable frame for highlight wake, fetching instead");
+  }
 
   // Connect, fetch, display
-  if (connectWiFi() && fetchPrayerTimes()) {
+  bool fetched = connectWiFi();
+#ifdef SYNC_SERVER
+  fetched = fetched && syncAndDisplay();
+#elif PIPELINE_RENDER && !defined(RENDER_BENCH)
+  fetched = fetched && fetchAndDisplay();
+#else
+  fetched = fetched && fetchPrayerTimes();
+  if (fetched) {
+#ifdef RENDER_BENCH
+    benchmarkRender(); // needs the whole payload before anything is drawn
+#endif
     displayPrayerTimes();
+#ifdef MQTT_BROKER
+    deviceState.rtc.payloadVersion = fetchedPayloadVersion;
+#endif
+  }
+#endif
+  if (fetched) {
+    deviceState.rtc.fetchFailures = 0;
   } else {
-    displayError();
+    handleFetchFailure();
   }
 
   // Sleep for 1 hour then wake up and repeat
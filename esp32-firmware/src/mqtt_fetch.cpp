@@ -0,0 +1,72 @@
+#include "mqtt_fetch.h"
+
+#include <PubSubClient.h>
+#include <WiFi.h>
+
+// Retained messages arrive through the callback while loop() runs
+struct MqttInbox {
+  char versionTopic[64];
+  char payloadTopic[64];
+  bool haveVersion;
+  uint32_t version;
+  bool havePayload;
+  String *payload;
+};
+static MqttInbox inbox;
+
+static void onMessage(char *topic, uint8_t *data, unsigned int len) {
+  if (strcmp(topic, inbox.versionTopic) == 0) {
+    char hex[9] = "";
+    memcpy(hex, data, len < 8 ? len : 8);
+    inbox.version = strtoul(hex, nullptr, 16);
+    inbox.haveVersion = true;
+  } else if (strcmp(topic, inbox.payloadTopic) == 0) {
+    *inbox.payload = "";
+    inbox.payload->concat((const char *)data, len);
+    inbox.havePayload = true;
+  }
+}
+
+static bool waitFor(PubSubClient &mqtt, const bool &flag) {
+  unsigned long start = millis();
+  while (!flag && mqtt.connected() && millis() - start < MQTT_WAIT_MS) {
+    mqtt.loop();
+    delay(1);
+  }
+  return flag;
+}
+
+MqttResult mqttFetch(const char *host, uint16_t port, const char *topic,
+                     uint32_t knownVersion, String &payload) {
+  memset(&inbox, 0, sizeof(inbox));
+  snprintf(inbox.versionTopic, sizeof(inbox.versionTopic), "%s/version",
+           topic);
+  snprintf(inbox.payloadTopic, sizeof(inbox.payloadTopic), "%s/payload",
+           topic);
+  inbox.payload = &payload;
+
+  WiFiClient net;
+  PubSubClient mqtt(net);
+  mqtt.setServer(host, port);
+  mqtt.setBufferSize(MQTT_MAX_PAYLOAD + 128); // plus topic and header
+  mqtt.setCallback(onMessage);
+  // Clean session: nothing is queued for us between wakes
+  String clientId = "eink-" + WiFi.macAddress();
+  if (!mqtt.connect(clientId.c_str())) {
+    Serial.printf("MQTT connect failed: %d\n", mqtt.state());
+    return MQTT_FAILED;
+  }
+
+  MqttResult result = MQTT_FAILED;
+  if (knownVersion != 0 && mqtt.subscribe(inbox.versionTopic) &&
+      waitFor(mqtt, inbox.haveVersion) && inbox.version == knownVersion) {
+    result = MQTT_UNCHANGED;
+  } else if (mqtt.subscribe(inbox.payloadTopic) &&
+             waitFor(mqtt, inbox.havePayload)) {
+    result = MQTT_PAYLOAD;
+  } else {
+    Serial.printf("MQTT: no retained message on %s\n", inbox.payloadTopic);
+  }
+  mqtt.disconnect();
+  return result;
+}
@@ -0,0 +1,32 @@
+/*
+ * Payload over MQTT: retained messages on a LAN broker
+ *
+ * The aggregator publishes the compact payload retained on <topic>/payload
+ * and its version, the FNV-1a hash of those bytes as 8 hex digits, on
+ * <topic>/version. A broker hands retained messages over right after the
+ * subscription, so a fetch is one TCP connect, CONNECT, SUBSCRIBE and the
+ * message, without DNS, TLS or HTTP headers. The version is read first;
+ * when it matches the payload already on the panel, the payload is not
+ * transferred at all.
+ */
+
+#ifndef MQTT_FETCH_H
+#define MQTT_FETCH_H
+
+#include <Arduino.h>
+
+#define MQTT_MAX_PAYLOAD 4096
+// How long to wait for each retained message after subscribing
+#define MQTT_WAIT_MS 3000
+
+enum MqttResult {
+  MQTT_PAYLOAD,   // payload holds the retained payload
+  MQTT_UNCHANGED, // the version equals knownVersion
+  MQTT_FAILED,
+};
+
+// knownVersion 0 always fetches the payload
+MqttResult mqttFetch(const char *host, uint16_t port, const char *topic,
+                     uint32_t knownVersion, String &payload);
+
+#endif
@@ -0,0 +1,83 @@
+#include "network_score.h"
+
+#include <string.h>
+
+#define SCORE_UNKNOWN 40
+#define SCORE_FAILURE_PENALTY 25
+
+// Exponential moving average with weight 1/4 for the new sample
+static int32_t smooth(int32_t avg, int32_t sample, uint8_t samples) {
+  if (samples == 0) {
+    return sample;
+  }
+  return avg + (sample - avg) / 4;
+}
+
+int16_t networkScore(const NetworkStats &stats) {
+  int16_t score = SCORE_UNKNOWN;
+  if (stats.samples > 0) {
+    // -90 dBm -> 10, -30 dBm -> 70
+    int16_t rssi = stats.rssi + 100;
+    score = rssi < 0 ? 0 : (rssi > 70 ? 70 : rssi);
+    // Slow associations usually mean retries; -10 per second
+    score -= stats.assocMs / 100;
+    // Up to +30 for throughput, saturating at 300 kbit/s
+    score += stats.kbps >= 300 ? 30 : stats.kbps / 10;
+  }
+  return score - stats.failures * SCORE_FAILURE_PENALTY;
+}
+
+uint8_t rankNetworks(const NetworkEntry *networks, uint8_t count,
+                     uint8_t *order) {
+  for (uint8_t i = 0; i < count; i++) {
+    order[i] = i;
+  }
+  // Insertion sort, stable so list order breaks ties
+  for (uint8_t i = 1; i < count; i++) {
+    uint8_t v = order[i];
+    int16_t score = networkScore(networks[v].stats);
+    int8_t j = i - 1;
+    while (j >= 0 && networkScore(networks[order[j]].stats) < score) {
+      order[j + 1] = order[j];
+      j--;
+    }
+    order[j + 1] = v;
+  }
+  return count;
+}
+
+void recordAssociation(NetworkStats &stats, int8_t rssi, uint16_t assocMs) {
+  stats.rssi = smooth(stats.rssi, rssi, stats.samples);
+  stats.assocMs = smooth(stats.assocMs, assocMs, stats.samples);
+  if (stats.samples < 255) {
+    stats.samples++;
+  }
+  stats.failures = 0;
+}
+
+void recordThroughput(NetworkStats &stats, uint16_t kbps) {
+  // The first association has already counted as a sample
+  stats.kbps = smooth(stats.kbps, kbps, stats.kbps == 0 ? 0 : stats.samples);
+}
+
+void recordFailure(NetworkStats &stats) {
+  if (stats.failures < 255) {
+    stats.failures++;
+  }
+}
+
+void remapNetworkStats(NetworkStats *stats, const char before[][33],
+                       uint8_t beforeCount, const char after[][33],
+                       uint8_t afterCount) {
+  NetworkStats moved[MAX_NETWORKS];
+  memset(moved, 0, sizeof(moved));
+  for (uint8_t i = 0; i < afterCount && i < MAX_NETWORKS; i++) {
+    for (uint8_t j = 0; j < beforeCount && j < MAX_NETWORKS; j++) {
+      if (strcmp(after[i], before[j]) == 0) {
+        moved[i] = stats[j];
+        break;
+      }
+    }
+  }
+  memcpy(stats, moved, sizeof(moved));
+}
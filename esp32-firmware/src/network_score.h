@@ -0,0 +1,49 @@
+/*
+ * WiFi network ranking from past connection quality
+ *
+ * Each known network keeps smoothed RSSI, association time and transfer
+ * throughput from earlier wakes plus a count of consecutive failures. The
+ * best-scoring network is tried first.
+ */
+
+#ifndef NETWORK_SCORE_H
+#define NETWORK_SCORE_H
+
+#include <stdint.h>
+
+#define MAX_NETWORKS 6
+
+struct NetworkStats {
+  uint8_t samples; // successful associations seen, saturates
+  int8_t rssi;     // dBm
+  uint16_t assocMs;
+  uint16_t kbps;
+  uint8_t failures; // consecutive
+};
+
+struct NetworkEntry {
+  char ssid[33];
+  char password[65];
+  NetworkStats stats;
+};
+
+// Higher is better. Networks without history get a neutral score so they
+// are tried after good known ones but before failing ones.
+int16_t networkScore(const NetworkStats &stats);
+
+// Fills order with indices sorted best first; returns count
+uint8_t rankNetworks(const NetworkEntry *networks, uint8_t count,
+                     uint8_t *order);
+
+// Stats are kept per slot. When the list changes, moves each network's
+// stats to the slot its SSID has in the new list; new SSIDs start without
+// history.
+void remapNetworkStats(NetworkStats *stats, const char before[][33],
+                       uint8_t beforeCount, const char after[][33],
+                       uint8_t afterCount);
+
+void recordAssociation(NetworkStats &stats, int8_t rssi, uint16_t assocMs);
+void recordThroughput(NetworkStats &stats, uint16_t kbps);
+void recordFailure(NetworkStats &stats);
+
+#endif
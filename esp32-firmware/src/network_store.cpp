@@ -0,0 +1,86 @@
+#include "network_store.h"
+
+#include "secrets.h"
+#include <Arduino.h>
+#include <Preferences.h>
+
+#define WIFI_NAMESPACE "wifi"
+
+// Optional extra networks in secrets.h, e.g.
+// #define WIFI_NETWORKS {"Office", "pw1"}, {"Hotspot", "pw2"}
+struct SeedNetwork {
+  const char *ssid;
+  const char *password;
+};
+static const SeedNetwork SEED_NETWORKS[] = {
+    {WIFI_SSID, WIFI_PASSWORD},
+#ifdef WIFI_NETWORKS
+    WIFI_NETWORKS
+#endif
+};
+
+static void storeNetwork(Preferences &prefs, uint8_t i, const char *ssid,
+                         const char *password) {
+  char key[8];
+  snprintf(key, sizeof(key), "ssid%u", i);
+  prefs.putString(key, ssid);
+  snprintf(key, sizeof(key), "pass%u", i);
+  prefs.putString(key, password);
+}
+
+uint8_t loadNetworks(NetworkEntry *networks, const ProvisionConfig *provision,
+                     uint32_t tag, NetworkStats *stats) {
+  Preferences prefs;
+  prefs.begin(WIFI_NAMESPACE, false);
+
+  uint8_t count = prefs.getUChar("count", 0);
+  if (provision && provision->networkCount > 0 &&
+      prefs.getUInt("provision", 0) != tag) {
+    char before[MAX_NETWORKS][33];
+    uint8_t beforeCount = count < MAX_NETWORKS ? count : MAX_NETWORKS;
+    for (uint8_t i = 0; i < beforeCount; i++) {
+      char key[8];
+      snprintf(key, sizeof(key), "ssid%u", i);
+      if (!prefs.getString(key, before[i], sizeof(before[i]))) {
+        before[i][0] = '\0';
+      }
+    }
+    char after[MAX_NETWORKS][33];
+    count = provision->networkCount;
+    for (uint8_t i = 0; i < count; i++) {
+      storeNetwork(prefs, i, provision->networks[i].ssid,
+                   provision->networks[i].password);
+      strlcpy(after[i], provision->networks[i].ssid, sizeof(after[i]));
+    }
+    remapNetworkStats(stats, before, beforeCount, after, count);
+    prefs.putUChar("count", count);
+    prefs.putUInt("provision", tag);
+    Serial.printf("Stored %u WiFi networks from the provisioning image\n",
+                  count);
+  } else if (count == 0) {
+    count = sizeof(SEED_NETWORKS) / sizeof(SEED_NETWORKS[0]);
+    if (count > MAX_NETWORKS) {
+      count = MAX_NETWORKS;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+      storeNetwork(prefs, i, SEED_NETWORKS[i].ssid, SEED_NETWORKS[i].password);
+    }
+    prefs.putUChar("count", count);
+    Serial.printf("Seeded %u WiFi networks from secrets.h\n", count);
+  }
+  if (count > MAX_NETWORKS) {
+    count = MAX_NETWORKS;
+  }
+
+  for (uint8_t i = 0; i < count; i++) {
+    NetworkEntry &n = networks[i];
+    char key[8];
+    snprintf(key, sizeof(key), "ssid%u", i);
+    prefs.getString(key, n.ssid, sizeof(n.ssid));
+    snprintf(key, sizeof(key), "pass%u", i);
+    prefs.getString(key, n.password, sizeof(n.password));
+    memset(&n.stats, 0, sizeof(n.stats));
+  }
+  prefs.end();
+  return count;
+}
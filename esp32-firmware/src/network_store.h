@@ -0,0 +1,24 @@
+/*
+ * Known WiFi networks, persisted in NVS
+ *
+ * Seeded from WIFI_SSID/WIFI_PASSWORD (and WIFI_NETWORKS, if defined) in
+ * secrets.h on first boot, or provisioned directly into the "wifi" NVS
+ * namespace. A provisioning image (provision.h) with networks replaces
+ * them, once per image flashed. Their stats live in the device state
+ * (device_state.h).
+ */
+
+#ifndef NETWORK_STORE_H
+#define NETWORK_STORE_H
+
+#include "network_score.h"
+#include "provision.h"
+
+// Stats are left zeroed. provision may be null; tag tells its image from
+// the one the networks were last taken from (provisionTag()). When the
+// image replaces the list, stats (per slot, MAX_NETWORKS of them) are
+// moved along with their SSIDs.
+uint8_t loadNetworks(NetworkEntry *networks, const ProvisionConfig *provision,
+                     uint32_t tag, NetworkStats *stats);
+
+#endif
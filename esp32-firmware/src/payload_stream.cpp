@@ -0,0 +1,152 @@
+#include "payload_stream.h"
+
+#include "render_model.h"
+#include <string.h>
+
+static bool isSpace(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+void payloadBegin(PayloadSplitter &s) {
+  memset(&s, 0, sizeof(s));
+  s.state = PAYLOAD_START;
+}
+
+static void emit(PayloadSplitter &s, PayloadSectionSink sink, void *ctx) {
+  // Trailing whitespace of a number, true, false or null
+  while (s.len > 0 && isSpace(s.value[s.len - 1])) {
+    s.len--;
+  }
+  if (s.overflow || s.keyLen >= PAYLOAD_MAX_KEY) {
+    s.skipped++;
+  } else {
+    s.key[s.keyLen] = '\0';
+    s.sections++;
+    sink(s.key, s.value, s.len, ctx);
+  }
+  s.keyLen = 0;
+  s.len = 0;
+  s.overflow = false;
+}
+
+static void append(PayloadSplitter &s, char c) {
+  if (s.len < PAYLOAD_MAX_SECTION) {
+    s.value[s.len++] = c;
+  } else {
+    s.overflow = true;
+  }
+}
+
+bool payloadFeed(PayloadSplitter &s, const uint8_t *data, size_t len,
+                 PayloadSectionSink sink, void *ctx) {
+  for (size_t i = 0; i < len && s.state != PAYLOAD_ERROR; i++) {
+    char c = (char)data[i];
+    switch (s.state) {
+    case PAYLOAD_START:
+      if (c == '{') {
+        s.state = PAYLOAD_BEFORE_KEY;
+      } else if (!isSpace(c)) {
+        s.state = PAYLOAD_ERROR;
+      }
+      break;
+    case PAYLOAD_BEFORE_KEY:
+      if (c == '"') {
+        s.state = PAYLOAD_KEY;
+      } else if (c == '}' && s.sections + s.skipped == 0) {
+        s.state = PAYLOAD_DONE;
+      } else if (!isSpace(c)) {
+        s.state = PAYLOAD_ERROR;
+      }
+      break;
+    case PAYLOAD_KEY:
+      // Keys we look up have no escapes; keep escaped characters verbatim
+      if (s.escaped) {
+        s.escaped = false;
+      } else if (c == '\\') {
+        s.escaped = true;
+        break;
+      } else if (c == '"') {
+        s.state = PAYLOAD_AFTER_KEY;
+        break;
+      }
+      if (s.keyLen < PAYLOAD_MAX_KEY) {
+        s.key[s.keyLen++] = c;
+      }
+      break;
+    case PAYLOAD_AFTER_KEY:
+      if (c == ':') {
+        s.state = PAYLOAD_BEFORE_VALUE;
+      } else if (!isSpace(c)) {
+        s.state = PAYLOAD_ERROR;
+      }
+      break;
+    case PAYLOAD_BEFORE_VALUE:
+      if (isSpace(c)) {
+        break;
+      }
+      if (c == ',' || c == '}' || c == ']' || c == ':') {
+        s.state = PAYLOAD_ERROR;
+        break;
+      }
+      s.state = PAYLOAD_VALUE;
+      // fall through
+    case PAYLOAD_VALUE:
+      if (s.inString) {
+        if (s.escaped) {
+          s.escaped = false;
+        } else if (c == '\\') {
+          s.escaped = true;
+        } else if (c == '"') {
+          s.inString = false;
+        }
+      } else if (c == '"') {
+        s.inString = true;
+      } else if (c == '{' || c == '[') {
+        s.depth++;
+      } else if (c == '}' || c == ']') {
+        if (s.depth == 0) {
+          if (c == ']') {
+            s.state = PAYLOAD_ERROR;
+            break;
+          }
+          emit(s, sink, ctx);
+          s.state = PAYLOAD_DONE;
+          break;
+        }
+        s.depth--;
+      } else if (c == ',' && s.depth == 0) {
+        emit(s, sink, ctx);
+        s.state = PAYLOAD_BEFORE_KEY;
+        break;
+      }
+      append(s, c);
+      break;
+    case PAYLOAD_DONE:
+      if (!isSpace(c)) {
+        s.state = PAYLOAD_ERROR;
+      }
+      break;
+    case PAYLOAD_ERROR:
+      break;
+    }
+  }
+  return s.state != PAYLOAD_ERROR;
+}
+
+bool payloadComplete(const PayloadSplitter &s) {
+  return s.state == PAYLOAD_DONE;
+}
+
+uint8_t payloadSectionWidgets(const char *key) {
+  if (strcmp(key, "location") == 0) {
+    return WIDGET_HEADER;
+  }
+  if (strcmp(key, "prayer_times") == 0) {
+    return WIDGET_PRAYERS;
+  }
+  if (strcmp(key, "weather") == 0) {
+    return WIDGET_ICON | WIDGET_TEMPERATURE | WIDGET_CONDITION |
+           WIDGET_FORECAST_0 | WIDGET_FORECAST_1 | WIDGET_FORECAST_2;
+  }
+  return 0;
+}
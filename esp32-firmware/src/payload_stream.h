@@ -0,0 +1,65 @@
+/*
+ * Splits the display payload into its top-level members while it downloads
+ *
+ * The payload is one JSON object whose members are independent sections
+ * ("location", "prayer_times", "weather", ...). Bytes are fed as they
+ * arrive; each member is handed to a callback, as raw JSON text, as soon as
+ * its value is complete, so it can be parsed and drawn while the rest is
+ * still in flight. The aggregator writes the prayer sections first.
+ *
+ * Only nesting and strings are tracked here; the member text is validated
+ * by whatever parses it. Members longer than PAYLOAD_MAX_SECTION are
+ * skipped and counted.
+ */
+
+#ifndef PAYLOAD_STREAM_H
+#define PAYLOAD_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PAYLOAD_MAX_KEY 24
+#define PAYLOAD_MAX_SECTION 2048
+
+// value is not null-terminated
+typedef void (*PayloadSectionSink)(const char *key, const char *value,
+                                   size_t len, void *ctx);
+
+enum PayloadState : uint8_t {
+  PAYLOAD_START,
+  PAYLOAD_BEFORE_KEY,
+  PAYLOAD_KEY,
+  PAYLOAD_AFTER_KEY,
+  PAYLOAD_BEFORE_VALUE,
+  PAYLOAD_VALUE,
+  PAYLOAD_DONE,
+  PAYLOAD_ERROR
+};
+
+struct PayloadSplitter {
+  PayloadState state;
+  bool inString;
+  bool escaped;
+  bool overflow;
+  uint8_t depth;
+  uint8_t keyLen;
+  char key[PAYLOAD_MAX_KEY];
+  size_t len;
+  char value[PAYLOAD_MAX_SECTION];
+  uint8_t sections;
+  uint8_t skipped;
+};
+
+void payloadBegin(PayloadSplitter &s);
+
+// False once the input can't be a JSON object
+bool payloadFeed(PayloadSplitter &s, const uint8_t *data, size_t len,
+                 PayloadSectionSink sink, void *ctx);
+
+// True after the object's closing brace
+bool payloadComplete(const PayloadSplitter &s);
+
+// Screen widgets drawn from a top-level member (0 for none)
+uint8_t payloadSectionWidgets(const char *key);
+
+#endif
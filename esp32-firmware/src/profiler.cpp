@@ -0,0 +1,302 @@
+#include "profiler.h"
+
+// Only built in with -DWAKE_PROFILE: the sample buffer is not small
+#ifdef WAKE_PROFILE
+
+#include "wake_phases.h"
+#include <Arduino.h>
+#include <esp_debug_helpers.h>
+#include <esp_idf_version.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <xtensa/hal.h>
+#include <xtensa/xtensa_context.h>
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+// Needs CONFIG_GPTIMER_ISR_IRAM_SAFE to sample while the cache is off
+#include <driver/gptimer.h>
+#include <esp_cpu_utils.h>
+#include <esp_memory_utils.h>
+#define PROFILE_GPTIMER
+#else
+// Arduino core 2.x is on IDF 4.4, which has no gptimer yet
+#include <driver/timer.h>
+#include <esp_cpu.h>
+#include <soc/soc_memory_types.h>
+// timerBegin() hands out group 0 first
+#define PROFILE_TIMER_GROUP TIMER_GROUP_1
+#define PROFILE_TIMER_DIVIDER 80 // 1 MHz from the 80 MHz APB clock
+#endif
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+#include <esp_private/freertos_debug.h>
+#else
+#include <freertos/task_snapshot.h>
+#endif
+
+struct ProfileSample {
+  uint32_t pc[PROFILE_DEPTH];
+  uint8_t depth;
+  uint8_t core;
+  uint8_t task; // index into tasks
+  uint8_t phase;
+};
+
+// Written from the timer interrupts only while running; the interrupts are
+// in IRAM and may fire while the flash cache is off, so everything they
+// touch lives in internal RAM. Tasks are recorded by handle only; their
+// names are looked up when the samples are printed.
+static ProfileSample samples[PROFILE_SAMPLES];
+static TaskHandle_t tasks[PROFILE_TASKS];
+static volatile uint32_t sampleCount;
+static volatile uint32_t dropped;
+static volatile uint32_t idleSamples[portNUM_PROCESSORS];
+static volatile uint32_t unnamedSamples;
+static TaskHandle_t idleTasks[portNUM_PROCESSORS];
+static volatile bool running;
+static portMUX_TYPE profileLock = portMUX_INITIALIZER_UNLOCKED;
+// The sampling handler's own cost, in cycles of the core it ran on;
+// interrupt entry and exit come on top
+static volatile uint32_t isrCount;
+static volatile uint64_t isrCycles;
+static volatile uint32_t isrMaxCycles;
+static int64_t startUs;
+static int64_t stopUs;
+
+static uint8_t IRAM_ATTR taskIndex(TaskHandle_t handle) {
+  for (uint8_t i = 0; i < PROFILE_TASKS; i++) {
+    if (tasks[i] == handle) {
+      return i;
+    }
+    if (tasks[i] == nullptr) {
+      tasks[i] = handle;
+      return i;
+    }
+  }
+  return PROFILE_TASKS;
+}
+
+static void IRAM_ATTR countCycles(uint32_t start) {
+  uint32_t cycles = xthal_get_ccount() - start;
+  portENTER_CRITICAL_ISR(&profileLock);
+  isrCount++;
+  isrCycles += cycles;
+  if (cycles > isrMaxCycles) {
+    isrMaxCycles = cycles;
+  }
+  portEXIT_CRITICAL_ISR(&profileLock);
+}
+
+static void IRAM_ATTR takeSample() {
+  uint8_t core = xPortGetCoreID();
+  TaskHandle_t task = xTaskGetCurrentTaskHandleForCPU(core);
+  if (task == idleTasks[core]) {
+    idleSamples[core]++;
+    return;
+  }
+
+  // The interrupt entry (_frxt_int_enter) saved the interrupted task's
+  // frame, register windows spilled, and left a pointer to it as the
+  // task's top of stack, which the snapshot returns. Level 1 interrupts
+  // don't nest, so it is the task this interrupt stopped.
+  // (FreeRTOS keeps the snapshot code in IRAM by default)
+  TaskSnapshot_t snapshot;
+  vTaskGetSnapshot(task, &snapshot);
+  const XtExcFrame *frame = (const XtExcFrame *)snapshot.pxTopOfStack;
+  portENTER_CRITICAL_ISR(&profileLock);
+  uint32_t slot = sampleCount;
+  uint8_t index = taskIndex(task);
+  if (slot >= PROFILE_SAMPLES || index == PROFILE_TASKS) {
+    if (slot >= PROFILE_SAMPLES) {
+      dropped++;
+    } else {
+      unnamedSamples++;
+    }
+    portEXIT_CRITICAL_ISR(&profileLock);
+    return;
+  }
+  sampleCount = slot + 1;
+  portEXIT_CRITICAL_ISR(&profileLock);
+
+  ProfileSample &s = samples[slot];
+  s.core = core;
+  s.task = index;
+  s.phase = currentPhase();
+  // The leaf is where the task stopped; the callers are return addresses,
+  // which esp_cpu_process_stack_pc() moves back into the call instruction
+  esp_backtrace_frame_t bt;
+  bt.pc = (uint32_t)frame->pc;
+  bt.sp = (uint32_t)frame->a1;
+  bt.next_pc = (uint32_t)frame->a0;
+  uint8_t depth = 0;
+  s.pc[depth++] = bt.pc;
+  while (depth < PROFILE_DEPTH && bt.next_pc != 0 &&
+         esp_backtrace_get_next_frame(&bt) &&
+         esp_stack_ptr_is_sane(bt.sp) &&
+         esp_ptr_executable(
+             (void *)(uintptr_t)esp_cpu_process_stack_pc(bt.pc))) {
+    s.pc[depth++] = esp_cpu_process_stack_pc(bt.pc);
+  }
+  s.depth = depth;
+}
+
+// Rounded down to an odd period in microseconds, so it can't lock step with
+// the 1 kHz tick or anything else on a round interval
+#define PROFILE_PERIOD_US ((1000000 / PROFILE_HZ) | 1)
+
+#ifdef PROFILE_GPTIMER
+static gptimer_handle_t timers[portNUM_PROCESSORS];
+
+static bool IRAM_ATTR onSample(gptimer_handle_t,
+                               const gptimer_alarm_event_data_t *, void *) {
+  uint32_t start = xthal_get_ccount();
+  if (running) {
+    takeSample();
+    countCycles(start);
+  }
+  return false;
+}
+
+// The interrupt is allocated on the core that registers the callback
+static void startTimer(int core) {
+  gptimer_config_t config = {};
+  config.clk_src = GPTIMER_CLK_SRC_DEFAULT;
+  config.direction = GPTIMER_COUNT_UP;
+  config.resolution_hz = 1000000;
+  ESP_ERROR_CHECK(gptimer_new_timer(&config, &timers[core]));
+  gptimer_event_callbacks_t callbacks = {};
+  callbacks.on_alarm = onSample;
+  ESP_ERROR_CHECK(
+      gptimer_register_event_callbacks(timers[core], &callbacks, nullptr));
+  gptimer_alarm_config_t alarm = {};
+  alarm.alarm_count = PROFILE_PERIOD_US;
+  alarm.flags.auto_reload_on_alarm = true;
+  ESP_ERROR_CHECK(gptimer_set_alarm_action(timers[core], &alarm));
+  ESP_ERROR_CHECK(gptimer_enable(timers[core]));
+  ESP_ERROR_CHECK(gptimer_start(timers[core]));
+}
+
+static void stopTimers() {
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    if (timers[core]) {
+      gptimer_stop(timers[core]);
+    }
+  }
+}
+#else
+static bool IRAM_ATTR onSample(void *) {
+  uint32_t start = xthal_get_ccount();
+  if (running) {
+    takeSample();
+    countCycles(start);
+  }
+  return false;
+}
+
+// The timer interrupt is allocated on the core that installs it
+static void startTimer(int core) {
+  timer_idx_t timer = core == 0 ? TIMER_0 : TIMER_1;
+  timer_config_t config = {};
+  config.divider = PROFILE_TIMER_DIVIDER;
+  config.counter_dir = TIMER_COUNT_UP;
+  config.counter_en = TIMER_PAUSE;
+  config.alarm_en = TIMER_ALARM_EN;
+  config.auto_reload = TIMER_AUTORELOAD_EN;
+  timer_init(PROFILE_TIMER_GROUP, timer, &config);
+  timer_set_counter_value(PROFILE_TIMER_GROUP, timer, 0);
+  timer_set_alarm_value(PROFILE_TIMER_GROUP, timer, PROFILE_PERIOD_US);
+  timer_enable_intr(PROFILE_TIMER_GROUP, timer);
+  timer_isr_callback_add(PROFILE_TIMER_GROUP, timer, onSample, nullptr,
+                         ESP_INTR_FLAG_IRAM | ESP_INTR_FLAG_LEVEL1);
+  timer_start(PROFILE_TIMER_GROUP, timer);
+}
+
+static void stopTimers() {
+  timer_pause(PROFILE_TIMER_GROUP, TIMER_0);
+  timer_pause(PROFILE_TIMER_GROUP, TIMER_1);
+}
+#endif
+
+static void startTimerTask(void *done) {
+  startTimer(0);
+  xSemaphoreGive((SemaphoreHandle_t)done);
+  vTaskDelete(nullptr);
+}
+
+void profilerBegin() {
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    idleTasks[core] = xTaskGetIdleTaskHandleForCPU(core);
+  }
+  startUs = esp_timer_get_time();
+  running = true;
+  // setup() runs on core 1; core 0 gets its timer from a task pinned there
+  SemaphoreHandle_t done = xSemaphoreCreateBinary();
+  xTaskCreatePinnedToCore(startTimerTask, "profile", 2048, done, 1, nullptr,
+                          0);
+  xSemaphoreTake(done, portMAX_DELAY);
+  vSemaphoreDelete(done);
+  startTimer(1);
+}
+
+void profilerStop() {
+  if (running) {
+    running = false;
+    stopUs = esp_timer_get_time();
+  }
+  stopTimers();
+}
+
+// Names the sampled tasks that still exist; the rest ran and were deleted
+// during the wake (the timer starter, a finished refresh task)
+static void printTaskNames() {
+#if configUSE_TRACE_FACILITY
+  static TaskStatus_t status[32];
+  UBaseType_t count =
+      uxTaskGetSystemState(status, sizeof(status) / sizeof(status[0]), nullptr);
+  for (uint8_t i = 0; i < PROFILE_TASKS && tasks[i]; i++) {
+    const char *name = "(exited)";
+    for (UBaseType_t j = 0; j < count; j++) {
+      if (status[j].xHandle == tasks[i]) {
+        name = status[j].pcTaskName;
+        break;
+      }
+    }
+    Serial.printf("PROFILE task %u %s\n", i, name);
+  }
+#else
+  for (uint8_t i = 0; i < PROFILE_TASKS && tasks[i]; i++) {
+    Serial.printf("PROFILE task %u %p\n", i, tasks[i]);
+  }
+#endif
+}
+
+void profilerDump() {
+  profilerStop();
+  Serial.printf("PROFILE hz=%u samples=%lu dropped=%lu unnamed=%lu", PROFILE_HZ,
+                (unsigned long)sampleCount, (unsigned long)dropped,
+                (unsigned long)unnamedSamples);
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    Serial.printf(" idle%d=%lu", core, (unsigned long)idleSamples[core]);
+  }
+  // What sampling cost: interrupts taken, their mean and worst cycles, and
+  // the time they were spread over
+  Serial.printf(" isr=%lu isr_cycles=%lu isr_max_cycles=%lu wall_ms=%lu\n",
+                (unsigned long)isrCount,
+                (unsigned long)(isrCount ? isrCycles / isrCount : 0),
+                (unsigned long)isrMaxCycles,
+                (unsigned long)((stopUs - startUs) / 1000));
+  printTaskNames();
+  for (int i = 0; i < PHASE_COUNT; i++) {
+    Serial.printf("PROFILE phase %d %s\n", i, phaseName((WakePhase)i));
+  }
+  // core task phase, then the stack innermost first
+  for (uint32_t i = 0; i < sampleCount; i++) {
+    const ProfileSample &s = samples[i];
+    Serial.printf("PROFILE s %u %u %u", s.core, s.task, s.phase);
+    for (uint8_t d = 0; d < s.depth; d++) {
+      Serial.printf(" %08lx", (unsigned long)s.pc[d]);
+    }
+    Serial.println();
+  }
+}
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * Sampling profiler for one wake, built with -DWAKE_PROFILE (pio run -e
+ * profile); device images leave it out
+ *
+ * A hardware timer per core (gptimer on IDF 5, the legacy timer driver on
+ * the Arduino core's IDF 4.4) interrupts PROFILE_HZ times a second and
+ * records the interrupted program counter, a short backtrace, the task
+ * handle and the wake phase (wake_phases.h) into a RAM buffer. Samples in
+ * the idle tasks are only counted. profilerDump() names the tasks and
+ * prints the buffer over serial as "PROFILE" lines at the end of the wake;
+ * tools/profile_report.py symbolizes them against the firmware ELF into a
+ * flat profile and collapsed stacks for flame graphs.
+ *
+ * The dump's header carries the handler's mean and worst cycle count, so
+ * the sampling cost is measured on every run rather than assumed.
+ *
+ * The timer interrupt runs at level 1, so code that runs with interrupts
+ * masked (critical sections, other ISRs) is charged to the instruction
+ * where they were unmasked. When the buffer is full, further samples are
+ * counted as dropped; raise PROFILE_SAMPLES or lower PROFILE_HZ.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+// 10 ms steps; two busy cores fill 1024 samples in about 5 s
+#ifndef PROFILE_HZ
+#define PROFILE_HZ 100
+#endif
+#ifndef PROFILE_SAMPLES
+#define PROFILE_SAMPLES 1024
+#endif
+#define PROFILE_DEPTH 12 // frames per sample, innermost first
+#define PROFILE_TASKS 16 // distinct tasks named in a dump
+
+// Starts sampling on both cores; call as early in setup() as possible
+void profilerBegin();
+void profilerStop();
+// Prints the header, task and phase names, and one line per sample
+void profilerDump();
+
+#endif
@@ -0,0 +1,95 @@
+#include "provision.h"
+
+#include "crc32.h"
+#include <stdio.h>
+#include <string.h>
+
+size_t provisionSize(uint16_t days) {
+  return PROVISION_DAYS_OFFSET + (size_t)days * sizeof(CalendarDay);
+}
+
+static uint32_t provisionCrc(const uint8_t *image, uint16_t days) {
+  uint32_t crc = crc32(0, image, offsetof(ProvisionHeader, crc));
+  return crc32(crc, image + PROVISION_CONFIG_OFFSET,
+               provisionSize(days) - PROVISION_CONFIG_OFFSET);
+}
+
+size_t provisionBuild(uint8_t *buf, size_t size, const ProvisionConfig &config,
+                      int32_t firstDay, const CalendarDay *days,
+                      uint16_t count) {
+  size_t total = provisionSize(count);
+  if (count > PROVISION_MAX_DAYS || total > size) {
+    return 0;
+  }
+  ProvisionHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = PROVISION_MAGIC;
+  header.version = PROVISION_VERSION;
+  header.configSize = sizeof(ProvisionConfig);
+  header.firstDay = firstDay;
+  header.days = count;
+
+  // The caller's copy may have garbage in its padding; the CRC covers it
+  ProvisionConfig clean;
+  memset(&clean, 0, sizeof(clean));
+  memcpy(clean.deviceId, config.deviceId, sizeof(clean.deviceId));
+  memcpy(clean.location, config.location, sizeof(clean.location));
+  memcpy(clean.dataUrl, config.dataUrl, sizeof(clean.dataUrl));
+  memcpy(clean.panel, config.panel, sizeof(clean.panel));
+  clean.wakeOffsetMin = config.wakeOffsetMin;
+  clean.networkCount = config.networkCount;
+  memcpy(clean.networks, config.networks, sizeof(clean.networks));
+
+  memcpy(buf, &header, sizeof(header));
+  memcpy(buf + PROVISION_CONFIG_OFFSET, &clean, sizeof(clean));
+  memcpy(buf + PROVISION_DAYS_OFFSET, days, count * sizeof(CalendarDay));
+  header.crc = provisionCrc(buf, count);
+  memcpy(buf, &header, sizeof(header));
+  return total;
+}
+
+bool provisionParse(const uint8_t *buf, size_t size, ProvisionHeader &header,
+                    ProvisionConfig &config) {
+  if (size < sizeof(header)) {
+    return false;
+  }
+  memcpy(&header, buf, sizeof(header));
+  if (header.magic != PROVISION_MAGIC ||
+      header.version != PROVISION_VERSION ||
+      header.configSize != sizeof(ProvisionConfig) ||
+      header.days > PROVISION_MAX_DAYS ||
+      provisionSize(header.days) > size ||
+      header.crc != provisionCrc(buf, header.days)) {
+    return false;
+  }
+  memcpy(&config, buf + PROVISION_CONFIG_OFFSET, sizeof(config));
+  // Strings are terminated by the builder; make sure of it anyway
+  config.deviceId[sizeof(config.deviceId) - 1] = '\0';
+  config.location[sizeof(config.location) - 1] = '\0';
+  config.dataUrl[sizeof(config.dataUrl) - 1] = '\0';
+  config.panel[sizeof(config.panel) - 1] = '\0';
+  if (config.networkCount > MAX_NETWORKS) {
+    config.networkCount = MAX_NETWORKS;
+  }
+  return true;
+}
+
+bool modelFromCalendar(const char *location, const CalendarDay &day,
+                       RenderModel &model) {
+  memset(&model, 0, sizeof(model)); // padding too, models are hashed
+  modelSetString(model.location, sizeof(model.location), location);
+  for (int i = 0; i < 6; i++) {
+    uint16_t minute = day.prayers[i];
+    if (minute >= 24 * 60) {
+      return false;
+    }
+    char hhmm[8];
+    snprintf(hhmm, sizeof(hhmm), "%02u:%02u", (unsigned)(minute / 60),
+             (unsigned)(minute % 60));
+    modelSetString(model.prayers[i], sizeof(model.prayers[i]), hhmm);
+  }
+  // Says why there is no weather; temperature and forecasts stay zero
+  modelSetString(model.condition, sizeof(model.condition), "Offline");
+  model.highlight = -1;
+  return true;
+}
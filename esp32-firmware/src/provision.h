@@ -0,0 +1,80 @@
+/*
+ * Per-device provisioning image, flashed next to one generic firmware image
+ *
+ * tools/provision_images builds one image per device of a fleet: its ID,
+ * location, data URL, WiFi networks, data wake offset and panel type,
+ * followed by an offline calendar of prayer times for the location. It
+ * goes into the "provision" partition (partitions.csv), which the firmware
+ * only reads (provision_store.h). The layout is a header (magic, version,
+ * sizes, CRC-32), the ProvisionConfig and header.days CalendarDays; the
+ * rest of the partition stays erased. Bump PROVISION_VERSION when the
+ * layout changes; the firmware then ignores older images.
+ */
+
+#ifndef PROVISION_H
+#define PROVISION_H
+
+#include "network_score.h"
+#include "render_model.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define PROVISION_MAGIC 0x31565250 // "PRV1"
+#define PROVISION_VERSION 1
+// A year and then some: long enough to outlast a stock of spare panels
+#define PROVISION_MAX_DAYS 400
+#define CALENDAR_NO_TIME 0xFFFF
+
+struct ProvisionNetwork {
+  char ssid[33];
+  char password[65];
+};
+
+struct ProvisionConfig {
+  char deviceId[24];
+  char location[32];
+  char dataUrl[160]; // empty for the firmware's DATA_URL
+  char panel[16];    // the panel the image was built for
+  int16_t wakeOffsetMin; // added to the daily data wake, spreads a fleet
+  uint8_t networkCount;
+  ProvisionNetwork networks[MAX_NETWORKS];
+};
+
+// Fajr to isha in minutes of the local day, CALENDAR_NO_TIME if unknown
+struct CalendarDay {
+  uint16_t prayers[6];
+};
+
+struct ProvisionHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t configSize;
+  int32_t firstDay; // daysFromCivil() of the calendar's first day
+  uint16_t days;
+  uint16_t reserved;
+  uint32_t crc; // over the header up to here, the config and the days
+};
+
+#define PROVISION_CONFIG_OFFSET sizeof(ProvisionHeader)
+#define PROVISION_DAYS_OFFSET \
+  (sizeof(ProvisionHeader) + sizeof(ProvisionConfig))
+
+// Bytes an image with this many calendar days takes
+size_t provisionSize(uint16_t days);
+
+// Writes an image to buf, zeroing the config's padding; returns its size,
+// or 0 if it would not fit in size bytes or has too many days
+size_t provisionBuild(uint8_t *buf, size_t size, const ProvisionConfig &config,
+                      int32_t firstDay, const CalendarDay *days,
+                      uint16_t count);
+
+// Checks an image read back whole and copies out its header and config
+bool provisionParse(const uint8_t *buf, size_t size, ProvisionHeader &header,
+                    ProvisionConfig &config);
+
+// A model with the day's prayer times and no weather; false if a time is
+// missing. The highlight is left at -1.
+bool modelFromCalendar(const char *location, const CalendarDay &day,
+                       RenderModel &model);
+
+#endif
@@ -0,0 +1,63 @@
+#include "provision_store.h"
+
+#include <Arduino.h>
+#include <esp_partition.h>
+
+#define PROVISION_PARTITION "provision"
+
+// Zeroed until an image was loaded
+static ProvisionHeader header;
+
+static const esp_partition_t *provisionPartition() {
+  static const esp_partition_t *partition = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, PROVISION_PARTITION);
+  return partition;
+}
+
+bool provisionLoad(ProvisionConfig &config) {
+  unsigned long t0 = micros();
+  memset(&header, 0, sizeof(header));
+  const esp_partition_t *p = provisionPartition();
+  ProvisionHeader probe;
+  if (!p || esp_partition_read(p, 0, &probe, sizeof(probe)) != ESP_OK ||
+      probe.magic != PROVISION_MAGIC || probe.days > PROVISION_MAX_DAYS) {
+    Serial.println("Provision: none, using the built-in configuration");
+    return false;
+  }
+  // The whole image, once, for the CRC; about 5 KB for a year
+  size_t size = provisionSize(probe.days);
+  if (size > p->size) {
+    Serial.println("Provision: image larger than its partition, ignored");
+    return false;
+  }
+  uint8_t *image = (uint8_t *)malloc(size);
+  ProvisionHeader parsed;
+  bool ok = image && esp_partition_read(p, 0, image, size) == ESP_OK &&
+            provisionParse(image, size, parsed, config);
+  free(image);
+  if (!ok) {
+    Serial.println("Provision: invalid image, using the built-in "
+                   "configuration");
+    return false;
+  }
+  header = parsed;
+  Serial.printf("Provision: %s (%s), %u calendar days, in %lu us\n",
+                config.deviceId, config.location, header.days,
+                micros() - t0);
+  return true;
+}
+
+uint32_t provisionTag() {
+  return header.magic == PROVISION_MAGIC ? header.crc : 0;
+}
+
+bool provisionCalendarDay(int32_t day, CalendarDay &out) {
+  const esp_partition_t *p = provisionPartition();
+  if (!p || header.magic != PROVISION_MAGIC || day < header.firstDay ||
+      day - header.firstDay >= header.days) {
+    return false;
+  }
+  size_t offset =
+      PROVISION_DAYS_OFFSET + (size_t)(day - header.firstDay) * sizeof(out);
+  return esp_partition_read(p, offset, &out, sizeof(out)) == ESP_OK;
+}
@@ -0,0 +1,24 @@
+/*
+ * The provisioning image (provision.h) in the "provision" partition
+ *
+ * Read once at boot and checked whole; the calendar then stays in flash
+ * and only the day asked for is read. Without a valid image the firmware
+ * runs on its compile-time configuration, as before.
+ */
+
+#ifndef PROVISION_STORE_H
+#define PROVISION_STORE_H
+
+#include "provision.h"
+
+// False if there is no partition or no valid image in it
+bool provisionLoad(ProvisionConfig &config);
+
+// The CRC of the loaded image, to tell a reflashed one from the last; 0
+// without one
+uint32_t provisionTag();
+
+// The calendar's entry for a daysFromCivil() day; false outside it
+bool provisionCalendarDay(int32_t day, CalendarDay &out);
+
+#endif
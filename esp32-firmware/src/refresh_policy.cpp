@@ -0,0 +1,30 @@
+#include "refresh_policy.h"
+
+#include <string.h>
+
+uint8_t significantWidgets(const RefreshPolicy &policy,
+                           const RenderModel &shown, const RenderModel &next) {
+  uint8_t changed = changedWidgets(shown, next);
+  uint8_t significant = changed & policy.alwaysWidgets;
+
+  if (changed & WIDGET_TEMPERATURE) {
+    int delta = next.temperature - shown.temperature;
+    if (delta >= policy.temperatureBand || -delta >= policy.temperatureBand) {
+      significant |= WIDGET_TEMPERATURE;
+    }
+  }
+
+  // A box showing the wrong day is never a minor change. The days shift
+  // at the data wake, so no time window is needed for it.
+  for (int i = 0; i < 3; i++) {
+    uint8_t bit = WIDGET_FORECAST_0 << i;
+    if (!(changed & bit)) {
+      continue;
+    }
+    if (memcmp(shown.forecast[i].date, next.forecast[i].date,
+               sizeof(shown.forecast[i].date)) != 0) {
+      significant |= bit;
+    }
+  }
+  return significant;
+}
@@ -0,0 +1,36 @@
+/*
+ * Refresh coalescing: which model changes are worth a full refresh
+ *
+ * Every refresh costs the same ~30 s at ~200 mA, whether it shows new
+ * prayer times or a temperature one degree off. A change is significant
+ * when it is in one of the always-refresh widgets, moves the temperature
+ * out of a band around the value on the panel, or shifts a forecast box to
+ * another day. Any other change is coalesced: its frame is stored, but the
+ * panel keeps the old one until the next significant refresh (a highlight
+ * wake, new prayer times) shows it, or until it has waited maxStaleSeconds.
+ *
+ * The scope is narrow. The condition text and the icon come from the same
+ * weather code, so a new condition almost always brings a new icon and
+ * refreshes. The daily data wake usually brings new prayer times and
+ * shifted forecast days. What waits is a temperature move within the band
+ * and a forecast revised for the same days, as payloads pushed between
+ * data wakes (MQTT, retries) carry.
+ */
+
+#ifndef REFRESH_POLICY_H
+#define REFRESH_POLICY_H
+
+#include "render_model.h"
+
+struct RefreshPolicy {
+  uint8_t alwaysWidgets;      // any change to these refreshes
+  int16_t temperatureBand;    // degrees from the shown value that refresh
+  long maxStaleSeconds;       // longest a coalesced change waits
+};
+
+// The changed widgets between what the panel shows and the next model that
+// are worth a refresh under the policy; 0 if the change can wait
+uint8_t significantWidgets(const RefreshPolicy &policy,
+                           const RenderModel &shown, const RenderModel &next);
+
+#endif
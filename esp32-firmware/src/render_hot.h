@@ -0,0 +1,20 @@
+/*
+ * Marks the innermost render and decode kernels
+ *
+ * Built with -DRENDER_IRAM, the marked functions go to IRAM on the ESP32,
+ * so they never stall on instruction-cache misses when WiFi/TLS code has
+ * evicted them. tools/iram_report.py shows what that costs. Everywhere
+ * else the marker is empty.
+ */
+
+#ifndef RENDER_HOT_H
+#define RENDER_HOT_H
+
+#if defined(ARDUINO) && defined(RENDER_IRAM)
+#include <esp_attr.h>
+#define RENDER_HOT IRAM_ATTR
+#else
+#define RENDER_HOT
+#endif
+
+#endif
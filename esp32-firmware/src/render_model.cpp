@@ -0,0 +1,91 @@
+#include "render_model.h"
+
+#include <string.h>
+
+// Must match the layout in displayPrayerTimes()
+static const WidgetRect WIDGET_RECTS[WIDGET_COUNT] = {
+    {0, 0, 384, 100},    // header: title + location
+    {0, 100, 384, 380},  // prayer list
+    {521, 42, 150, 142}, // weather icon, incl. rays and lightning
+    {390, 160, 410, 44}, // temperature + degree sign
+    {390, 204, 410, 28}, // condition text
+    {415, 250, 115, 130}, // forecast boxes
+    {538, 250, 115, 130},
+    {661, 250, 115, 130},
+};
+
+const WidgetRect &widgetRect(uint8_t index) { return WIDGET_RECTS[index]; }
+
+void modelSetString(char *dst, unsigned size, const char *src) {
+  memset(dst, 0, size);
+  strncpy(dst, src, size - 1);
+}
+
+uint8_t changedWidgets(const RenderModel &a, const RenderModel &b) {
+  uint8_t dirty = 0;
+  if (memcmp(a.location, b.location, sizeof(a.location)) != 0) {
+    dirty |= WIDGET_HEADER;
+  }
+  if (memcmp(a.prayers, b.prayers, sizeof(a.prayers)) != 0 ||
+      a.highlight != b.highlight) {
+    dirty |= WIDGET_PRAYERS;
+  }
+  if (memcmp(a.icon, b.icon, sizeof(a.icon)) != 0) {
+    dirty |= WIDGET_ICON;
+  }
+  if (a.temperature != b.temperature) {
+    dirty |= WIDGET_TEMPERATURE;
+  }
+  if (memcmp(a.condition, b.condition, sizeof(a.condition)) != 0) {
+    dirty |= WIDGET_CONDITION;
+  }
+  for (int i = 0; i < 3; i++) {
+    const ForecastModel &fa = a.forecast[i];
+    const ForecastModel &fb = b.forecast[i];
+    if (memcmp(fa.date, fb.date, sizeof(fa.date)) != 0 ||
+        fa.high != fb.high || fa.low != fb.low ||
+        memcmp(fa.condition, fb.condition, sizeof(fa.condition)) != 0) {
+      dirty |= WIDGET_FORECAST_0 << i;
+    }
+  }
+  return dirty;
+}
+
+static bool rectsOverlap(const WidgetRect &a, const WidgetRect &b) {
+  return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h &&
+         b.y < a.y + a.h;
+}
+
+uint8_t expandDirtyWidgets(uint8_t dirty) {
+  // Repeat until stable so chains of overlaps are covered too
+  uint8_t prev;
+  do {
+    prev = dirty;
+    for (uint8_t i = 0; i < WIDGET_COUNT; i++) {
+      if (!(dirty & (1 << i))) {
+        continue;
+      }
+      for (uint8_t j = 0; j < WIDGET_COUNT; j++) {
+        if (rectsOverlap(WIDGET_RECTS[i], WIDGET_RECTS[j])) {
+          dirty |= 1 << j;
+        }
+      }
+    }
+  } while (dirty != prev);
+  return dirty;
+}
+
+uint8_t drawableWidgets(uint8_t dirty, uint8_t ready, uint8_t drawn) {
+  uint8_t draw = 0;
+  for (uint8_t i = 0; i < WIDGET_COUNT; i++) {
+    uint8_t bit = 1 << i;
+    if (!(dirty & bit) || (drawn & bit)) {
+      continue;
+    }
+    uint8_t group = expandDirtyWidgets(bit);
+    if ((group & ready) == group) {
+      draw |= group;
+    }
+  }
+  return draw;
+}
@@ -0,0 +1,71 @@
+/*
+ * Render model: everything the screen layout depends on, as a flat POD
+ *
+ * Rendering is a pure function of this struct, so a stored copy tells us
+ * exactly what the stored frame shows and which widgets a new model changes.
+ */
+
+#ifndef RENDER_MODEL_H
+#define RENDER_MODEL_H
+
+#include <stdint.h>
+
+#define MODEL_VERSION 2
+
+struct ForecastModel {
+  char date[11]; // YYYY-MM-DD
+  int16_t high;
+  int16_t low;
+  char condition[16];
+};
+
+struct RenderModel {
+  char location[32];
+  char prayers[6][6]; // fajr, shuruq, dhuhr, asr, maghrib, isha as HH:MM
+  int8_t highlight;   // next prayer, -1 for none
+  int16_t temperature;
+  char condition[24];
+  char icon[4];
+  ForecastModel forecast[3];
+};
+
+// Screen widgets, one bit each
+enum Widget : uint8_t {
+  WIDGET_HEADER = 1 << 0,
+  WIDGET_PRAYERS = 1 << 1,
+  WIDGET_ICON = 1 << 2,
+  WIDGET_TEMPERATURE = 1 << 3,
+  WIDGET_CONDITION = 1 << 4,
+  WIDGET_FORECAST_0 = 1 << 5,
+  WIDGET_FORECAST_1 = 1 << 6,
+  WIDGET_FORECAST_2 = 1 << 7,
+};
+#define WIDGET_COUNT 8
+#define WIDGET_ALL 0xFF
+
+struct WidgetRect {
+  int16_t x;
+  int16_t y;
+  int16_t w;
+  int16_t h;
+};
+
+// Area a widget may draw into; cleared before the widget is redrawn
+const WidgetRect &widgetRect(uint8_t index);
+
+// Zero-fills and copies with truncation so models compare with memcmp
+void modelSetString(char *dst, unsigned size, const char *src);
+
+// Widgets whose inputs differ between two models
+uint8_t changedWidgets(const RenderModel &a, const RenderModel &b);
+
+// Adds every widget whose rect overlaps a dirty one, since clearing a rect
+// erases whatever neighbours drew into it
+uint8_t expandDirtyWidgets(uint8_t dirty);
+
+// For drawing while the inputs arrive: the dirty widgets not drawn yet whose
+// whole overlap group is ready, plus the rest of each group, so nothing
+// drawn now is cleared again by a widget drawn later
+uint8_t drawableWidgets(uint8_t dirty, uint8_t ready, uint8_t drawn);
+
+#endif
@@ -0,0 +1,81 @@
+#include "schedule.h"
+
+#define SECONDS_PER_DAY 86400L
+
+int parseClock(const char *hhmm) {
+  if (hhmm[0] < '0' || hhmm[0] > '9' || hhmm[1] < '0' || hhmm[1] > '9' ||
+      hhmm[2] != ':' || hhmm[3] < '0' || hhmm[3] > '9' || hhmm[4] < '0' ||
+      hhmm[4] > '9') {
+    return -1;
+  }
+  int hours = (hhmm[0] - '0') * 10 + (hhmm[1] - '0');
+  int minutes = (hhmm[3] - '0') * 10 + (hhmm[4] - '0');
+  if (hours > 23 || minutes > 59) {
+    return -1;
+  }
+  return hours * 60 + minutes;
+}
+
+int8_t nextPrayerIndex(const RenderModel &model, int minuteOfDay) {
+  for (int8_t i = 0; i < 6; i++) {
+    int at = parseClock(model.prayers[i]);
+    if (at > minuteOfDay) {
+      return i;
+    }
+  }
+  return 0;
+}
+
+long retryDelay(uint8_t failures, uint32_t random) {
+  long delay = RETRY_MAX_SECONDS;
+  if (failures > 0 && failures < 16) {
+    delay = (long)RETRY_BASE_SECONDS << (failures - 1);
+    if (delay > RETRY_MAX_SECONDS) {
+      delay = RETRY_MAX_SECONDS;
+    }
+  }
+  long spread = 2 * RETRY_JITTER_PERCENT + 1;
+  return delay * (100 - RETRY_JITTER_PERCENT + (long)(random % spread)) / 100;
+}
+
+FailureAction failureAction(uint8_t failures, bool haveFrame,
+                            bool errorShown, uint8_t failuresBeforeError) {
+  if (haveFrame && failures <= failuresBeforeError) {
+    return FAILURE_KEEP_FRAME;
+  }
+  return errorShown ? FAILURE_ERROR_SHOWN : FAILURE_SHOW_ERROR;
+}
+
+WakePlan planNextWake(const RenderModel &model, long secondOfDay,
+                      long dataWakeSecond, bool highlightWakes) {
+  WakePlan plan;
+  plan.fetch = true;
+  plan.highlight = model.highlight;
+  plan.sleepSeconds = dataWakeSecond - secondOfDay;
+  // If target time has passed today, wake up tomorrow
+  if (plan.sleepSeconds <= 0) {
+    plan.sleepSeconds += SECONDS_PER_DAY;
+  }
+
+  if (!highlightWakes) {
+    return plan;
+  }
+
+  for (int i = 0; i < 6; i++) {
+    int at = parseClock(model.prayers[i]);
+    if (at < 0) {
+      continue;
+    }
+    long sleep = at * 60L - secondOfDay;
+    int8_t highlight = nextPrayerIndex(model, at);
+    // A wake that would not move the highlight (e.g. the clock ran a few
+    // seconds early) is not worth a refresh
+    if (sleep > 0 && sleep < plan.sleepSeconds &&
+        highlight != model.highlight) {
+      plan.sleepSeconds = sleep;
+      plan.fetch = false;
+      plan.highlight = highlight;
+    }
+  }
+  return plan;
+}
@@ -0,0 +1,60 @@
+/*
+ * Wake scheduling: when to wake next and whether that wake needs the network
+ *
+ * Besides the daily data wake, the device can wake at each prayer time just
+ * to move the next-prayer highlight. Those wakes need no new data, so their
+ * frame is fully predictable from the current model.
+ *
+ * A failed fetch is retried after a short sleep instead of at the next
+ * daily data wake: the retry takes the data wake's place in the plan, so
+ * highlight wakes go on in between.
+ */
+
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include "render_model.h"
+#include <stdint.h>
+
+// The first retry comes after about RETRY_BASE_SECONDS, each following one
+// twice as late up to RETRY_MAX_SECONDS. All are spread by
+// +-RETRY_JITTER_PERCENT, so panels that failed together don't retry
+// together.
+#define RETRY_BASE_SECONDS 60
+#define RETRY_MAX_SECONDS 3600
+#define RETRY_JITTER_PERCENT 20
+
+// What a failed fetch leaves on the panel
+enum FailureAction : uint8_t {
+  FAILURE_KEEP_FRAME,  // the stored frame stays up, highlight wakes go on
+  FAILURE_SHOW_ERROR,  // draw the error screen
+  FAILURE_ERROR_SHOWN, // the error screen is already up; no refresh
+};
+
+struct WakePlan {
+  long sleepSeconds;
+  bool fetch;        // daily data wake vs. highlight-only wake
+  int8_t highlight;  // next-prayer index to show after a highlight wake
+};
+
+// "HH:MM" to minutes since midnight, or -1 if malformed
+int parseClock(const char *hhmm);
+
+// Index of the first prayer after minuteOfDay; Fajr (0) once Isha has passed
+int8_t nextPrayerIndex(const RenderModel &model, int minuteOfDay);
+
+// Seconds to sleep before retrying after failures consecutive failed
+// fetches (1 for the first); random is any uniformly random value
+long retryDelay(uint8_t failures, uint32_t random);
+
+// The stored frame through the first failuresBeforeError failures in a row,
+// if there is one; then the error screen, drawn once and left up until a
+// fetch succeeds
+FailureAction failureAction(uint8_t failures, bool haveFrame,
+                            bool errorShown, uint8_t failuresBeforeError);
+
+// Earliest of the daily data wake and (optionally) the next prayer time
+WakePlan planNextWake(const RenderModel &model, long secondOfDay,
+                      long dataWakeSecond, bool highlightWakes);
+
+#endif
@@ -0,0 +1,100 @@
+#include "state_store.h"
+
+#include <Arduino.h>
+#include <esp_partition.h>
+
+#define STATE_PARTITION "state"
+#define STATE_SECTOR_SIZE 4096
+
+static_assert(sizeof(StateImage) <= STATE_SECTOR_SIZE,
+              "state blob must fit one sector");
+
+RTC_DATA_ATTR static StateImage rtcImage;
+// Set when a flash write failed, so the next wake retries it
+RTC_DATA_ATTR static bool rtcFlashStale;
+
+// What this wake started from; its durable part is what flash holds
+static StateImage baseline;
+
+static const esp_partition_t *statePartition() {
+  static const esp_partition_t *partition = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, STATE_PARTITION);
+  return partition;
+}
+
+static bool readSlot(uint8_t slot, StateImage &image) {
+  const esp_partition_t *p = statePartition();
+  return p && esp_partition_read(p, slot * STATE_SECTOR_SIZE, &image,
+                                 sizeof(image)) == ESP_OK;
+}
+
+static bool writeSlot(uint8_t slot, const StateImage &image) {
+  const esp_partition_t *p = statePartition();
+  if (!p) {
+    return false;
+  }
+  // Until the write completes the slot is invalid, and the other slot
+  // still holds the previous generation
+  size_t offset = slot * STATE_SECTOR_SIZE;
+  return esp_partition_erase_range(p, offset, STATE_SECTOR_SIZE) == ESP_OK &&
+         esp_partition_write(p, offset, &image, sizeof(image)) == ESP_OK;
+}
+
+void stateLoad(DeviceState &state) {
+  unsigned long t0 = micros();
+  const char *source = "RTC";
+  const StateImage *loaded = nullptr;
+  if (stateValid(rtcImage)) {
+    loaded = &rtcImage;
+  } else {
+    static StateImage slots[2];
+    bool a = readSlot(0, slots[0]);
+    bool b = readSlot(1, slots[1]);
+    loaded = stateNewest(a ? &slots[0] : nullptr, b ? &slots[1] : nullptr);
+    source = statePartition() ? "flash" : "defaults, no state partition";
+    rtcFlashStale = false;
+  }
+
+  if (loaded) {
+    baseline = *loaded;
+  } else {
+    stateDefaults(baseline.state);
+    baseline.header.generation = 0;
+    if (statePartition()) {
+      source = "defaults";
+    }
+  }
+  state = baseline.state;
+  state.rtc.wakes++;
+  Serial.printf("State: generation %u from %s in %lu us\n",
+                (unsigned)baseline.header.generation, source,
+                micros() - t0);
+}
+
+size_t stateSave(const DeviceState &state) {
+  uint32_t generation = baseline.header.generation;
+  size_t written = 0;
+  if (rtcFlashStale || stateDurableChanged(baseline.state, state)) {
+    static StateImage image;
+    image.state = state;
+    stateSeal(image, generation + 1);
+    uint8_t slot = (generation + 1) % 2;
+    if (writeSlot(slot, image)) {
+      generation++;
+      written = sizeof(image);
+      rtcFlashStale = false;
+      Serial.printf("State: %u bytes to flash slot %u (generation %u)\n",
+                    (unsigned)written, slot, (unsigned)generation);
+    } else {
+      rtcFlashStale = true;
+      Serial.println("State: flash write failed, kept in RTC memory");
+    }
+  } else {
+    Serial.println("State: unchanged on flash, RTC memory only");
+  }
+
+  rtcImage.state = state;
+  stateSeal(rtcImage, generation);
+  baseline = rtcImage;
+  return written;
+}
@@ -0,0 +1,21 @@
+/*
+ * Device state (device_state.h) across deep sleep and power loss
+ *
+ * After a deep sleep the state comes straight from RTC memory. After a
+ * reset or power loss it comes from the "state" partition (partitions.csv):
+ * two 4 KB sectors written alternately, newest valid generation wins.
+ * Saving writes flash only when the durable part changed, so highlight
+ * wakes cost no flash writes at all.
+ */
+
+#ifndef STATE_STORE_H
+#define STATE_STORE_H
+
+#include "device_state.h"
+
+void stateLoad(DeviceState &state);
+
+// Call once, at the end of a wake; returns the bytes written to flash
+size_t stateSave(const DeviceState &state);
+
+#endif
@@ -0,0 +1,54 @@
+#include "sync_fetch.h"
+
+#include <WiFi.h>
+#include <WiFiUdp.h>
+
+SyncStatus syncFetch(const char *host, uint16_t port, uint32_t knownVersion,
+                     RenderModel &model, uint32_t &version,
+                     uint32_t &serverTime) {
+  uint8_t mac[6];
+  WiFi.macAddress(mac);
+  SyncClient client;
+  syncClientBegin(client, mac, esp_random(), knownVersion,
+                  reinterpret_cast<uint8_t *>(&model), sizeof(model));
+
+  WiFiUDP udp;
+  if (!udp.begin(port)) {
+    Serial.println("Sync: no UDP socket");
+    return SYNC_GAVE_UP;
+  }
+  static uint8_t datagram[SYNC_MAX_DATAGRAM];
+  SyncStatus status = SYNC_PENDING;
+  SyncRequest request;
+  uint32_t timeoutMs;
+  while (status == SYNC_PENDING &&
+         syncClientRequest(client, request, timeoutMs) == SYNC_PENDING) {
+    udp.beginPacket(host, port);
+    udp.write(reinterpret_cast<const uint8_t *>(&request), sizeof(request));
+    udp.endPacket();
+    unsigned long sent = millis();
+    while (status == SYNC_PENDING && millis() - sent < timeoutMs) {
+      int len = udp.parsePacket();
+      if (len <= 0) {
+        delay(1);
+        continue;
+      }
+      len = udp.read(datagram, sizeof(datagram));
+      status = syncClientReceive(client, datagram, len);
+    }
+  }
+  udp.stop();
+
+  Serial.printf("Sync: %d requests, %u datagrams\n", client.request.attempt,
+                client.datagrams);
+  if (status == SYNC_PENDING) {
+    return SYNC_GAVE_UP;
+  }
+  serverTime = client.serverTime;
+  version = status == SYNC_SAME ? knownVersion : client.request.haveVersion;
+  if (status == SYNC_COMPLETE && client.total != sizeof(model)) {
+    Serial.printf("Sync: %u bytes is not a render model\n", client.total);
+    return SYNC_GAVE_UP;
+  }
+  return status;
+}
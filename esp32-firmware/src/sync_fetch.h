@@ -0,0 +1,23 @@
+/*
+ * Render model from a LAN sync server over UDP (see udp_sync.h)
+ *
+ * One request datagram, one or a few reply datagrams: no DNS, TCP, TLS,
+ * HTTP or JSON, and the reply brings the clock along. The exchange is over
+ * in a few milliseconds on a quiet LAN, and retransmissions stay within
+ * about a second when datagrams are lost.
+ */
+
+#ifndef SYNC_FETCH_H
+#define SYNC_FETCH_H
+
+#include "render_model.h"
+#include "udp_sync.h"
+#include <Arduino.h>
+
+// knownVersion 0 always fetches the model. On SYNC_COMPLETE model and
+// version hold the server's model; serverTime is set unless SYNC_GAVE_UP.
+SyncStatus syncFetch(const char *host, uint16_t port, uint32_t knownVersion,
+                     RenderModel &model, uint32_t &version,
+                     uint32_t &serverTime);
+
+#endif
@@ -0,0 +1,48 @@
+#include "telemetry.h"
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <HTTPClient.h>
+#include <WiFi.h>
+
+#define UPLOAD_TIMEOUT_MS 2000
+
+WakeTelemetry telemetry;
+
+int formatTelemetry(char *buf, size_t len) {
+  // SSIDs may contain quotes and backslashes; the library escapes them
+  JsonDocument doc;
+  doc["device"] = telemetry.device;
+  doc["ap"] = telemetry.ap;
+  doc["ap_score"] = telemetry.apScore;
+  doc["rssi"] = telemetry.rssi;
+  doc["assoc_ms"] = telemetry.assocMs;
+  doc["kbps"] = telemetry.kbps;
+  doc["net_ms"] = telemetry.netMs;
+  doc["flash_bytes"] = telemetry.flashBytes;
+  doc["refreshes_avoided"] = telemetry.refreshesAvoided;
+  return serializeJson(doc, buf, len);
+}
+
+void printTelemetry() {
+  char line[256];
+  formatTelemetry(line, sizeof(line));
+  Serial.printf("Telemetry: %s\n", line);
+}
+
+bool uploadTelemetry(const char *url) {
+  char line[256];
+  int len = formatTelemetry(line, sizeof(line));
+  unsigned long start = millis();
+  WiFiClient client;
+  HTTPClient http;
+  http.setConnectTimeout(UPLOAD_TIMEOUT_MS);
+  http.setTimeout(UPLOAD_TIMEOUT_MS);
+  http.begin(client, url);
+  http.addHeader("Content-Type", "application/json");
+  int code = http.POST((uint8_t *)line, len);
+  http.end();
+  Serial.printf("Telemetry upload: HTTP %d in %lu ms\n", code,
+                millis() - start);
+  return code >= 200 && code < 300;
+}
@@ -0,0 +1,34 @@
+/*
+ * Per-wake telemetry, printed as one JSON line over serial before sleeping
+ *
+ * Built with -DTELEMETRY_URL, the same line is POSTed there over plain HTTP
+ * (tools/lan_gateway's /_telemetry) while the panel refreshes.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct WakeTelemetry {
+  char device[24]; // provisioned device ID, empty without one
+  char ap[33];
+  int16_t apScore;
+  int8_t rssi;
+  uint16_t assocMs;
+  uint16_t kbps;
+  uint32_t netMs; // WiFi start to the last payload byte
+  uint32_t flashBytes; // state blob and frames
+  uint16_t refreshesAvoided; // coalesced so far today
+};
+
+extern WakeTelemetry telemetry;
+
+// The JSON line; returns its length, cut to fit len if need be
+int formatTelemetry(char *buf, size_t len);
+void printTelemetry();
+// False if the server didn't answer with 2xx in time
+bool uploadTelemetry(const char *url);
+
+#endif
@@ -0,0 +1,60 @@
+#include "trace_store.h"
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+#define TRACE_FILE "/traces.bin"
+#define TRACE_OLD_FILE "/traces.old"
+#define TRACE_FILE_LIMIT 16384
+
+bool saveTrace(const WakeTrace &trace) {
+  File f = LittleFS.open(TRACE_FILE, "a");
+  if (!f) {
+    return false;
+  }
+  if (f.size() > TRACE_FILE_LIMIT) {
+    f.close();
+    LittleFS.remove(TRACE_OLD_FILE);
+    LittleFS.rename(TRACE_FILE, TRACE_OLD_FILE);
+    f = LittleFS.open(TRACE_FILE, "a");
+    if (!f) {
+      return false;
+    }
+  }
+
+  // Length-prefixed records
+  uint16_t len = traceSize(trace);
+  bool ok = f.write((const uint8_t *)&len, sizeof(len)) == sizeof(len) &&
+            f.write((const uint8_t *)&trace, len) == len;
+  f.close();
+  return ok;
+}
+
+static void dumpFile(const char *path) {
+  File f = LittleFS.open(path, "r");
+  if (!f) {
+    return;
+  }
+  uint16_t len;
+  uint8_t record[sizeof(WakeTrace)];
+  while (f.read((uint8_t *)&len, sizeof(len)) == sizeof(len) &&
+         len <= sizeof(record) && f.read(record, len) == len) {
+    Serial.print("TRACE ");
+    for (uint16_t i = 0; i < len; i++) {
+      Serial.printf("%02x", record[i]);
+    }
+    Serial.println();
+  }
+  f.close();
+}
+
+void dumpTraces() {
+  dumpFile(TRACE_OLD_FILE);
+  dumpFile(TRACE_FILE);
+  Serial.println("TRACE END");
+}
+
+void clearTraces() {
+  LittleFS.remove(TRACE_OLD_FILE);
+  LittleFS.remove(TRACE_FILE);
+}
@@ -0,0 +1,18 @@
+/*
+ * Wake traces kept in LittleFS and dumped over serial
+ *
+ * Traces are appended to /traces.bin; past TRACE_FILE_LIMIT the file moves
+ * to /traces.old, so roughly the last two files' worth of wakes survive.
+ */
+
+#ifndef TRACE_STORE_H
+#define TRACE_STORE_H
+
+#include "wake_trace.h"
+
+bool saveTrace(const WakeTrace &trace);
+// Prints every stored trace as a "TRACE <hex>" line, oldest first
+void dumpTraces();
+void clearTraces();
+
+#endif
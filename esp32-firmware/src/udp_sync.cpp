@@ -0,0 +1,151 @@
+#include "udp_sync.h"
+
+#include "crc32.h"
+#include "wake_trace.h"
+#include <string.h>
+
+static uint8_t chunkCount(uint16_t total) {
+  return total == 0 ? 1 : (total + SYNC_CHUNK - 1) / SYNC_CHUNK;
+}
+
+static uint16_t chunkLength(uint16_t total, uint8_t index) {
+  uint16_t rest = total - index * SYNC_CHUNK;
+  return rest < SYNC_CHUNK ? rest : SYNC_CHUNK;
+}
+
+static uint32_t allChunks(uint8_t count) {
+  return count >= 32 ? 0xFFFFFFFFu : (1u << count) - 1;
+}
+
+void syncClientBegin(SyncClient &client, const uint8_t deviceId[6],
+                     uint16_t nonce, uint32_t knownVersion, uint8_t *buf,
+                     size_t cap) {
+  memset(&client, 0, sizeof(client));
+  client.request.magic = SYNC_MAGIC;
+  client.request.type = SYNC_REQUEST;
+  client.request.nonce = nonce;
+  memcpy(client.request.deviceId, deviceId, sizeof(client.request.deviceId));
+  client.request.knownVersion = knownVersion;
+  client.buf = buf;
+  client.cap = cap;
+}
+
+SyncStatus syncClientRequest(SyncClient &client, SyncRequest &request,
+                             uint32_t &timeoutMs) {
+  if (client.request.attempt >= SYNC_ATTEMPTS) {
+    return SYNC_GAVE_UP;
+  }
+  timeoutMs = (uint32_t)SYNC_TIMEOUT_MS << client.request.attempt;
+  client.request.attempt++;
+  client.request.crc =
+      crc32(0, &client.request, offsetof(SyncRequest, crc));
+  request = client.request;
+  return SYNC_PENDING;
+}
+
+SyncStatus syncClientReceive(SyncClient &client, const uint8_t *data,
+                             size_t len) {
+  SyncReply reply;
+  uint32_t crc;
+  if (len < sizeof(reply) + sizeof(crc)) {
+    return SYNC_PENDING;
+  }
+  memcpy(&reply, data, sizeof(reply));
+  memcpy(&crc, data + len - sizeof(crc), sizeof(crc));
+  if (reply.magic != SYNC_MAGIC || reply.nonce != client.request.nonce ||
+      crc != crc32(0, data, len - sizeof(crc))) {
+    return SYNC_PENDING;
+  }
+  client.serverTime = reply.serverTime;
+
+  if (reply.type == SYNC_UNCHANGED) {
+    if (reply.version != client.request.knownVersion) {
+      return SYNC_PENDING;
+    }
+    client.datagrams++;
+    return SYNC_SAME;
+  }
+  uint16_t n = len - sizeof(reply) - sizeof(crc);
+  if (reply.type != SYNC_DATA || reply.modelVersion != MODEL_VERSION ||
+      reply.total > client.cap || reply.count != chunkCount(reply.total) ||
+      reply.count > SYNC_MAX_CHUNKS || reply.index >= reply.count ||
+      n != chunkLength(reply.total, reply.index)) {
+    return SYNC_PENDING;
+  }
+
+  // A newer payload than the chunks so far starts over
+  SyncRequest &req = client.request;
+  if (reply.version != req.haveVersion || reply.total != client.total) {
+    req.haveVersion = reply.version;
+    req.have = 0;
+    client.total = reply.total;
+    client.count = reply.count;
+  }
+  if (req.have & (1u << reply.index)) {
+    return SYNC_PENDING; // duplicate from a retransmission
+  }
+  memcpy(client.buf + reply.index * SYNC_CHUNK, data + sizeof(reply), n);
+  req.have |= 1u << reply.index;
+  client.datagrams++;
+  if (req.have != allChunks(client.count)) {
+    return SYNC_PENDING;
+  }
+  if (traceHash(client.buf, client.total) != req.haveVersion) {
+    req.have = 0; // chunks of different payloads mixed up; fetch again
+    return SYNC_PENDING;
+  }
+  return SYNC_COMPLETE;
+}
+
+bool syncParseRequest(const uint8_t *data, size_t len, SyncRequest &request) {
+  if (len != sizeof(request)) {
+    return false;
+  }
+  memcpy(&request, data, sizeof(request));
+  return request.magic == SYNC_MAGIC && request.type == SYNC_REQUEST &&
+         request.crc == crc32(0, &request, offsetof(SyncRequest, crc));
+}
+
+static void sendReply(const SyncReply &reply, const uint8_t *chunk, size_t n,
+                      SyncSend send, void *ctx) {
+  uint8_t datagram[SYNC_MAX_DATAGRAM];
+  memcpy(datagram, &reply, sizeof(reply));
+  if (n > 0) {
+    memcpy(datagram + sizeof(reply), chunk, n);
+  }
+  uint32_t crc = crc32(0, datagram, sizeof(reply) + n);
+  memcpy(datagram + sizeof(reply) + n, &crc, sizeof(crc));
+  send(ctx, datagram, sizeof(reply) + n + sizeof(crc));
+}
+
+int syncServe(const SyncRequest &request, const uint8_t *payload,
+              uint16_t len, uint32_t version, uint32_t serverTime,
+              SyncSend send, void *ctx) {
+  SyncReply reply;
+  memset(&reply, 0, sizeof(reply));
+  reply.magic = SYNC_MAGIC;
+  reply.nonce = request.nonce;
+  reply.serverTime = serverTime;
+  reply.version = version;
+  reply.total = len;
+  reply.count = chunkCount(len);
+  reply.modelVersion = MODEL_VERSION;
+  if (request.knownVersion == version) {
+    reply.type = SYNC_UNCHANGED;
+    sendReply(reply, nullptr, 0, send, ctx);
+    return 1;
+  }
+
+  reply.type = SYNC_DATA;
+  uint32_t have = request.haveVersion == version ? request.have : 0;
+  int sent = 0;
+  for (uint8_t i = 0; i < reply.count; i++) {
+    if (!(have & (1u << i))) {
+      reply.index = i;
+      sendReply(reply, payload + i * SYNC_CHUNK, chunkLength(len, i), send,
+                ctx);
+      sent++;
+    }
+  }
+  return sent;
+}
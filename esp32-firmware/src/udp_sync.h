@@ -0,0 +1,114 @@
+/*
+ * Single-datagram sync protocol for units on the same LAN as a sync server
+ *
+ * The device sends one request with its ID and the version of the payload
+ * it shows. The server answers with one UNCHANGED datagram, or with the
+ * payload in DATA datagrams of up to SYNC_CHUNK bytes, each carrying its
+ * index, the chunk count, the payload version and a CRC-32. Every reply
+ * also carries the server's clock, so the wake needs no NTP either.
+ *
+ * Loss is handled by the client: if the reply is incomplete when a timeout
+ * expires, the request is sent again with a bitmask of the chunks it
+ * already has, and the server resends only the rest. Timeouts double from
+ * SYNC_TIMEOUT_MS over SYNC_ATTEMPTS requests.
+ *
+ * The payload is a RenderModel as stored with frames (highlight -1), so the
+ * device draws it without parsing anything. Its version is the FNV-1a hash
+ * of those bytes, checked end to end once all chunks are in.
+ *
+ * Datagrams are these structs as laid out on both ends (little-endian,
+ * no padding). Portable: the device, tools/sync_server and
+ * tools/sync_loss_test share it.
+ */
+
+#ifndef UDP_SYNC_H
+#define UDP_SYNC_H
+
+#include "render_model.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define SYNC_MAGIC 0x314E5953 // "SYN1"
+#define SYNC_PORT 4210
+#define SYNC_CHUNK 1024 // payload bytes per DATA datagram, below the MTU
+#define SYNC_MAX_CHUNKS 32
+#define SYNC_TIMEOUT_MS 15
+#define SYNC_ATTEMPTS 6
+
+enum SyncType : uint8_t {
+  SYNC_REQUEST = 1,
+  SYNC_UNCHANGED = 2,
+  SYNC_DATA = 3,
+};
+
+struct SyncRequest {
+  uint32_t magic;
+  uint8_t type;
+  uint8_t attempt;
+  uint16_t nonce; // per wake; replies to other nonces are ignored
+  uint8_t deviceId[6];
+  uint16_t reserved;
+  uint32_t knownVersion; // payload on the panel, 0 for none
+  uint32_t haveVersion;  // payload the chunks in have belong to
+  uint32_t have;         // chunks already received, bit per index
+  uint32_t crc;
+};
+
+struct SyncReply {
+  uint32_t magic;
+  uint8_t type;
+  uint8_t index;
+  uint16_t nonce;
+  uint32_t serverTime; // Unix time
+  uint32_t version;
+  uint16_t total; // payload bytes
+  uint8_t count;  // chunks
+  uint8_t modelVersion;
+  // DATA: the chunk's bytes, then the CRC-32 of everything before it
+};
+
+#define SYNC_MAX_DATAGRAM (sizeof(SyncReply) + SYNC_CHUNK + 4)
+
+// Client side: one sync exchange. buf receives the payload.
+struct SyncClient {
+  SyncRequest request;
+  uint8_t *buf;
+  size_t cap;
+  uint16_t total;
+  uint8_t count;
+  uint32_t serverTime;
+  uint8_t datagrams; // received and valid, for diagnostics
+};
+
+enum SyncStatus {
+  SYNC_PENDING,
+  SYNC_SAME,     // the server has knownVersion
+  SYNC_COMPLETE, // buf holds total bytes of request.haveVersion
+  SYNC_GAVE_UP,
+};
+
+void syncClientBegin(SyncClient &client, const uint8_t deviceId[6],
+                     uint16_t nonce, uint32_t knownVersion, uint8_t *buf,
+                     size_t cap);
+// The next request to send (the first or a retransmission) and how long to
+// wait for replies before calling this again; SYNC_GAVE_UP when out of
+// attempts
+SyncStatus syncClientRequest(SyncClient &client, SyncRequest &request,
+                             uint32_t &timeoutMs);
+// Feeds one received datagram; anything invalid or stale is ignored
+SyncStatus syncClientReceive(SyncClient &client, const uint8_t *data,
+                             size_t len);
+
+// Server side. Parses and checks a request datagram.
+bool syncParseRequest(const uint8_t *data, size_t len, SyncRequest &request);
+
+// Receives each reply datagram
+typedef void (*SyncSend)(void *ctx, const uint8_t *data, size_t len);
+
+// Answers a request for the given payload: UNCHANGED, or the DATA chunks
+// the client doesn't have yet. Returns the number of datagrams sent.
+int syncServe(const SyncRequest &request, const uint8_t *payload,
+              uint16_t len, uint32_t version, uint32_t serverTime,
+              SyncSend send, void *ctx);
+
+#endif
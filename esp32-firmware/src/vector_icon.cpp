@@ -0,0 +1,402 @@
+#include "vector_icon.h"
+
+#include "render_hot.h"
+
+// Positions are in 1/16 pixel from here on
+#define SUB_SHIFT 4
+#define SUB (1 << SUB_SHIFT)
+
+// Shapes of one paint rasterized together, and their spans on one row
+#define LAYER_SHAPES 16
+#define ROW_SPANS 48
+
+// First and last pixel whose center is at or after / at or before v
+static inline int32_t ceilPx(int32_t v) { return (v + SUB - 1) >> SUB_SHIFT; }
+static inline int32_t floorPx(int32_t v) { return v >> SUB_SHIFT; }
+
+static inline int32_t min32(int32_t a, int32_t b) { return a < b ? a : b; }
+static inline int32_t max32(int32_t a, int32_t b) { return a > b ? a : b; }
+
+// Digit by digit, without branches on the digits
+static uint32_t isqrt(uint32_t n) {
+  uint32_t root = 0;
+  for (uint32_t bit = 1u << 30; bit != 0; bit >>= 2) {
+    uint32_t trial = root + bit;
+    uint32_t take = n >= trial ? ~0u : 0;
+    n -= trial & take;
+    root = (root >> 1) + (bit & take);
+  }
+  return root;
+}
+
+namespace {
+
+// The pixels of a disc's row, tracked from row to row: the ends move by a
+// pixel or a few per row, so a couple of compares replace a square root.
+// t is r^2 - dy^2 for the row, and pixel X is inside if (16 X - cx)^2 <= t.
+struct DiscRow {
+  int32_t cx;
+  int32_t x0; // first and last pixel; x0 > x1 when the row holds none
+  int32_t x1;
+
+  void begin(int32_t centerX) {
+    cx = centerX;
+    x0 = ceilPx(cx);
+    x1 = floorPx(cx);
+  }
+  static bool within(int32_t d, int32_t t) { return d <= 0 || d * d <= t; }
+  void update(int32_t t) {
+    while (within((x1 + 1) * SUB - cx, t)) {
+      x1++;
+    }
+    while (!within(x1 * SUB - cx, t)) {
+      x1--;
+    }
+    while (within(cx - (x0 - 1) * SUB, t)) {
+      x0--;
+    }
+    while (!within(cx - x0 * SUB, t)) {
+      x0++;
+    }
+  }
+};
+
+// An edge as x = x0 + (y - y0) * slope, over rows y0..y1
+struct Edge {
+  int32_t x0;
+  int32_t y0;
+  int32_t y1;
+  int32_t slope; // 16.16
+
+  void set(int32_t ax, int32_t ay, int32_t bx, int32_t by) {
+    if (ay > by) {
+      int32_t t = ax;
+      ax = bx;
+      bx = t;
+      t = ay;
+      ay = by;
+      by = t;
+    }
+    x0 = ax;
+    y0 = ay;
+    y1 = by;
+    // No 64-bit division: even at ICON_MAX_SIZE, with the widest strokes,
+    // |bx - ax| < 32768
+    slope = by != ay ? (bx - ax) * 65536 / (by - ay) : 0;
+  }
+  int32_t at(int32_t y) const {
+    return x0 + (int32_t)(((int64_t)(y - y0) * slope) >> 16);
+  }
+};
+
+// The spans of one row, kept sorted by their first pixel
+struct RowSpans {
+  int32_t x0[ROW_SPANS];
+  int32_t x1[ROW_SPANS];
+  int count;
+
+  // Pixels a..b inclusive
+  void add(int32_t a, int32_t b) {
+    if (b < a || count == ROW_SPANS) {
+      return;
+    }
+    int k = count++;
+    for (; k > 0 && x0[k - 1] > a; k--) {
+      x0[k] = x0[k - 1];
+      x1[k] = x1[k - 1];
+    }
+    x0[k] = a;
+    x1[k] = b;
+  }
+};
+
+// One shape, decoded once and then stepped a row at a time
+struct Shape {
+  uint8_t op;
+  int32_t top; // rows
+  int32_t bottom;
+  int32_t ax; // circle/ring center, capsule end, rect columns ax..bx
+  int32_t ay;
+  int32_t bx;
+  int32_t by;
+  int32_t rad2;
+  int32_t inner2; // ring hole
+  DiscRow discA;
+  DiscRow discB;
+  Edge sides[2]; // capsule
+  bool sloped;
+  int32_t sidesTop; // where a row crosses both sides
+  int32_t sidesBottom;
+  const uint8_t *points; // polygon
+  uint8_t n;
+};
+
+struct Raster {
+  int32_t ox; // icon center
+  int32_t oy;
+  int32_t size;
+
+  // Icon units to 1/16 pixel: u * size / ICON_UNITS * SUB
+  int32_t scale(int32_t u) const { return (u * size + 4) >> 3; }
+  int32_t x(const uint8_t *p) const { return ox + scale((int8_t)*p); }
+  int32_t y(const uint8_t *p) const { return oy + scale((int8_t)*p); }
+
+  const uint8_t *decode(const uint8_t *p, Shape &s) const;
+  void spans(Shape &s, int32_t py, RowSpans &row) const;
+};
+
+// Returns the next instruction, or null if this one is not from the compiler
+const uint8_t *Raster::decode(const uint8_t *p, Shape &s) const {
+  s.op = *p++ >> 4;
+  switch (s.op) {
+  case ICON_CIRCLE:
+  case ICON_RING: {
+    s.ax = x(p);
+    s.ay = y(p + 1);
+    int32_t rad = scale(p[2]);
+    s.rad2 = rad * rad;
+    s.top = ceilPx(s.ay - rad);
+    s.bottom = floorPx(s.ay + rad);
+    s.discA.begin(s.ax);
+    if (s.op == ICON_CIRCLE) {
+      return p + 3;
+    }
+    int32_t inner = max32(rad - max32(scale(p[3]), SUB), 0);
+    s.inner2 = inner * inner;
+    s.discB.begin(s.ax);
+    return p + 4;
+  }
+  case ICON_CAPSULE: {
+    s.ax = x(p);
+    s.ay = y(p + 1);
+    s.bx = x(p + 2);
+    s.by = y(p + 3);
+    int32_t rad = max32(scale(p[4]) / 2, SUB / 2); // stays connected when thin
+    s.rad2 = rad * rad;
+    s.top = ceilPx(min32(s.ay, s.by) - rad);
+    s.bottom = floorPx(max32(s.ay, s.by) + rad);
+    s.discA.begin(s.ax);
+    s.discB.begin(s.bx);
+    int32_t dx = s.bx - s.ax;
+    int32_t dy = s.by - s.ay;
+    int32_t len = isqrt(dx * dx + dy * dy);
+    s.sloped = len != 0;
+    s.sidesTop = INT32_MAX;
+    s.sidesBottom = INT32_MIN;
+    if (s.sloped) {
+      int32_t k = (rad << 16) / len; // |dx|, |dy| <= len
+      int32_t nx = (-dy * k) >> 16;
+      int32_t ny = (dx * k) >> 16;
+      s.sides[0].set(s.ax + nx, s.ay + ny, s.bx + nx, s.by + ny);
+      s.sides[1] = s.sides[0]; // parallel
+      s.sides[1].x0 -= 2 * nx;
+      s.sides[1].y0 -= 2 * ny;
+      s.sides[1].y1 -= 2 * ny;
+      s.sidesTop = max32(s.sides[0].y0, s.sides[1].y0);
+      s.sidesBottom = min32(s.sides[0].y1, s.sides[1].y1);
+    }
+    return p + 5;
+  }
+  case ICON_POLYGON: {
+    s.n = *p++;
+    if (s.n < 3 || s.n > ICON_MAX_POINTS) {
+      return nullptr;
+    }
+    s.points = p;
+    int32_t top = INT32_MAX;
+    int32_t bottom = INT32_MIN;
+    for (uint8_t i = 0; i < s.n; i++) {
+      int32_t py = y(p + 2 * i + 1);
+      top = min32(top, py);
+      bottom = max32(bottom, py);
+    }
+    s.top = ceilPx(top);
+    s.bottom = floorPx(bottom);
+    return p + 2 * s.n;
+  }
+  case ICON_RECT:
+    s.ax = ceilPx(x(p));
+    s.bx = ceilPx(ox + scale((int8_t)p[0] + p[2])) - 1;
+    s.top = ceilPx(y(p + 1));
+    s.bottom = ceilPx(oy + scale((int8_t)p[1] + p[3])) - 1;
+    return p + 4;
+  default:
+    return nullptr;
+  }
+}
+
+// Adds the shape's spans on row py; rows are visited top to bottom
+void RENDER_HOT Raster::spans(Shape &s, int32_t py, RowSpans &row) const {
+  int32_t y = py * SUB;
+  switch (s.op) {
+  case ICON_CIRCLE: {
+    int32_t dy = y - s.ay;
+    s.discA.update(s.rad2 - dy * dy);
+    row.add(s.discA.x0, s.discA.x1);
+    break;
+  }
+  case ICON_RING: {
+    int32_t dy = y - s.ay;
+    s.discA.update(s.rad2 - dy * dy);
+    if (dy * dy >= s.inner2) {
+      row.add(s.discA.x0, s.discA.x1);
+      break;
+    }
+    // The hole is strictly inside the inner radius
+    s.discB.update(s.inner2 - dy * dy - 1);
+    row.add(s.discA.x0, s.discB.x0 - 1);
+    row.add(s.discB.x1 + 1, s.discA.x1);
+    break;
+  }
+  case ICON_CAPSULE: {
+    if (y >= s.sidesTop && y <= s.sidesBottom) {
+      // Most rows of a stroke: the caps lie between the sides' lines, so
+      // the row runs from one side to the other
+      int32_t a = s.sides[0].at(y);
+      int32_t b = s.sides[1].at(y);
+      row.add(ceilPx(min32(a, b)), floorPx(max32(a, b)));
+      break;
+    }
+    // Otherwise the row is the hull of its spans through both end discs and
+    // the sides it crosses (a capsule is convex)
+    int32_t lo = INT32_MAX;
+    int32_t hi = INT32_MIN;
+    int32_t ey = y - s.ay;
+    if (ey * ey <= s.rad2) {
+      s.discA.update(s.rad2 - ey * ey);
+      lo = s.discA.x0;
+      hi = s.discA.x1;
+    }
+    ey = y - s.by;
+    if (ey * ey <= s.rad2) {
+      s.discB.update(s.rad2 - ey * ey);
+      lo = min32(lo, s.discB.x0);
+      hi = max32(hi, s.discB.x1);
+    }
+    for (int i = 0; s.sloped && i < 2; i++) {
+      const Edge &e = s.sides[i];
+      if (y >= e.y0 && y <= e.y1) {
+        int32_t x = e.at(y);
+        lo = min32(lo, ceilPx(x));
+        hi = max32(hi, floorPx(x));
+      }
+    }
+    row.add(lo, hi);
+    break;
+  }
+  case ICON_POLYGON: {
+    int32_t cross[ICON_MAX_POINTS];
+    int count = 0;
+    const uint8_t *prev = s.points + 2 * (s.n - 1);
+    int32_t jx = x(prev);
+    int32_t jy = this->y(prev + 1);
+    for (uint8_t i = 0; i < s.n; i++) {
+      int32_t ix = x(s.points + 2 * i);
+      int32_t iy = this->y(s.points + 2 * i + 1);
+      // Half-open in y, so shared vertices count once
+      if ((iy <= y) != (jy <= y)) {
+        int32_t cx = ix + (y - iy) * (jx - ix) / (jy - iy);
+        int k = count++;
+        for (; k > 0 && cross[k - 1] > cx; k--) {
+          cross[k] = cross[k - 1];
+        }
+        cross[k] = cx;
+      }
+      jx = ix;
+      jy = iy;
+    }
+    for (int k = 0; k + 1 < count; k += 2) {
+      row.add(ceilPx(cross[k]), ceilPx(cross[k + 1]) - 1);
+    }
+    break;
+  }
+  case ICON_RECT:
+    row.add(s.ax, s.bx);
+    break;
+  }
+}
+
+// Fills the union of the row's spans, so each pixel is painted once however
+// many shapes of the layer cover it
+void fillRow(FrameBuffer &fb, int32_t py, const RowSpans &row,
+             uint8_t paint) {
+  uint8_t ink = paint & ICON_INK_MASK;
+  for (int i = 0; i < row.count;) {
+    int32_t x0 = row.x0[i];
+    int32_t x1 = row.x1[i];
+    for (i++; i < row.count && row.x0[i] <= x1 + 1; i++) {
+      x1 = max32(x1, row.x1[i]);
+    }
+    if (paint & ICON_DITHER) {
+      fb.fillSpanDithered(x0, py, x1 - x0 + 1, ink);
+    } else {
+      fb.fillSpan(x0, py, x1 - x0 + 1, ink);
+    }
+  }
+}
+
+} // namespace
+
+void RENDER_HOT drawVectorIcon(FrameBuffer &fb, const uint8_t *program,
+                               int16_t cx, int16_t cy, int16_t size) {
+  if (size <= 0 || size > ICON_MAX_SIZE) {
+    return;
+  }
+  Raster r = {(int32_t)cx * SUB, (int32_t)cy * SUB, size};
+  // Rows of the band, clipped to the frame
+  int32_t firstRow = max32(fb.bandTop(), 0);
+  int32_t lastRow = min32(fb.bandTop() + fb.bandRows(), fb.height()) - 1;
+
+  // Consecutive shapes of one paint form a layer, drawn row by row
+  Shape layer[LAYER_SHAPES];
+  uint8_t order[LAYER_SHAPES]; // by first row
+  uint8_t active[LAYER_SHAPES];
+  const uint8_t *p = program;
+  while (p != nullptr && *p != ICON_END) {
+    uint8_t paint = *p & (ICON_DITHER | ICON_INK_MASK);
+    int n = 0;
+    while (n < LAYER_SHAPES && p != nullptr && *p != ICON_END &&
+           (*p & (ICON_DITHER | ICON_INK_MASK)) == paint) {
+      p = r.decode(p, layer[n]);
+      if (p == nullptr) {
+        break;
+      }
+      int k = n;
+      for (; k > 0 && layer[order[k - 1]].top > layer[n].top; k--) {
+        order[k] = order[k - 1];
+      }
+      order[k] = n++;
+    }
+
+    // Each row visits only the shapes crossing it, and rows between them
+    // are skipped
+    int count = 0;
+    int next = 0;
+    for (int32_t py = firstRow; py <= lastRow; py++) {
+      if (count == 0) {
+        if (next == n) {
+          break;
+        }
+        py = max32(py, layer[order[next]].top);
+        if (py > lastRow) {
+          break;
+        }
+      }
+      while (next < n && layer[order[next]].top <= py) {
+        active[count++] = order[next++];
+      }
+      RowSpans row;
+      row.count = 0;
+      for (int i = 0; i < count;) {
+        Shape &s = layer[active[i]];
+        if (s.bottom < py) {
+          active[i] = active[--count];
+          continue;
+        }
+        r.spans(s, py, row);
+        i++;
+      }
+      fillRow(fb, py, row, paint);
+    }
+  }
+}
@@ -0,0 +1,58 @@
+/*
+ * Resolution-independent icons as compact vector bytecode
+ *
+ * Icons are drawn in SVG-like sources (icons/<name>.svg) and compiled by
+ * tools/icon_compiler.py into programs of a few dozen bytes (icon_data.h).
+ * One program draws its icon at any size: coordinates are signed bytes in
+ * icon units, 128 to the icon's nominal size with the origin at its
+ * center, scaled to 1/16 pixel and rasterized in fixed point. Consecutive
+ * shapes of one paint are rasterized together a row at a time and their
+ * spans merged, so where they overlap (the circles of a dithered cloud)
+ * each pixel is painted once.
+ *
+ * Each shape is an opcode byte (op << 4 | ICON_DITHER | ink) followed by
+ * its operands:
+ *
+ *   ICON_CIRCLE   cx cy r          disc
+ *   ICON_RING     cx cy r w        outer radius r, w thick
+ *   ICON_CAPSULE  x0 y0 x1 y1 w    segment w wide with round ends
+ *   ICON_POLYGON  n x0 y0 ...      n points, even-odd fill
+ *   ICON_RECT     x y w h
+ *
+ * and ICON_END ends the program. r, w, h and n are unsigned. A pixel is
+ * inside a shape if its center is, so shapes match the existing fillCircle
+ * and fillRect placement. Portable like the rest of the rendering code.
+ */
+
+#ifndef VECTOR_ICON_H
+#define VECTOR_ICON_H
+
+#include "framebuffer.h"
+#include "icon_data.h"
+#include <stdint.h>
+
+enum IconOp : uint8_t {
+  ICON_END = 0,
+  ICON_CIRCLE = 1,
+  ICON_RING = 2,
+  ICON_CAPSULE = 3,
+  ICON_POLYGON = 4,
+  ICON_RECT = 5,
+};
+
+#define ICON_DITHER 0x08 // ink only where (x + y) is even
+#define ICON_INK_MASK 0x07
+#define ICON_UNITS 128 // icon units across the nominal size
+#define ICON_MAX_POINTS 16
+#define ICON_MAX_SIZE 512 // pixels; keeps the fixed-point math in 32 bits
+
+// Draws program centered on (cx, cy), scaled so ICON_UNITS span size pixels
+void drawVectorIcon(FrameBuffer &fb, const uint8_t *program, int16_t cx,
+                    int16_t cy, int16_t size);
+
+inline void drawIcon(FrameBuffer &fb, IconId icon, int16_t cx, int16_t cy,
+                     int16_t size) {
+  drawVectorIcon(fb, ICON_PROGRAMS[icon], cx, cy, size);
+}
+
+#endif
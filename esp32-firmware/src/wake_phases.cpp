@@ -0,0 +1,192 @@
+#include "wake_phases.h"
+
+#include "cycles.h"
+#include <Arduino.h>
+#if CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
+
+static const char *PHASE_NAMES[PHASE_COUNT] = {
+    "boot",   "connect", "fetch", "transfer", "parse",
+    "render", "panel",   "store", "sleep"};
+static const bool PHASE_BOOST[PHASE_COUNT] = {
+    true, false, true, false, true, true, false, true, false};
+
+// Rough ESP32-S3 supply current (mA at 3.3 V) for the energy estimate: CPU
+// active at each clock, plus the radio while associating and transferring.
+// The panel's own draw does not depend on the CPU clock and is left out.
+#define SUPPLY_VOLTS 3.3f
+#define CPU_MA_HIGH 50.0f
+#define CPU_MA_LOW 25.0f
+#define RADIO_MA 80.0f
+static const bool PHASE_RADIO[PHASE_COUNT] = {
+    false, true, true, true, false, false, false, false, false};
+
+static uint32_t phaseUs[PHASE_COUNT];
+static uint64_t phaseCycles[PHASE_COUNT];
+static uint16_t phaseMhz[PHASE_COUNT];
+static WakePhase current = PHASE_BOOT;
+// Both counters start near zero at reset, which makes boot the first phase
+static uint32_t startUs = 0;
+static uint32_t startCycles = 0;
+static bool scaling = false;
+// phaseBoostAcquire() holds; the mutex also orders the clock switches of
+// the tasks that take and release them
+static int boostHolds = 0;
+static SemaphoreHandle_t clockMutex;
+
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t boostLock;
+static esp_pm_lock_handle_t holdLock;
+static bool boostHeld = false;
+#endif
+
+void phaseScalingBegin(bool enable) {
+  scaling = enable;
+  if (enable) {
+    clockMutex = xSemaphoreCreateMutex();
+  }
+#if CONFIG_PM_ENABLE
+  if (enable) {
+    // Without a lock held the clock drops to the minimum; no light sleep,
+    // since the wake is short and WiFi stays associated
+    esp_pm_config_esp32s3_t config = {};
+    config.max_freq_mhz = PHASE_MHZ_HIGH;
+    config.min_freq_mhz = PHASE_MHZ_LOW;
+    config.light_sleep_enable = false;
+    if (esp_pm_configure(&config) != ESP_OK ||
+        esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "phase", &boostLock) !=
+            ESP_OK ||
+        esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "hold", &holdLock) !=
+            ESP_OK) {
+      Serial.println("Power management unavailable, using fixed clocks");
+      boostLock = nullptr;
+    } else {
+      esp_pm_lock_acquire(boostLock);
+      boostHeld = true;
+    }
+  }
+#endif
+  phaseMhz[current] = getCpuFrequencyMhz();
+}
+
+static void applyClock(WakePhase phase) {
+  if (!scaling) {
+    return;
+  }
+  bool boost = PHASE_BOOST[phase];
+#if CONFIG_PM_ENABLE
+  if (boostLock) {
+    if (boost && !boostHeld) {
+      esp_pm_lock_acquire(boostLock);
+    } else if (!boost && boostHeld) {
+      esp_pm_lock_release(boostLock);
+    }
+    boostHeld = boost;
+    return;
+  }
+#endif
+  xSemaphoreTake(clockMutex, portMAX_DELAY);
+  setCpuFrequencyMhz(boost || boostHolds > 0 ? PHASE_MHZ_HIGH : PHASE_MHZ_LOW);
+  xSemaphoreGive(clockMutex);
+}
+
+// Called with clockMutex held, after boostHolds has been updated
+static void holdClock(bool hold) {
+#if CONFIG_PM_ENABLE
+  if (boostLock) {
+    if (hold) {
+      esp_pm_lock_acquire(holdLock);
+    } else {
+      esp_pm_lock_release(holdLock);
+    }
+    return;
+  }
+#endif
+  if (hold) {
+    setCpuFrequencyMhz(PHASE_MHZ_HIGH);
+  } else if (boostHolds == 0 && !PHASE_BOOST[current]) {
+    setCpuFrequencyMhz(PHASE_MHZ_LOW);
+  }
+}
+
+void phaseBoostAcquire() {
+  if (!scaling) {
+    return;
+  }
+  xSemaphoreTake(clockMutex, portMAX_DELAY);
+  boostHolds++;
+  holdClock(true);
+  phaseMhz[current] = PHASE_MHZ_HIGH;
+  xSemaphoreGive(clockMutex);
+}
+
+void phaseBoostRelease() {
+  if (!scaling) {
+    return;
+  }
+  xSemaphoreTake(clockMutex, portMAX_DELAY);
+  boostHolds--;
+  holdClock(false);
+  xSemaphoreGive(clockMutex);
+}
+
+static void endPhase() {
+  uint32_t us = micros() - startUs;
+  uint32_t cycles = cycleCount() - startCycles;
+  phaseUs[current] += us;
+  // CCOUNT wraps after ~18 s at 240 MHz; estimate long phases from time
+  if (us > 15000000UL) {
+    phaseCycles[current] += (uint64_t)us * getCpuFrequencyMhz();
+  } else {
+    phaseCycles[current] += cycles;
+  }
+}
+
+void phaseBegin(WakePhase phase) {
+  endPhase();
+  current = phase;
+  applyClock(phase);
+  uint16_t mhz = getCpuFrequencyMhz();
+  if (mhz > phaseMhz[phase]) {
+    phaseMhz[phase] = mhz;
+  }
+  startUs = micros();
+  startCycles = cycleCount();
+}
+
+WakePhase IRAM_ATTR currentPhase() { return current; }
+
+const char *phaseName(WakePhase phase) { return PHASE_NAMES[phase]; }
+
+static float phaseMillijoules(int phase, uint16_t mhz) {
+  float ma = mhz >= PHASE_MHZ_HIGH ? CPU_MA_HIGH : CPU_MA_LOW;
+  if (PHASE_RADIO[phase]) {
+    ma += RADIO_MA;
+  }
+  return ma * SUPPLY_VOLTS * phaseUs[phase] / 1e6f;
+}
+
+void printPhases() {
+  endPhase();
+  startUs = micros();
+  startCycles = cycleCount();
+  float total = 0;
+  float fixedHigh = 0;
+  for (int i = 0; i < PHASE_COUNT; i++) {
+    if (phaseUs[i] == 0) {
+      continue;
+    }
+    float mj = phaseMillijoules(i, phaseMhz[i]);
+    total += mj;
+    // Waiting phases take as long at any clock; compute phases already
+    // run at the high clock
+    fixedHigh += phaseMillijoules(i, PHASE_MHZ_HIGH);
+    Serial.printf("PHASE %s us=%lu cycles=%llu mhz=%u mj=%.1f\n",
+                  PHASE_NAMES[i], (unsigned long)phaseUs[i],
+                  (unsigned long long)phaseCycles[i], phaseMhz[i], mj);
+  }
+  Serial.printf("ENERGY mj=%.1f fixed_%u_mhz_mj=%.1f saved=%.0f%%\n", total,
+                PHASE_MHZ_HIGH, fixedHigh,
+                fixedHigh > 0 ? 100 * (fixedHigh - total) / fixedHigh : 0);
+}
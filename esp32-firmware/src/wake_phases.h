@@ -0,0 +1,51 @@
+/*
+ * Where a wake spends its time, and at which CPU clock
+ *
+ * The wake is split into consecutive phases; starting one ends the previous
+ * one. With scaling enabled, phases that mostly wait (association, HTTP
+ * body, panel BUSY, sleep prep) run at PHASE_MHZ_LOW and compute phases
+ * (TLS, parsing, rendering, compression) at PHASE_MHZ_HIGH. This uses an
+ * ESP_PM_CPU_FREQ_MAX lock when the core is built with power management,
+ * otherwise setCpuFrequencyMhz().
+ *
+ * Work that runs inside a low clock phase, such as the pipelined renders
+ * during the HTTP body, holds the high clock with phaseBoostAcquire().
+ *
+ * printPhases() reports time, cycles, clock and estimated energy per phase
+ * as "PHASE" lines (at the highest clock the phase ran at), plus an "ENERGY" line comparing the estimate against
+ * running every phase at PHASE_MHZ_HIGH.
+ */
+
+#ifndef WAKE_PHASES_H
+#define WAKE_PHASES_H
+
+#include <stdint.h>
+
+#define PHASE_MHZ_HIGH 240
+#define PHASE_MHZ_LOW 80
+
+enum WakePhase : uint8_t {
+  PHASE_BOOT,     // reset until setup() has storage up
+  PHASE_CONNECT,  // WiFi association and time sync
+  PHASE_FETCH,    // DNS, TLS handshake and request
+  PHASE_TRANSFER, // HTTP body
+  PHASE_PARSE,    // JSON to model
+  PHASE_RENDER,   // draw, hash, pre-render
+  PHASE_PANEL,    // frame to the panel and refresh
+  PHASE_STORE,    // compression, LittleFS and NVS writes
+  PHASE_SLEEP,    // planning and shutdown
+  PHASE_COUNT
+};
+
+void phaseScalingBegin(bool enable);
+void phaseBegin(WakePhase phase);
+// Keeps PHASE_MHZ_HIGH whatever the phase until the matching release.
+// Counted, and callable from any task.
+void phaseBoostAcquire();
+void phaseBoostRelease();
+void printPhases();
+// In IRAM, so interrupts can tag what they see with it (profiler.h)
+WakePhase currentPhase();
+const char *phaseName(WakePhase phase);
+
+#endif
@@ -0,0 +1,51 @@
+#include "wake_trace.h"
+
+#include <string.h>
+
+void traceBegin(WakeTrace &trace, uint32_t epoch, uint8_t wakeCause) {
+  memset(&trace, 0, sizeof(trace));
+  trace.header.magic = TRACE_MAGIC;
+  trace.header.epoch = epoch;
+  trace.header.wakeCause = wakeCause;
+}
+
+void traceEvent(WakeTrace &trace, uint32_t ms, uint8_t type, int32_t a,
+                uint32_t b) {
+  if (trace.header.count >= TRACE_MAX_EVENTS) {
+    return;
+  }
+  TraceEvent &e = trace.events[trace.header.count++];
+  e.ms = ms;
+  e.a = a;
+  e.b = b;
+  e.type = type;
+}
+
+size_t traceSize(const WakeTrace &trace) {
+  return sizeof(TraceHeader) + trace.header.count * sizeof(TraceEvent);
+}
+
+bool traceDecode(const uint8_t *data, size_t len, WakeTrace &trace) {
+  if (len < sizeof(TraceHeader)) {
+    return false;
+  }
+  memcpy(&trace.header, data, sizeof(TraceHeader));
+  if (trace.header.magic != TRACE_MAGIC ||
+      trace.header.count > TRACE_MAX_EVENTS || len != traceSize(trace)) {
+    return false;
+  }
+  memcpy(trace.events, data + sizeof(TraceHeader),
+         trace.header.count * sizeof(TraceEvent));
+  return true;
+}
+
+uint32_t traceHash(const void *data, size_t len, uint32_t seed) {
+  // FNV-1a, as FrameBuffer::hash()
+  const uint8_t *p = (const uint8_t *)data;
+  uint32_t h = seed;
+  for (size_t i = 0; i < len; i++) {
+    h ^= p[i];
+    h *= 16777619u;
+  }
+  return h;
+}
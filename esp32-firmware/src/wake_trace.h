@@ -0,0 +1,87 @@
+/*
+ * Compact per-wake event trace
+ *
+ * One trace per wake: a header with the wall clock at boot and the wake
+ * cause, then up to TRACE_MAX_EVENTS fixed-size events stamped with
+ * milliseconds since boot. The firmware captures them with -DWAKE_TRACE
+ * (see trace_store.h); tools/wake_sim replays them on the host.
+ *
+ * Event values:
+ *   TRACE_WIFI_OK      a = RSSI (dBm)          b = association ms
+ *   TRACE_WIFI_FAIL    a = WiFi status         b = ms spent
+ *   TRACE_TIME_SYNC    a = 1 if synced         b = epoch after sync
+ *   TRACE_DNS          a = 1 if resolved       b = ms
+ *   TRACE_HTTP         a = HTTP code (<0 for client errors)  b = ms
+ *   TRACE_TLS          a = mbedTLS error code  b = 0
+ *   TRACE_BODY         a = bytes               b = FNV-1a of the payload
+ *   TRACE_PARSE        a = 1 if parsed         b = 0
+ *   TRACE_REFRESH      a = 1 pushed, 0 skipped b = TraceRefresh
+ *   TRACE_SLEEP        a = sleep seconds       b = 1 if next wake fetches
+ */
+
+#ifndef WAKE_TRACE_H
+#define WAKE_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TRACE_MAGIC 0x31525457 // "WTR1"
+#define TRACE_MAX_EVENTS 24
+
+enum TraceEventType : uint8_t {
+  TRACE_WIFI_OK = 1,
+  TRACE_WIFI_FAIL,
+  TRACE_TIME_SYNC,
+  TRACE_DNS,
+  TRACE_HTTP,
+  TRACE_TLS,
+  TRACE_BODY,
+  TRACE_PARSE,
+  TRACE_REFRESH,
+  TRACE_SLEEP,
+};
+
+enum TraceRefresh : uint8_t {
+  TRACE_REFRESH_DATA,      // freshly fetched data
+  TRACE_REFRESH_PRERENDER, // frame pre-rendered before sleep
+  TRACE_REFRESH_PATCHED,   // highlight drawn on the last frame at wake
+  TRACE_REFRESH_ERROR,     // error screen
+  TRACE_REFRESH_CALENDAR,  // offline calendar from the provisioning image
+};
+
+struct TraceEvent {
+  uint32_t ms;
+  int32_t a;
+  uint32_t b;
+  uint8_t type;
+  uint8_t reserved[3];
+};
+
+struct TraceHeader {
+  uint32_t magic;
+  uint32_t epoch; // wall clock at boot, 0 if not yet known
+  uint8_t wakeCause;
+  uint8_t count;
+  uint16_t reserved;
+};
+
+struct WakeTrace {
+  TraceHeader header;
+  TraceEvent events[TRACE_MAX_EVENTS];
+};
+
+void traceBegin(WakeTrace &trace, uint32_t epoch, uint8_t wakeCause);
+// Drops events once the trace is full
+void traceEvent(WakeTrace &trace, uint32_t ms, uint8_t type, int32_t a,
+                uint32_t b);
+// Bytes used by the header and recorded events
+size_t traceSize(const WakeTrace &trace);
+// Validates and copies a serialized trace; false if malformed
+bool traceDecode(const uint8_t *data, size_t len, WakeTrace &trace);
+
+// FNV-1a; pass the previous result as seed to hash data arriving in pieces
+#define TRACE_HASH_SEED 2166136261u
+uint32_t traceHash(const void *data, size_t len,
+                   uint32_t seed = TRACE_HASH_SEED);
+
+#endif
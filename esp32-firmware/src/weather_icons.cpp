@@ -0,0 +1,234 @@
+// The procedural weather icons layout.cpp draws by default, and the
+// baseline for the icon benchmarks
+
+#include "weather_icons.h"
+
+#include "font.h"
+#include "render_model.h"
+#include <math.h>
+#include <string.h>
+#include <u8g2_fonts.h>
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+static bool startsWith(const char *s, const char *prefix) {
+  return strncmp(s, prefix, strlen(prefix)) == 0;
+}
+
+static void lowerCopy(char *dst, size_t size, const char *src) {
+  size_t i = 0;
+  for (; i + 1 < size && src[i]; i++) {
+    char c = src[i];
+    dst[i] = (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+  }
+  dst[i] = '\0';
+}
+
+// Draw small weather icon for forecast (based on condition text)
+void drawSmallWeatherIcon(FrameBuffer &fb, int x, int y,
+                          const char *conditionText) {
+  char condition[sizeof(ForecastModel::condition)];
+  lowerCopy(condition, sizeof(condition), conditionText);
+
+  // Clear/Sunny
+  if (strstr(condition, "clear") || strstr(condition, "sun")) {
+    // Orange sun - larger and bolder
+    fb.fillCircle(x, y, 14, INK_ORANGE);
+    for (int i = 0; i < 8; i++) {
+      float angle = i * PI / 4;
+      int x1 = x + cos(angle) * 18;
+      int y1 = y + sin(angle) * 18;
+      int x2 = x + cos(angle) * 26;
+      int y2 = y + sin(angle) * 26;
+      fb.drawLine(x1, y1, x2, y2, INK_ORANGE);
+      fb.drawLine(x1 + 1, y1, x2 + 1, y2, INK_ORANGE);
+    }
+  }
+  // Clouds
+  else if (strstr(condition, "cloud")) {
+    // Grey cloud - dithered for grey effect
+    fb.fillCircleDithered(x - 8, y, 12, INK_BLACK);
+    fb.fillCircleDithered(x + 8, y + 2, 10, INK_BLACK);
+    fb.fillCircleDithered(x, y - 6, 10, INK_BLACK);
+    fb.fillRectDithered(x - 18, y, 36, 14, INK_BLACK);
+  }
+  // Rain
+  else if (strstr(condition, "rain") ||
+           strstr(condition, "drizzle")) {
+    // Grey cloud + blue drops
+    fb.fillCircleDithered(x - 6, y - 8, 10, INK_BLACK);
+    fb.fillCircleDithered(x + 6, y - 6, 8, INK_BLACK);
+    fb.fillRectDithered(x - 16, y - 8, 32, 10, INK_BLACK);
+    // Rain drops - thicker
+    for (int i = 0; i < 3; i++) {
+      int dx = x - 10 + i * 10;
+      fb.fillCircle(dx, y + 10, 2, INK_BLUE);
+      fb.fillCircle(dx - 1, y + 14, 2, INK_BLUE);
+    }
+  }
+  // Snow
+  else if (strstr(condition, "snow")) {
+    // Blue snowflake - thicker lines
+    for (int i = 0; i < 3; i++) {
+      float angle = i * PI / 3;
+      int x1 = x - cos(angle) * 16;
+      int y1 = y - sin(angle) * 16;
+      int x2 = x + cos(angle) * 16;
+      int y2 = y + sin(angle) * 16;
+      fb.drawLine(x1, y1, x2, y2, INK_BLUE);
+      fb.drawLine(x1 + 1, y1, x2 + 1, y2, INK_BLUE);
+    }
+    fb.fillCircle(x, y, 5, INK_BLUE);
+  }
+  // Thunderstorm
+  else if (strstr(condition, "thunder") ||
+           strstr(condition, "storm")) {
+    // Grey cloud + yellow lightning
+    fb.fillCircleDithered(x - 6, y - 10, 10, INK_BLACK);
+    fb.fillCircleDithered(x + 6, y - 8, 8, INK_BLACK);
+    fb.fillRectDithered(x - 16, y - 10, 32, 10, INK_BLACK);
+    // Yellow lightning bolt
+    fb.fillTriangle(x - 4, y + 2, x + 6, y + 2, x + 2, y + 12,
+                         INK_YELLOW);
+    fb.fillTriangle(x, y + 10, x + 8, y + 10, x - 4, y + 22, INK_YELLOW);
+  }
+  // Mist/Fog
+  else if (strstr(condition, "mist") || strstr(condition, "fog") ||
+           strstr(condition, "haze")) {
+    for (int i = 0; i < 4; i++) {
+      fb.drawLine(x - 16, y - 10 + i * 7, x + 16, y - 10 + i * 7,
+                       INK_BLACK);
+      fb.drawLine(x - 16, y - 10 + i * 7 + 1, x + 16, y - 10 + i * 7 + 1,
+                       INK_BLACK);
+    }
+  }
+  // Default - question mark
+  else {
+    fb.drawCircle(x, y, 12, INK_BLACK);
+    fb.drawCircle(x, y, 11, INK_BLACK);
+  }
+}
+
+// Draw weather icon based on OpenWeatherMap icon code
+void drawWeatherIcon(FrameBuffer &fb, int x, int y, const char *iconCode) {
+  int size = 120; // Large icon size
+
+  // Clear/sunny (01d, 01n)
+  if (startsWith(iconCode, "01")) {
+    // Sun - solid ORANGE circle with ORANGE rays
+    fb.fillCircle(x, y, size / 3, INK_ORANGE);
+    // Rays - all ORANGE, thick
+    for (int i = 0; i < 8; i++) {
+      float angle = i * PI / 4;
+      int x1 = x + cos(angle) * (size / 3 + 8);
+      int y1 = y + sin(angle) * (size / 3 + 8);
+      int x2 = x + cos(angle) * (size / 2 + 5);
+      int y2 = y + sin(angle) * (size / 2 + 5);
+      fb.drawLine(x1, y1, x2, y2, INK_ORANGE);
+      fb.drawLine(x1 + 1, y1, x2 + 1, y2, INK_ORANGE);
+      fb.drawLine(x1, y1 + 1, x2, y2 + 1, INK_ORANGE);
+      fb.drawLine(x1 + 1, y1 + 1, x2 + 1, y2 + 1, INK_ORANGE);
+    }
+  }
+  // Few clouds (02d, 02n)
+  else if (startsWith(iconCode, "02")) {
+    // Small sun (all ORANGE) behind cloud
+    fb.fillCircle(x + 35, y - 25, 22, INK_ORANGE);
+    for (int i = 0; i < 8; i++) {
+      float angle = i * PI / 4;
+      int x1 = x + 35 + cos(angle) * 26;
+      int y1 = y - 25 + sin(angle) * 26;
+      int x2 = x + 35 + cos(angle) * 38;
+      int y2 = y - 25 + sin(angle) * 38;
+      fb.drawLine(x1, y1, x2, y2, INK_ORANGE);
+      fb.drawLine(x1 + 1, y1, x2 + 1, y2, INK_ORANGE);
+    }
+    // Cloud in front (DITHERED GREY)
+    fb.fillCircleDithered(x - 20, y + 10, 32, INK_BLACK);
+    fb.fillCircleDithered(x + 25, y + 15, 26, INK_BLACK);
+    fb.fillCircleDithered(x + 5, y - 8, 28, INK_BLACK);
+    fb.fillRectDithered(x - 52, y + 10, 104, 35, INK_BLACK);
+  }
+  // Scattered/broken clouds (03d, 03n, 04d, 04n)
+  else if (startsWith(iconCode, "03") || startsWith(iconCode, "04")) {
+    // Cloud shape (DITHERED GREY) - larger
+    fb.fillCircleDithered(x - 20, y + 10, 36, INK_BLACK);
+    fb.fillCircleDithered(x + 30, y + 10, 28, INK_BLACK);
+    fb.fillCircleDithered(x + 10, y - 16, 32, INK_BLACK);
+    fb.fillRectDithered(x - 56, y + 10, 116, 40, INK_BLACK);
+  }
+  // Rain (09d, 09n, 10d, 10n)
+  else if (startsWith(iconCode, "09") || startsWith(iconCode, "10")) {
+    // Cloud (DITHERED GREY) + rain drops (BLUE)
+    fb.fillCircleDithered(x - 20, y - 20, 28, INK_BLACK);
+    fb.fillCircleDithered(x + 20, y - 20, 24, INK_BLACK);
+    fb.fillCircleDithered(x, y - 36, 24, INK_BLACK);
+    fb.fillRectDithered(x - 48, y - 20, 96, 28, INK_BLACK);
+    // Rain drops (BLUE) - larger and thicker
+    for (int i = 0; i < 4; i++) {
+      int dx = x - 30 + i * 20;
+      fb.drawLine(dx, y + 20, dx - 10, y + 50, INK_BLUE);
+      fb.drawLine(dx + 1, y + 20, dx - 9, y + 50, INK_BLUE);
+      fb.drawLine(dx + 2, y + 20, dx - 8, y + 50, INK_BLUE);
+      fb.drawLine(dx + 3, y + 20, dx - 7, y + 50, INK_BLUE);
+    }
+  }
+  // Thunderstorm (11d, 11n)
+  else if (startsWith(iconCode, "11")) {
+    // Cloud (DITHERED GREY) + lightning (YELLOW)
+    fb.fillCircleDithered(x - 20, y - 20, 28, INK_BLACK);
+    fb.fillCircleDithered(x + 20, y - 20, 24, INK_BLACK);
+    fb.fillCircleDithered(x, y - 36, 24, INK_BLACK);
+    fb.fillRectDithered(x - 48, y - 20, 96, 28, INK_BLACK);
+    // Lightning bolt (YELLOW) - larger
+    fb.fillTriangle(x - 5, y + 10, x + 18, y + 10, x + 8, y + 40,
+                         INK_YELLOW);
+    fb.fillTriangle(x + 5, y + 32, x + 28, y + 32, x - 8, y + 70,
+                         INK_YELLOW);
+  }
+  // Snow (13d, 13n)
+  else if (startsWith(iconCode, "13")) {
+    // Snowflake pattern (BLUE) - larger
+    for (int i = 0; i < 3; i++) {
+      float angle = i * PI / 3;
+      fb.drawLine(x - cos(angle) * 50, y - sin(angle) * 50,
+                       x + cos(angle) * 50, y + sin(angle) * 50, INK_BLUE);
+      fb.drawLine(x - cos(angle) * 50 + 1, y - sin(angle) * 50,
+                       x + cos(angle) * 50 + 1, y + sin(angle) * 50,
+                       INK_BLUE);
+      fb.drawLine(x - cos(angle) * 50 + 2, y - sin(angle) * 50,
+                       x + cos(angle) * 50 + 2, y + sin(angle) * 50,
+                       INK_BLUE);
+    }
+    // Small branches on snowflake
+    for (int i = 0; i < 6; i++) {
+      float angle = i * PI / 3;
+      int mx = x + cos(angle) * 30;
+      int my = y + sin(angle) * 30;
+      fb.drawLine(mx, my, mx + cos(angle + PI / 6) * 15,
+                       my + sin(angle + PI / 6) * 15, INK_BLUE);
+      fb.drawLine(mx, my, mx + cos(angle - PI / 6) * 15,
+                       my + sin(angle - PI / 6) * 15, INK_BLUE);
+    }
+    fb.fillCircle(x, y, 8, INK_BLUE);
+  }
+  // Mist/fog (50d, 50n)
+  else if (startsWith(iconCode, "50")) {
+    // Horizontal lines - larger
+    for (int i = 0; i < 5; i++) {
+      fb.drawLine(x - 50, y - 30 + i * 15, x + 50, y - 30 + i * 15,
+                       INK_BLACK);
+      fb.drawLine(x - 50, y - 30 + i * 15 + 1, x + 50, y - 30 + i * 15 + 1,
+                       INK_BLACK);
+      fb.drawLine(x - 50, y - 30 + i * 15 + 2, x + 50, y - 30 + i * 15 + 2,
+                       INK_BLACK);
+    }
+  }
+  // Default - question mark
+  else {
+    fb.drawCircle(x, y, size / 2, INK_BLACK);
+    drawText(fb, u8g2_font_helvB24_tf, x - 12, y + 12, "?", INK_BLACK);
+  }
+}
@@ -0,0 +1,19 @@
+/*
+ * Procedural weather icons, drawn with framebuffer primitives
+ *
+ * These are the icons the layout draws. The vector icons in vector_icon.h
+ * replace them only when VECTOR_ICONS is set (see layout.cpp).
+ */
+
+#ifndef WEATHER_ICONS_H
+#define WEATHER_ICONS_H
+
+#include "framebuffer.h"
+
+// Forecast box icon from condition text (about 52 px)
+void drawSmallWeatherIcon(FrameBuffer &fb, int x, int y,
+                          const char *conditionText);
+// Weather icon from an OpenWeatherMap icon code (size 120)
+void drawWeatherIcon(FrameBuffer &fb, int x, int y, const char *iconCode);
+
+#endif
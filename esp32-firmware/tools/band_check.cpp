@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "band_render.h"
+#include "framebuffer.h"
+#include "json.hpp" // The nlohmann/json library
+#include "layout.h"
+#include "payload_model.h"
+#include "render_model.h"
+
+using json = nlohmann::json;
+
+/**
+ * @brief Checks band rendering against full-frame rendering.
+ *
+ * Renders each payload (every next-prayer highlight, plus the error screen)
+ * once into a full frame and once band by band for several band heights,
+ * reassembles the bands and compares them byte for byte with the full
+ * frame, and the chained band hash with the full-frame hash. Frame sizes
+ * are the current 800x480 panel and 1600x1200 / 1200x1600 panels (the
+ * layout stays in the top left corner of the larger frames). Times both
+ * renders, so the cost per pixel of each band height can be compared.
+ *
+ * Usage: band_check [--rows N]... [--repeat N] payload.json...
+ */
+
+struct FrameSize {
+  int16_t width;
+  int16_t height;
+};
+
+static const FrameSize SIZES[] = {{800, 480}, {1600, 1200}, {1200, 1600}};
+static const int16_t DEFAULT_ROWS[] = {1, 7, 16, 64, 240};
+
+struct Screen {
+  bool message;
+  RenderModel model;
+};
+
+static void paintScreen(void *ctx, FrameBuffer &fb) {
+  const Screen &screen = *static_cast<const Screen *>(ctx);
+  if (screen.message) {
+    renderMessage(fb, "Connection Failed", "Could not connect to WiFi");
+  } else {
+    renderWidgets(fb, screen.model, WIDGET_ALL);
+  }
+}
+
+// Copies each band into its place in a full-size frame
+static bool assembleSink(void *ctx, const FrameBuffer &band) {
+  uint8_t *frame = static_cast<uint8_t *>(ctx);
+  memcpy(frame + (size_t)band.bandTop() * band.width() / 2, band.data(),
+         band.size());
+  return true;
+}
+
+static bool discardSink(void *, const FrameBuffer &) { return true; }
+
+template <typename Fn> static double timeMs(int repeat, Fn fn) {
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeat; i++) {
+    fn();
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(t1 - t0).count() / repeat;
+}
+
+int main(int argc, char *argv[]) {
+  std::vector<int16_t> bandRows;
+  std::vector<std::string> payloads;
+  int repeat = 20;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--rows" && i + 1 < argc) {
+      bandRows.push_back(std::atoi(argv[++i]));
+    } else if (arg == "--repeat" && i + 1 < argc) {
+      repeat = std::max(1, std::atoi(argv[++i]));
+    } else {
+      payloads.push_back(arg);
+    }
+  }
+  if (payloads.empty() || (!bandRows.empty() && bandRows[0] <= 0)) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--rows N]... [--repeat N] payload.json..." << std::endl;
+    return 1;
+  }
+  if (bandRows.empty()) {
+    bandRows.assign(std::begin(DEFAULT_ROWS), std::end(DEFAULT_ROWS));
+  }
+
+  std::vector<Screen> screens = {{true, {}}};
+  for (const std::string &path : payloads) {
+    std::ifstream in(path);
+    json doc;
+    try {
+      doc = json::parse(in);
+    } catch (json::parse_error &e) {
+      std::cerr << "Error: " << path << ": " << e.what() << std::endl;
+      return 1;
+    }
+    RenderModel base = modelFromPayload(doc);
+    for (int highlight = -1; highlight < 6; highlight++) {
+      Screen screen = {false, base};
+      screen.model.highlight = highlight;
+      screens.push_back(screen);
+    }
+  }
+
+  int failures = 0;
+  for (const FrameSize &size : SIZES) {
+    size_t frameBytes = (size_t)size.width / 2 * size.height;
+    std::vector<uint8_t> reference(frameBytes);
+    std::vector<uint8_t> assembled(frameBytes);
+    FrameBuffer full(reference.data(), size.width, size.height);
+    double pixels = (double)size.width * size.height;
+
+    // 1. Every screen, every band height: same bytes, same hash
+    for (Screen &screen : screens) {
+      paintScreen(&screen, full);
+      uint32_t fullHash = full.hash();
+      for (int16_t rows : bandRows) {
+        std::vector<uint8_t> bandData((size_t)size.width / 2 * rows);
+        FrameBuffer band(bandData.data(), size.width, size.height, rows);
+        memset(assembled.data(), 0x11, frameBytes);
+        uint32_t bandHash = 0;
+        renderBands(band, paintScreen, &screen, assembleSink,
+                    assembled.data(), &bandHash);
+        if (bandHash != fullHash || assembled != reference) {
+          size_t at = 0;
+          while (at < frameBytes && assembled[at] == reference[at]) {
+            at++;
+          }
+          std::printf("MISMATCH %dx%d rows=%d highlight=%d first_diff_row=%zu "
+                      "hash=%08x/%08x\n",
+                      size.width, size.height, rows,
+                      screen.message ? -2 : screen.model.highlight,
+                      at / (size.width / 2), bandHash, fullHash);
+          failures++;
+        }
+      }
+    }
+
+    // 2. Cost of one screen full-frame and per band height, both including
+    // the frame hash the firmware takes of every frame
+    Screen &screen = screens.back();
+    uint32_t sink = 0;
+    double fullMs = timeMs(repeat, [&] {
+      paintScreen(&screen, full);
+      sink ^= full.hash();
+    });
+    std::printf("%4dx%-4d full      %6zu KB %8.3f ms %6.2f ns/px\n",
+                size.width, size.height, frameBytes / 1024, fullMs,
+                fullMs * 1e6 / pixels);
+    for (int16_t rows : bandRows) {
+      std::vector<uint8_t> bandData((size_t)size.width / 2 * rows);
+      FrameBuffer band(bandData.data(), size.width, size.height, rows);
+      double ms = timeMs(repeat, [&] {
+        uint32_t hash;
+        renderBands(band, paintScreen, &screen, discardSink, nullptr, &hash);
+        sink ^= hash;
+      });
+      std::printf("%4dx%-4d rows=%-4d %6zu KB %8.3f ms %6.2f ns/px "
+                  "x%.2f\n",
+                  size.width, size.height, rows, bandData.size() / 1024, ms,
+                  ms * 1e6 / pixels, ms / fullMs);
+    }
+  }
+
+  std::printf("screens=%zu sizes=%zu band_heights=%zu mismatches=%d\n",
+              screens.size(), sizeof(SIZES) / sizeof(SIZES[0]),
+              bandRows.size(), failures);
+  return failures ? 1 : 0;
+}
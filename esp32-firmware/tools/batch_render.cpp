@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "frame_codec.h"
+#include "framebuffer.h"
+#include "json.hpp" // The nlohmann/json library
+#include "layout.h"
+#include "payload_model.h"
+#include "render_model.h"
+
+using json = nlohmann::json;
+
+#define SCREEN_WIDTH 800
+#define SCREEN_HEIGHT 480
+
+/**
+ * @brief Pre-renders every device's next frames at publish time.
+ *
+ * Each payload (same format as display_data.json) yields one frame per
+ * next-prayer highlight. Identical render models are rendered once; the
+ * rest are spread over a work-stealing thread pool and written as
+ * RLE-compressed frames plus a manifest.json mapping payloads to files.
+ *
+ * Usage: batch_render [--out DIR] [--threads N] [--scaling] payload.json...
+ */
+
+struct RenderJob {
+  RenderModel model;
+  std::string file;
+  uint32_t frameHash = 0;
+  size_t encodedSize = 0;
+};
+
+struct ManifestEntry {
+  std::string payload;
+  std::string location;
+  int highlight;
+  size_t job;
+};
+
+// Per-worker deques: owners pop from the back, idle workers steal from the
+// front of someone else's. The job set is fixed up front, so a worker that
+// finds every deque empty is done.
+class WorkStealingPool {
+public:
+  explicit WorkStealingPool(unsigned threads) : queues(threads) {}
+
+  template <typename Fn> void run(size_t jobCount, Fn fn) {
+    for (size_t i = 0; i < jobCount; i++) {
+      queues[i % queues.size()].jobs.push_back(i);
+    }
+    std::vector<std::thread> workers;
+    for (unsigned w = 0; w < queues.size(); w++) {
+      workers.emplace_back([this, w, &fn] {
+        size_t job;
+        while (take(w, job)) {
+          fn(w, job);
+        }
+      });
+    }
+    for (auto &t : workers) {
+      t.join();
+    }
+  }
+
+  size_t steals() const { return stolen.load(); }
+
+private:
+  struct Queue {
+    std::mutex lock;
+    std::deque<size_t> jobs;
+  };
+
+  bool take(unsigned self, size_t &job) {
+    {
+      Queue &own = queues[self];
+      std::lock_guard<std::mutex> guard(own.lock);
+      if (!own.jobs.empty()) {
+        job = own.jobs.back();
+        own.jobs.pop_back();
+        return true;
+      }
+    }
+    for (size_t i = 1; i < queues.size(); i++) {
+      Queue &victim = queues[(self + i) % queues.size()];
+      std::lock_guard<std::mutex> guard(victim.lock);
+      if (!victim.jobs.empty()) {
+        job = victim.jobs.front();
+        victim.jobs.pop_front();
+        stolen++;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::vector<Queue> queues;
+  std::atomic<size_t> stolen{0};
+};
+
+static uint64_t modelKey(const RenderModel &model) {
+  // FNV-1a 64 over the zero-padded model bytes
+  const uint8_t *p = reinterpret_cast<const uint8_t *>(&model);
+  uint64_t h = 14695981039346656037ull;
+  for (size_t i = 0; i < sizeof(model); i++) {
+    h ^= p[i];
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+static bool vectorSink(void *ctx, const uint8_t *data, size_t len) {
+  auto *out = static_cast<std::vector<uint8_t> *>(ctx);
+  out->insert(out->end(), data, data + len);
+  return true;
+}
+
+// Renders the given jobs on `threads` workers; returns wall time in seconds
+static double renderAll(std::vector<RenderJob> &jobs, unsigned threads,
+                        const std::string *outDir, size_t &steals) {
+  std::vector<std::vector<uint8_t>> buffers(
+      threads, std::vector<uint8_t>(SCREEN_WIDTH / 2 * SCREEN_HEIGHT));
+  std::vector<std::vector<uint8_t>> encoded(threads);
+  WorkStealingPool pool(threads);
+
+  auto t0 = std::chrono::steady_clock::now();
+  pool.run(jobs.size(), [&](unsigned w, size_t i) {
+    FrameBuffer fb(buffers[w].data(), SCREEN_WIDTH, SCREEN_HEIGHT);
+    renderWidgets(fb, jobs[i].model, WIDGET_ALL);
+    jobs[i].frameHash = fb.hash();
+    encoded[w].clear();
+    jobs[i].encodedSize =
+        rleEncode(fb.data(), fb.size(), vectorSink, &encoded[w]);
+    if (outDir) {
+      std::ofstream out(*outDir + "/" + jobs[i].file, std::ios::binary);
+      out.write(reinterpret_cast<const char *>(encoded[w].data()),
+                encoded[w].size());
+    }
+  });
+  auto t1 = std::chrono::steady_clock::now();
+  steals = pool.steals();
+  return std::chrono::duration<double>(t1 - t0).count();
+}
+
+int main(int argc, char *argv[]) {
+  std::string outDir = "frames";
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  bool scaling = false;
+  std::vector<std::string> payloads;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--out" && i + 1 < argc) {
+      outDir = argv[++i];
+    } else if (arg == "--threads" && i + 1 < argc) {
+      threads = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--scaling") {
+      scaling = true;
+    } else {
+      payloads.push_back(arg);
+    }
+  }
+  if (payloads.empty()) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--out DIR] [--threads N] [--scaling] payload.json..."
+              << std::endl;
+    return 1;
+  }
+
+  // 1. Expand payloads into render inputs, deduplicating identical models
+  std::vector<RenderJob> jobs;
+  std::vector<ManifestEntry> entries;
+  std::unordered_map<uint64_t, size_t> seen;
+  for (const std::string &path : payloads) {
+    std::ifstream in(path);
+    json doc;
+    try {
+      doc = json::parse(in);
+    } catch (json::parse_error &e) {
+      std::cerr << "Error: " << path << ": " << e.what() << std::endl;
+      return 1;
+    }
+    RenderModel base = modelFromPayload(doc);
+    for (int highlight = 0; highlight < 6; highlight++) {
+      RenderModel model = base;
+      model.highlight = highlight;
+      uint64_t key = modelKey(model);
+      auto it = seen.find(key);
+      if (it == seen.end()) {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.rle", (unsigned long long)key);
+        it = seen.emplace(key, jobs.size()).first;
+        jobs.push_back({model, name});
+      }
+      entries.push_back({path, base.location, highlight, it->second});
+    }
+  }
+
+  // 2. Render, compress and write
+  std::error_code ec;
+  std::filesystem::create_directories(outDir, ec);
+  if (ec) {
+    std::cerr << "Error: Could not create '" << outDir << "'" << std::endl;
+    return 1;
+  }
+  size_t steals = 0;
+  double seconds = renderAll(jobs, threads, &outDir, steals);
+
+  // 3. Manifest
+  json manifest;
+  manifest["width"] = SCREEN_WIDTH;
+  manifest["height"] = SCREEN_HEIGHT;
+  manifest["format"] = "rle-4bpp";
+  manifest["unique_frames"] = jobs.size();
+  manifest["frames"] = json::array();
+  for (const ManifestEntry &e : entries) {
+    const RenderJob &job = jobs[e.job];
+    char hash[9];
+    snprintf(hash, sizeof(hash), "%08x", job.frameHash);
+    manifest["frames"].push_back({{"payload", e.payload},
+                                  {"location", e.location},
+                                  {"highlight", e.highlight},
+                                  {"file", job.file},
+                                  {"frame_hash", hash},
+                                  {"size", job.encodedSize}});
+  }
+  std::ofstream(outDir + "/manifest.json") << manifest.dump(2) << std::endl;
+
+  std::printf("frames=%zu unique=%zu threads=%u seconds=%.3f fps=%.1f "
+              "steals=%zu\n",
+              entries.size(), jobs.size(), threads, seconds,
+              jobs.size() / seconds, steals);
+
+  // 4. Optional scaling sweep, render + compress only
+  if (scaling) {
+    // Enough work per run for stable numbers even with few payloads
+    std::vector<RenderJob> bench;
+    while (bench.size() < 512) {
+      bench.insert(bench.end(), jobs.begin(), jobs.end());
+    }
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    double fps1 = 0;
+    for (unsigned n = 1; n <= maxThreads; n++) {
+      double s = renderAll(bench, n, nullptr, steals);
+      double fps = bench.size() / s;
+      if (n == 1) {
+        fps1 = fps;
+      }
+      std::printf("scaling threads=%u fps=%.1f speedup=%.2f efficiency=%.2f "
+                  "steals=%zu\n",
+                  n, fps, fps / fps1, fps / (fps1 * n), steals);
+    }
+  }
+  return 0;
+}
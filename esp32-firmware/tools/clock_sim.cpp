@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "http_date.h"
+#include "json.hpp" // The nlohmann/json library
+#include "payload_model.h"
+#include "render_model.h"
+#include "schedule.h"
+
+using json = nlohmann::json;
+
+/**
+ * @brief Clock error of the HTTP Date sync against NTP over a month.
+ *
+ * Follows the firmware's schedule for --days days (planNextWake() from
+ * src/schedule.cpp with the prayer times in payload.json): the daily data
+ * wake and a highlight wake per prayer. Two devices wake side by side. At
+ * every data wake one sets its clock from the response's Date header with
+ * the firmware's estimate (src/http_date.cpp), the other from an NTP
+ * exchange with round-trip compensation, the best SNTP can do. Between
+ * syncs both RTCs run --drift-ppm fast, plus a random walk of --wander-ppm
+ * a day (temperature). One-way network delays are drawn around --rtt-ms/2
+ * (lognormal, spread --jitter), and the server stamps Date after up to
+ * --server-ms. The server clocks are taken as exact.
+ *
+ * Prints the clock error right after each data wake's sync, then
+ * percentiles of the error after syncs and at highlight wakes for both
+ * devices, and the NTP exchanges each needed. The firmware logs how far
+ * the RTC was off at each Date sync; that measures --drift-ppm.
+ *
+ * Usage: clock_sim [--days N] [--tz TZ] [--data-wake HH:MM]
+ *                  [--drift-ppm P] [--wander-ppm P] [--rtt-ms N]
+ *                  [--jitter S] [--server-ms N] [--seed N] [--quiet]
+ *                  payload.json
+ */
+
+// Firmware defaults (main.cpp)
+#define DEFAULT_TZ "CET-1CEST,M3.5.0,M10.5.0/3"
+#define DEFAULT_DATA_WAKE "00:10"
+#define PRERENDER_TOLERANCE_SEC 600
+// Awake time before sleeping, on the crystal, so without drift
+#define FETCH_AWAKE_S 9
+#define HIGHLIGHT_AWAKE_S 3
+
+struct ErrorStats {
+  std::vector<double> ms;
+  void add(double v) { ms.push_back(v); }
+  void print(const char *name) {
+    std::vector<double> a;
+    for (double v : ms) {
+      a.push_back(std::fabs(v));
+    }
+    std::sort(a.begin(), a.end());
+    auto at = [&](double q) {
+      return a.empty() ? 0.0
+                       : a[std::min(a.size() - 1, (size_t)(q * a.size()))];
+    };
+    double sum = 0;
+    for (double v : ms) {
+      sum += v;
+    }
+    std::printf("%-22s n=%-4zu mean=%+9.1f |p50|=%9.1f |p95|=%9.1f "
+                "|max|=%9.1f ms\n",
+                name, ms.size(), ms.empty() ? 0.0 : sum / ms.size(), at(0.5),
+                at(0.95), a.empty() ? 0.0 : a.back());
+  }
+};
+
+static long secondOfDay(time_t t) {
+  struct tm local;
+  localtime_r(&t, &local);
+  return local.tm_hour * 3600L + local.tm_min * 60 + local.tm_sec;
+}
+
+static std::string localTime(time_t t) {
+  char buf[32];
+  struct tm local;
+  localtime_r(&t, &local);
+  strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &local);
+  return buf;
+}
+
+int main(int argc, char *argv[]) {
+  std::string payloadPath;
+  std::string tz = DEFAULT_TZ;
+  std::string dataWake = DEFAULT_DATA_WAKE;
+  int days = 30;
+  double driftPpm = 1000;
+  double wanderPpm = 200;
+  double rttMs = 80;
+  double jitter = 0.5;
+  double serverMs = 20;
+  unsigned seed = 1;
+  bool quiet = false;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--days" && i + 1 < argc) {
+      days = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--tz" && i + 1 < argc) {
+      tz = argv[++i];
+    } else if (arg == "--data-wake" && i + 1 < argc) {
+      dataWake = argv[++i];
+    } else if (arg == "--drift-ppm" && i + 1 < argc) {
+      driftPpm = std::atof(argv[++i]);
+    } else if (arg == "--wander-ppm" && i + 1 < argc) {
+      wanderPpm = std::atof(argv[++i]);
+    } else if (arg == "--rtt-ms" && i + 1 < argc) {
+      rttMs = std::max(1.0, std::atof(argv[++i]));
+    } else if (arg == "--jitter" && i + 1 < argc) {
+      jitter = std::max(0.0, std::atof(argv[++i]));
+    } else if (arg == "--server-ms" && i + 1 < argc) {
+      serverMs = std::max(0.0, std::atof(argv[++i]));
+    } else if (arg == "--seed" && i + 1 < argc) {
+      seed = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--quiet") {
+      quiet = true;
+    } else {
+      payloadPath = arg;
+    }
+  }
+  int dataWakeMinute = parseClock(dataWake.c_str());
+  if (payloadPath.empty() || dataWakeMinute < 0) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--days N] [--tz TZ] [--data-wake HH:MM] [--drift-ppm P]"
+                 " [--wander-ppm P] [--rtt-ms N] [--jitter S] [--server-ms N]"
+                 " [--seed N] [--quiet] payload.json"
+              << std::endl;
+    return 1;
+  }
+  setenv("TZ", tz.c_str(), 1);
+  tzset();
+
+  std::ifstream in(payloadPath);
+  json doc;
+  try {
+    doc = json::parse(in);
+  } catch (json::parse_error &e) {
+    std::cerr << "Error: " << payloadPath << ": " << e.what() << std::endl;
+    return 1;
+  }
+  RenderModel model = modelFromPayload(doc);
+
+  std::mt19937 rng(seed);
+  std::lognormal_distribution<> oneWay(std::log(rttMs / 2), jitter);
+  std::uniform_real_distribution<> server(0, serverMs);
+  std::uniform_real_distribution<> phase(0, 1000);
+  std::normal_distribution<> wander(0, wanderPpm);
+
+  // A fixed, DST-free start so runs are reproducible
+  struct tm start = {};
+  start.tm_year = 2026 - 1900;
+  start.tm_mon = 0;
+  start.tm_mday = 15;
+  start.tm_hour = dataWakeMinute / 60;
+  start.tm_min = dataWakeMinute % 60;
+  start.tm_isdst = -1;
+  time_t first = mktime(&start);
+  time_t end = first + days * 86400L;
+
+  // Clock minus true time in ms; the first wake syncs with NTP either way,
+  // since it also sets the time zone
+  double dateError = 0;
+  double ntpError = 0;
+  double ppm = driftPpm;
+  int ntpExchangesDate = 1;
+  int ntpExchangesNtp = 0;
+  int fetches = 0;
+  int lateHighlightsDate = 0;
+  int lateHighlightsNtp = 0;
+  ErrorStats dateSynced, ntpSynced, difference, dateAtHighlight,
+      ntpAtHighlight;
+  bool fetch = true;
+  long lastDay = -1;
+  for (time_t t = first; t < end;) {
+    long day = (t - first) / 86400;
+    if (day != lastDay) {
+      ppm += wander(rng);
+      lastDay = day;
+    }
+    if (fetch) {
+      fetches++;
+      // Date: stamped when the server made the response, whole seconds.
+      // The request leaves at any point within the wake's second.
+      double sentMs = t * 1000.0 + phase(rng);
+      double stampedMs = sentMs + oneWay(rng) + server(rng);
+      double trueNow = stampedMs + oneWay(rng);
+      int64_t date = (int64_t)std::floor(stampedMs / 1000);
+      uint32_t roundTrip = (uint32_t)std::lround(trueNow - sentMs);
+      dateError = (double)httpDateClockMs(date, roundTrip) - trueNow;
+      // NTP: offset from both legs, off by half their asymmetry
+      ntpError = (oneWay(rng) - oneWay(rng)) / 2;
+      // The old firmware synced before the request and again before sleep
+      ntpExchangesNtp += 2;
+      dateSynced.add(dateError);
+      ntpSynced.add(ntpError);
+      difference.add(dateError - ntpError);
+      if (!quiet) {
+        std::printf("%s fetch round trip %4u ms  date %+7.1f ms  "
+                    "ntp %+6.1f ms\n",
+                    localTime(t).c_str(), roundTrip, dateError, ntpError);
+      }
+    } else {
+      dateAtHighlight.add(dateError);
+      ntpAtHighlight.add(ntpError);
+      lateHighlightsDate +=
+          std::fabs(dateError) > PRERENDER_TOLERANCE_SEC * 1000.0;
+      lateHighlightsNtp +=
+          std::fabs(ntpError) > PRERENDER_TOLERANCE_SEC * 1000.0;
+    }
+
+    time_t asleep = t + (fetch ? FETCH_AWAKE_S : HIGHLIGHT_AWAKE_S);
+    WakePlan plan = planNextWake(model, secondOfDay(asleep),
+                                 dataWakeMinute * 60L, true);
+    fetch = plan.fetch;
+    model.highlight = plan.highlight;
+    // Both RTCs gain the same while asleep
+    double gained = plan.sleepSeconds * ppm / 1000.0;
+    dateError += gained;
+    ntpError += gained;
+    t = asleep + plan.sleepSeconds;
+  }
+
+  std::printf("%d days, %d fetches, rtt %.0f ms, rtc %+.0f ppm "
+              "(wander %.0f ppm/day)\n",
+              days, fetches, rttMs, driftPpm, wanderPpm);
+  dateSynced.print("after sync, date");
+  ntpSynced.print("after sync, ntp");
+  difference.print("date - ntp");
+  dateAtHighlight.print("at highlights, date");
+  ntpAtHighlight.print("at highlights, ntp");
+  std::printf("highlights past the pre-render tolerance: date=%d ntp=%d\n",
+              lateHighlightsDate, lateHighlightsNtp);
+  std::printf("ntp exchanges: date=%d ntp=%d\n", ntpExchangesDate,
+              ntpExchangesNtp);
+  return 0;
+}
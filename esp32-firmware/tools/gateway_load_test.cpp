@@ -0,0 +1,324 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <netinet/in.h>
+#include <poll.h>
+#include <random>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "json.hpp" // The nlohmann/json library
+#include "udp_sync.h"
+#include "wake_trace.h"
+
+using json = nlohmann::json;
+
+/**
+ * @brief A site's panels all waking in the same minute against lan_gateway.
+ *
+ * Each of --panels simulated panels starts at a random moment within
+ * --window seconds and fetches the payload once: over HTTP like the
+ * device, with the current ETag for the --known share (a panel that
+ * already shows it), or over the UDP sync protocol for the --udp share,
+ * using the device's client code. Up to --concurrency panels are in flight
+ * at once. Prints p50/p99/max response times per kind and the gateway's
+ * upstream requests during the run (from /_stats). Every body is checked
+ * against the gateway's ETag and every render model against its version;
+ * the exit status is 1 if any panel failed or got something else.
+ *
+ * Usage: gateway_load_test [--host IP] [--http-port N] [--udp-port N]
+ *                          [--path PATH] [--panels N] [--window S]
+ *                          [--known P] [--udp P] [--concurrency N]
+ */
+
+#define HTTP_TIMEOUT_MS 5000
+
+enum Kind { HTTP_NEW, HTTP_KNOWN, UDP_NEW, UDP_KNOWN, KINDS };
+static const char *KIND_NAMES[KINDS] = {"http", "http_etag", "udp",
+                                        "udp_known"};
+
+struct Panel {
+  double startS;
+  Kind kind;
+  double ms = 0;
+  std::string error;
+};
+
+struct Target {
+  sockaddr_in http;
+  sockaddr_in udp;
+  std::string host; // the Host header, as HTTPClient forms it
+  std::string path;
+  std::string etag;
+  uint32_t version;
+};
+
+// A whole GET exchange; empty status on failure
+static std::string httpGet(const sockaddr_in &addr, const std::string &request,
+                           std::string &response) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  timeval tv = {HTTP_TIMEOUT_MS / 1000, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  if (connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr))) {
+    close(fd);
+    return std::string("connect: ") + strerror(errno);
+  }
+  send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+  char buf[4096];
+  ssize_t n;
+  while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+    response.append(buf, n);
+  }
+  close(fd);
+  return n < 0 ? std::string("recv: ") + strerror(errno) : "";
+}
+
+static std::string request(const Target &t, const std::string &path,
+                           const std::string &etag) {
+  // As the device sends it, cache buster included
+  std::string r = "GET " + path + "?t=" + std::to_string(time(nullptr)) +
+                  " HTTP/1.0\r\nHost: " + t.host +
+                  "\r\nUser-Agent: ESP32HTTPClient\r\n";
+  if (!etag.empty()) {
+    r += "If-None-Match: " + etag + "\r\n";
+  }
+  return r + "\r\n";
+}
+
+static std::string runHttp(const Target &t, bool known) {
+  std::string response;
+  std::string error =
+      httpGet(t.http, request(t, t.path, known ? t.etag : ""), response);
+  if (!error.empty()) {
+    return error;
+  }
+  int status = 0;
+  sscanf(response.c_str(), "HTTP/%*s %d", &status);
+  size_t split = response.find("\r\n\r\n");
+  if (status != (known ? 304 : 200) || split == std::string::npos) {
+    return "status " + std::to_string(status);
+  }
+  if (!known) {
+    std::string body = response.substr(split + 4);
+    char etag[16];
+    snprintf(etag, sizeof(etag), "\"%08x\"",
+             traceHash(body.data(), body.size()));
+    if (t.etag != etag) {
+      return std::string("body ") + etag + " is not " + t.etag;
+    }
+  }
+  return "";
+}
+
+static std::string runUdp(const Target &t, bool known, uint32_t id) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  uint8_t deviceId[6] = {0x02, 0, 0, (uint8_t)(id >> 16), (uint8_t)(id >> 8),
+                         (uint8_t)id};
+  RenderModel model;
+  SyncClient client;
+  syncClientBegin(client, deviceId, (uint16_t)std::random_device()(),
+                  known ? t.version : 0, reinterpret_cast<uint8_t *>(&model),
+                  sizeof(model));
+  uint8_t datagram[SYNC_MAX_DATAGRAM];
+  SyncStatus status = SYNC_PENDING;
+  SyncRequest req;
+  uint32_t timeoutMs;
+  while (status == SYNC_PENDING &&
+         syncClientRequest(client, req, timeoutMs) == SYNC_PENDING) {
+    sendto(fd, &req, sizeof(req), 0,
+           reinterpret_cast<const sockaddr *>(&t.udp), sizeof(t.udp));
+    auto sent = std::chrono::steady_clock::now();
+    auto deadline = sent + std::chrono::milliseconds(timeoutMs);
+    while (status == SYNC_PENDING) {
+      int left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     deadline - std::chrono::steady_clock::now())
+                     .count();
+      pollfd p = {fd, POLLIN, 0};
+      if (left <= 0 || poll(&p, 1, left) <= 0) {
+        break;
+      }
+      ssize_t n = recv(fd, datagram, sizeof(datagram), 0);
+      if (n > 0) {
+        status = syncClientReceive(client, datagram, n);
+      }
+    }
+  }
+  close(fd);
+  if (status != (known ? SYNC_SAME : SYNC_COMPLETE)) {
+    return status == SYNC_PENDING || status == SYNC_GAVE_UP
+               ? "gave up"
+               : "unexpected reply";
+  }
+  if (!known && client.request.haveVersion != t.version) {
+    return "wrong version";
+  }
+  return "";
+}
+
+static bool readStats(const sockaddr_in &addr, json &stats) {
+  std::string response;
+  if (!httpGet(addr, "GET /_stats HTTP/1.0\r\n\r\n", response).empty()) {
+    return false;
+  }
+  size_t split = response.find("\r\n\r\n");
+  stats = json::parse(response.substr(split + 4), nullptr, false);
+  return split != std::string::npos && !stats.is_discarded();
+}
+
+int main(int argc, char *argv[]) {
+  std::string host = "127.0.0.1";
+  int httpPort = 8080;
+  int udpPort = SYNC_PORT;
+  std::string path;
+  int panels = 500;
+  double window = 60;
+  double knownShare = 0.5;
+  double udpShare = 0.5;
+  int concurrency = 64;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--host" && i + 1 < argc) {
+      host = argv[++i];
+    } else if (arg == "--http-port" && i + 1 < argc) {
+      httpPort = std::atoi(argv[++i]);
+    } else if (arg == "--udp-port" && i + 1 < argc) {
+      udpPort = std::atoi(argv[++i]);
+    } else if (arg == "--path" && i + 1 < argc) {
+      path = argv[++i];
+    } else if (arg == "--panels" && i + 1 < argc) {
+      panels = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--window" && i + 1 < argc) {
+      window = std::atof(argv[++i]);
+    } else if (arg == "--known" && i + 1 < argc) {
+      knownShare = std::atof(argv[++i]);
+    } else if (arg == "--udp" && i + 1 < argc) {
+      udpShare = std::atof(argv[++i]);
+    } else if (arg == "--concurrency" && i + 1 < argc) {
+      concurrency = std::max(1, std::atoi(argv[++i]));
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--host IP] [--http-port N] [--udp-port N] [--path PATH]"
+                   " [--panels N] [--window S] [--known P] [--udp P]"
+                   " [--concurrency N]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  Target t;
+  t.http = {};
+  t.http.sin_family = AF_INET;
+  t.http.sin_port = htons(httpPort);
+  if (inet_pton(AF_INET, host.c_str(), &t.http.sin_addr) != 1) {
+    std::cerr << "Error: --host wants an IPv4 address" << std::endl;
+    return 1;
+  }
+  t.udp = t.http;
+  t.udp.sin_port = htons(udpPort);
+  t.host = httpPort == 80 ? host : host + ":" + std::to_string(httpPort);
+
+  json before;
+  if (!readStats(t.http, before) || before["artifacts"].empty() ||
+      !before["artifacts"][0].contains("etag")) {
+    std::cerr << "Error: no payload at " << host << ":" << httpPort
+              << " (is lan_gateway running and fetched?)" << std::endl;
+    return 1;
+  }
+  const json &payload = before["artifacts"][0];
+  if (path.empty()) {
+    path = payload["path"];
+  }
+  t.path = path;
+  t.etag = payload["etag"];
+  t.version = std::strtoul(payload["version"].get<std::string>().c_str(),
+                           nullptr, 16);
+
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<> uniform(0, 1);
+  std::vector<Panel> all(panels);
+  for (Panel &p : all) {
+    p.startS = uniform(rng) * window;
+    bool udp = uniform(rng) < udpShare;
+    bool known = uniform(rng) < knownShare;
+    p.kind = (Kind)((udp ? UDP_NEW : HTTP_NEW) + known);
+  }
+  std::sort(all.begin(), all.end(),
+            [](const Panel &a, const Panel &b) { return a.startS < b.startS; });
+
+  std::printf("%d panels over %.0f s, %d at once, against %s:%d\n", panels,
+              window, concurrency, host.c_str(), httpPort);
+  std::fflush(stdout);
+  auto start = std::chrono::steady_clock::now();
+  std::atomic<int> next{0};
+  auto worker = [&]() {
+    int i;
+    while ((i = next++) < panels) {
+      Panel &p = all[i];
+      std::this_thread::sleep_until(
+          start + std::chrono::duration<double>(p.startS));
+      auto begin = std::chrono::steady_clock::now();
+      bool known = p.kind == HTTP_KNOWN || p.kind == UDP_KNOWN;
+      p.error = p.kind <= HTTP_KNOWN ? runHttp(t, known) : runUdp(t, known, i);
+      p.ms = std::chrono::duration<double, std::milli>(
+                 std::chrono::steady_clock::now() - begin)
+                 .count();
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < concurrency; i++) {
+    threads.emplace_back(worker);
+  }
+  for (std::thread &th : threads) {
+    th.join();
+  }
+  double elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  int failures = 0;
+  std::printf("%-10s %6s %6s %9s %9s %9s\n", "kind", "panels", "failed",
+              "p50_ms", "p99_ms", "max_ms");
+  for (int k = 0; k < KINDS; k++) {
+    std::vector<double> ms;
+    int failed = 0;
+    for (const Panel &p : all) {
+      if (p.kind != k) {
+        continue;
+      }
+      if (!p.error.empty()) {
+        if (failed++ == 0) {
+          std::printf("  %s: %s\n", KIND_NAMES[k], p.error.c_str());
+        }
+        continue;
+      }
+      ms.push_back(p.ms);
+    }
+    failures += failed;
+    std::sort(ms.begin(), ms.end());
+    auto at = [&](double q) {
+      return ms.empty() ? 0.0 : ms[std::min(ms.size() - 1, (size_t)(q * ms.size()))];
+    };
+    std::printf("%-10s %6zu %6d %9.3f %9.3f %9.3f\n", KIND_NAMES[k],
+                ms.size() + failed, failed, at(0.5), at(0.99),
+                ms.empty() ? 0.0 : ms.back());
+  }
+
+  json after;
+  if (readStats(t.http, after)) {
+    std::printf("upstream requests during the run: %d (%.1f s)\n",
+                after["upstream"]["requests"].get<int>() -
+                    before["upstream"]["requests"].get<int>(),
+                elapsed);
+  }
+  std::printf("failures=%d\n", failures);
+  return failures ? 1 : 0;
+}
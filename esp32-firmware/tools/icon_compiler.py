@@ -0,0 +1,311 @@
+"""
+Compiles the SVG icon sources in icons/ to the vector bytecode drawn by
+src/vector_icon.cpp.
+
+Each icons/<name>.svg becomes ICON_<NAME> in src/icon_data.h and one
+program in src/icon_data.cpp. The sources use a small SVG subset on a
+viewBox of -64 -64 128 128 (icon units, origin at the center):
+
+    <circle>     fill: disc; stroke: ring centered on r
+    <line>       stroke: capsule (round caps) stroke-width wide
+    <polyline>   stroke: one capsule per segment
+    <polygon>    fill: even-odd polygon of up to 16 points; stroke: capsules
+    <rect>       fill: rectangle (a polygon once rotated)
+    <g>          fill, stroke, stroke-width, opacity and transform inherit
+
+Colors are the panel inks (black, white, green, blue, red, yellow,
+orange) or grey, which is black dithered. Any opacity below 1 dithers the
+ink in a checkerboard. transform takes translate, rotate and scale.
+Coordinates are rounded to whole icon units and must fit a signed byte.
+
+Run as a PlatformIO pre-build script (extra_scripts in platformio.ini),
+it rewrites the generated files when a source changed. By hand:
+
+Usage:
+    python tools/icon_compiler.py [--check] [--report] [--sizes 128,48]
+"""
+
+import argparse
+import math
+import re
+import sys
+import xml.etree.ElementTree as ET
+from pathlib import Path
+from typing import Dict, List, Tuple
+
+# As in src/vector_icon.h
+OP_END, OP_CIRCLE, OP_RING, OP_CAPSULE, OP_POLYGON, OP_RECT = range(6)
+PAINT_DITHER = 0x08
+MAX_POLYGON_POINTS = 16
+VIEW_BOX = (-64.0, -64.0, 128.0, 128.0)
+
+# As in src/framebuffer.h
+INKS = {'black': 0, 'white': 1, 'green': 2, 'blue': 3, 'red': 4,
+        'yellow': 5, 'orange': 6}
+
+Matrix = Tuple[float, float, float, float, float, float]  # a b c d e f
+IDENTITY: Matrix = (1, 0, 0, 1, 0, 0)
+
+
+class IconError(Exception):
+    pass
+
+
+def multiply(m: Matrix, n: Matrix) -> Matrix:
+    a, b, c, d, e, f = m
+    a2, b2, c2, d2, e2, f2 = n
+    return (a * a2 + c * b2, b * a2 + d * b2,
+            a * c2 + c * d2, b * c2 + d * d2,
+            a * e2 + c * f2 + e, b * e2 + d * f2 + f)
+
+
+def parse_transform(text: str) -> Matrix:
+    m = IDENTITY
+    for name, args in re.findall(r'(\w+)\s*\(([^)]*)\)', text or ''):
+        v = [float(x) for x in re.split(r'[\s,]+', args.strip()) if x]
+        if name == 'translate':
+            t = (1, 0, 0, 1, v[0], v[1] if len(v) > 1 else 0)
+        elif name == 'scale':
+            t = (v[0], 0, 0, v[1] if len(v) > 1 else v[0], 0, 0)
+        elif name == 'rotate':
+            r = math.radians(v[0])
+            t = (math.cos(r), math.sin(r), -math.sin(r), math.cos(r), 0, 0)
+            if len(v) == 3:
+                t = multiply(multiply((1, 0, 0, 1, v[1], v[2]), t),
+                             (1, 0, 0, 1, -v[1], -v[2]))
+        else:
+            raise IconError(f'unsupported transform {name}()')
+        m = multiply(m, t)
+    return m
+
+
+def apply(m: Matrix, x: float, y: float) -> Tuple[float, float]:
+    a, b, c, d, e, f = m
+    return a * x + c * y + e, b * x + d * y + f
+
+
+def scale_of(m: Matrix) -> float:
+    a, b, c, d, _, _ = m
+    if abs(math.hypot(a, b) - math.hypot(c, d)) > 1e-6:
+        raise IconError('non-uniform scale')
+    return math.hypot(a, b)
+
+
+def coord(v: float) -> int:
+    n = round(v)
+    if not -128 <= n <= 127:
+        raise IconError(f'coordinate {v:g} outside -128..127')
+    return n & 0xFF
+
+
+def length(v: float) -> int:
+    n = round(v)
+    if not 0 <= n <= 255:
+        raise IconError(f'length {v:g} outside 0..255')
+    return n
+
+
+def paint(color: str, opacity: float) -> int:
+    color = color.strip().lower()
+    dither = opacity < 1
+    if color in ('grey', 'gray'):
+        color, dither = 'black', True
+    if color not in INKS:
+        raise IconError(f'unknown color {color!r}')
+    return INKS[color] | (PAINT_DITHER if dither else 0)
+
+
+def points(text: str) -> List[Tuple[float, float]]:
+    v = [float(x) for x in re.split(r'[\s,]+', text.strip()) if x]
+    return list(zip(v[0::2], v[1::2]))
+
+
+def compile_element(el: ET.Element, style: Dict[str, str], m: Matrix,
+                    code: List[int]) -> int:
+    """Appends the element's shapes to code; returns how many."""
+    tag = el.tag.split('}')[-1]
+    style = dict(style)
+    for key in ('fill', 'stroke', 'stroke-width', 'opacity', 'fill-opacity',
+                'stroke-opacity'):
+        if key in el.attrib:
+            style[key] = el.attrib[key]
+    m = multiply(m, parse_transform(el.get('transform', '')))
+    opacity = float(style.get('opacity', 1))
+    fill = style.get('fill', 'black')
+    stroke = style.get('stroke', 'none')
+    fill_paint = None if fill == 'none' else paint(
+        fill, opacity * float(style.get('fill-opacity', 1)))
+    stroke_paint = None if stroke == 'none' else paint(
+        stroke, opacity * float(style.get('stroke-opacity', 1)))
+    width = float(style.get('stroke-width', 1))
+
+    def attr(name: str) -> float:
+        return float(el.get(name, 0))
+
+    def capsules(pts: List[Tuple[float, float]]) -> int:
+        w = length(width * scale_of(m))
+        for (x0, y0), (x1, y1) in zip(pts, pts[1:]):
+            (x0, y0), (x1, y1) = apply(m, x0, y0), apply(m, x1, y1)
+            code.extend([OP_CAPSULE << 4 | stroke_paint, coord(x0),
+                         coord(y0), coord(x1), coord(y1), w])
+        return len(pts) - 1
+
+    def polygon(pts: List[Tuple[float, float]]) -> int:
+        if not 3 <= len(pts) <= MAX_POLYGON_POINTS:
+            raise IconError(f'polygon with {len(pts)} points')
+        code.extend([OP_POLYGON << 4 | fill_paint, len(pts)])
+        for x, y in pts:
+            x, y = apply(m, x, y)
+            code.extend([coord(x), coord(y)])
+        return 1
+
+    shapes = 0
+    if tag in ('svg', 'g'):
+        for child in el:
+            shapes += compile_element(child, style, m, code)
+    elif tag == 'circle':
+        cx, cy = apply(m, attr('cx'), attr('cy'))
+        r = attr('r') * scale_of(m)
+        if fill_paint is not None:
+            code.extend([OP_CIRCLE << 4 | fill_paint, coord(cx), coord(cy),
+                         length(r)])
+            shapes += 1
+        if stroke_paint is not None:
+            w = width * scale_of(m)
+            code.extend([OP_RING << 4 | stroke_paint, coord(cx), coord(cy),
+                         length(r + w / 2), length(w)])
+            shapes += 1
+    elif tag == 'line':
+        if stroke_paint is not None:
+            shapes += capsules([(attr('x1'), attr('y1')),
+                                (attr('x2'), attr('y2'))])
+    elif tag in ('polyline', 'polygon'):
+        pts = points(el.get('points', ''))
+        if tag == 'polygon' and fill_paint is not None:
+            shapes += polygon(pts)
+        if stroke_paint is not None:
+            shapes += capsules(pts + pts[:1] if tag == 'polygon' else pts)
+    elif tag == 'rect':
+        if stroke_paint is not None:
+            raise IconError('stroked rect')
+        x, y, w, h = attr('x'), attr('y'), attr('width'), attr('height')
+        if fill_paint is None:
+            pass
+        elif m[1] == 0 and m[2] == 0:
+            (x0, y0), (x1, y1) = apply(m, x, y), apply(m, x + w, y + h)
+            code.extend([OP_RECT << 4 | fill_paint, coord(min(x0, x1)),
+                         coord(min(y0, y1)), length(abs(x1 - x0)),
+                         length(abs(y1 - y0))])
+            shapes += 1
+        else:
+            shapes += polygon([(x, y), (x + w, y), (x + w, y + h),
+                               (x, y + h)])
+    elif tag not in ('title', 'desc'):
+        raise IconError(f'unsupported element <{tag}>')
+    return shapes
+
+
+def compile_icon(path: Path) -> Tuple[List[int], int]:
+    root = ET.parse(path).getroot()
+    view_box = tuple(float(v) for v in root.get('viewBox', '').split())
+    if view_box != VIEW_BOX:
+        raise IconError('viewBox must be "-64 -64 128 128"')
+    code: List[int] = []
+    shapes = compile_element(root, {}, IDENTITY, code)
+    code.append(OP_END)
+    return code, shapes
+
+
+def generate(icon_dir: Path) -> Tuple[str, str, List[Tuple[str, int, int]]]:
+    sources = sorted(icon_dir.glob('*.svg'))
+    if not sources:
+        raise IconError(f'no icons in {icon_dir}')
+    banner = '// Generated by tools/icon_compiler.py from icons/*.svg; ' \
+             'do not edit.\n'
+    names = [s.stem.upper() for s in sources]
+    header = (banner + '\n#ifndef ICON_DATA_H\n#define ICON_DATA_H\n\n'
+              '#include <stdint.h>\n\nenum IconId : uint8_t {\n' +
+              ''.join(f'  ICON_{n},\n' for n in names) +
+              '  ICON_COUNT,\n};\n\n'
+              '// Bytecode for drawVectorIcon(), indexed by IconId\n'
+              'extern const uint8_t *const ICON_PROGRAMS[ICON_COUNT];\n\n'
+              '#endif\n')
+    body = banner + '\n#include "icon_data.h"\n'
+    stats = []
+    for source, name in zip(sources, names):
+        try:
+            code, shapes = compile_icon(source)
+        except (IconError, ET.ParseError, ValueError) as e:
+            raise IconError(f'{source.name}: {e}') from e
+        stats.append((source.name, shapes, len(code)))
+        rows = [code[i:i + 12] for i in range(0, len(code), 12)]
+        body += (f'\n// {source.name}: {shapes} shapes, {len(code)} bytes\n'
+                 f'static const uint8_t ICON_{name}_PROGRAM[] = {{\n' +
+                 ''.join('    ' + ', '.join(f'0x{b:02x}' for b in row) +
+                         ',\n' for row in rows) + '};\n')
+    body += ('\nconst uint8_t *const ICON_PROGRAMS[ICON_COUNT] = {\n' +
+             ''.join(f'    ICON_{n}_PROGRAM,\n' for n in names) + '};\n')
+    return header, body, stats
+
+
+def write_if_changed(path: Path, text: str) -> bool:
+    if path.exists() and path.read_text() == text:
+        return False
+    path.write_text(text)
+    return True
+
+
+def build(firmware_dir: Path) -> List[Tuple[str, int, int]]:
+    header, body, stats = generate(firmware_dir / 'icons')
+    for name, text in (('icon_data.h', header), ('icon_data.cpp', body)):
+        if write_if_changed(firmware_dir / 'src' / name, text):
+            print(f'icon_compiler: wrote src/{name}')
+    return stats
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Compile icons/*.svg to vector icon bytecode')
+    parser.add_argument('--check', action='store_true',
+                        help='fail if src/icon_data.* are out of date')
+    parser.add_argument('--report', action='store_true',
+                        help='bytecode size per icon against 4bpp sprites')
+    parser.add_argument('--sizes', default='128,48',
+                        help='sprite sizes for --report (pixels, square)')
+    args = parser.parse_args()
+    firmware_dir = Path(__file__).resolve().parents[1]
+
+    try:
+        if args.check:
+            header, body, stats = generate(firmware_dir / 'icons')
+            src = firmware_dir / 'src'
+            if ((src / 'icon_data.h').read_text() != header or
+                    (src / 'icon_data.cpp').read_text() != body):
+                sys.exit('src/icon_data.* are out of date; '
+                         'run tools/icon_compiler.py')
+        else:
+            stats = build(firmware_dir)
+    except IconError as e:
+        sys.exit(f'Error: {e}')
+
+    if args.report:
+        sizes = [int(s) for s in args.sizes.split(',')]
+        sprite = sum((s * s + 1) // 2 for s in sizes)
+        print(f"{'icon':<16} {'shapes':>6} {'bytes':>6} "
+              f"{'sprites':>8}  ({'+'.join(map(str, sizes))} px, 4bpp)")
+        for name, shapes, size in stats:
+            print(f'{name:<16} {shapes:>6} {size:>6} {sprite:>8}')
+        total = sum(size for _, _, size in stats)
+        print(f"{'total':<16} {sum(s for _, s, _ in stats):>6} {total:>6} "
+              f'{sprite * len(stats):>8}')
+
+
+if __name__ == '__main__':
+    main()
+else:
+    # PlatformIO pre-build script: regenerate before anything compiles
+    Import('env')  # noqa: F821
+    try:
+        build(Path(env['PROJECT_DIR']))  # noqa: F821
+    except IconError as e:
+        sys.exit(f'icon_compiler: {e}')
@@ -0,0 +1,147 @@
+"""
+IRAM budget report for the RENDER_HOT kernels.
+
+Reads a PlatformIO build's firmware.elf with the Xtensa toolchain's nm and
+readelf and prints how much of the instruction RAM the image uses, the
+budget from the linker map (iram0_0_seg), and where each render/decode
+kernel landed. With --compare, the same for a second build (usually the
+flash-only one) and the difference.
+
+Usage:
+    pio run -e bench -e bench_iram
+    python tools/iram_report.py [--env bench_iram] [--compare bench]
+"""
+
+import argparse
+import re
+import shutil
+import subprocess
+import sys
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+FIRMWARE_DIR = Path(__file__).resolve().parents[1]
+TOOLCHAIN = (Path.home() / '.platformio' / 'packages' /
+             'toolchain-xtensa-esp32s3' / 'bin')
+PREFIX = 'xtensa-esp32s3-elf-'
+
+# ESP32-S3 internal SRAM seen on the instruction bus
+IRAM_START = 0x40370000
+IRAM_END = 0x403E0000
+
+# Everything marked RENDER_HOT in src/
+HOT_KERNELS = [
+    'FrameBuffer::setPixel',
+    'FrameBuffer::fillSpan',
+    'FrameBuffer::fillSpanDithered',
+    'FrameBuffer::drawLine',
+    'FrameBuffer::hash',
+    'BitReader::unsignedBits',
+    'findGlyph',
+    'drawGlyph',
+    'rleDecode',
+    'Raster::spans',
+    'drawVectorIcon',
+]
+
+
+def tool(name: str) -> str:
+    path = TOOLCHAIN / (PREFIX + name)
+    if path.exists():
+        return str(path)
+    found = shutil.which(PREFIX + name)
+    if not found:
+        sys.exit(f"Error: {PREFIX}{name} not found (run `pio run` once)")
+    return found
+
+
+def iram_sections(elf: Path) -> Dict[str, int]:
+    """Sizes of the allocated sections inside the IRAM address range."""
+    out = subprocess.run([tool('readelf'), '-S', '-W', str(elf)],
+                         capture_output=True, text=True, check=True).stdout
+    sections = {}
+    for line in out.splitlines():
+        m = re.match(r'\s*\[\s*\d+\]\s+(\S+)\s+\S+\s+([0-9a-f]+)\s+'
+                     r'[0-9a-f]+\s+([0-9a-f]+)\s+\S+\s+(\S*A\S*)', line)
+        if not m:
+            continue
+        name, addr, size = m.group(1), int(m.group(2), 16), int(m.group(3), 16)
+        if IRAM_START <= addr < IRAM_END and size:
+            sections[name] = size
+    return sections
+
+
+def iram_budget(build: Path) -> Optional[int]:
+    """Length of iram0_0_seg from the linker map, if the build wrote one."""
+    map_file = build / 'firmware.map'
+    if not map_file.exists():
+        return None
+    for line in map_file.read_text(errors='replace').splitlines():
+        m = re.match(r'iram0_0_seg\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)', line)
+        if m:
+            return int(m.group(2), 16)
+    return None
+
+
+def kernels(elf: Path) -> List[Tuple[str, int, int]]:
+    """(name, address, size) of every symbol matching a hot kernel."""
+    out = subprocess.run([tool('nm'), '-C', '-S', '--defined-only', str(elf)],
+                         capture_output=True, text=True, check=True).stdout
+    found = []
+    for line in out.splitlines():
+        parts = line.split(maxsplit=3)
+        if len(parts) < 4 or parts[2].lower() != 't':
+            continue
+        name = parts[3]
+        base = name.split('(')[0]
+        if any(base == k or base.endswith('::' + k) for k in HOT_KERNELS):
+            found.append((name, int(parts[0], 16), int(parts[1], 16)))
+    return found
+
+
+def report(env: str) -> Optional[int]:
+    build = FIRMWARE_DIR / '.pio' / 'build' / env
+    elf = build / 'firmware.elf'
+    if not elf.exists():
+        print(f"{env}: no {elf.relative_to(FIRMWARE_DIR)}, run "
+              f"`pio run -e {env}`")
+        return None
+
+    sections = iram_sections(elf)
+    used = sum(sections.values())
+    budget = iram_budget(build)
+    print(f"== {env}")
+    for name, size in sorted(sections.items()):
+        print(f"  {name:<24} {size:>8} B")
+    if budget:
+        print(f"  IRAM used {used} of {budget} B ({100 * used / budget:.1f}%),"
+              f" {budget - used} B free")
+    else:
+        print(f"  IRAM used {used} B (no firmware.map, budget unknown)")
+
+    hot = 0
+    for name, addr, size in sorted(kernels(elf), key=lambda k: -k[2]):
+        in_iram = IRAM_START <= addr < IRAM_END
+        hot += size if in_iram else 0
+        print(f"  {'iram ' if in_iram else 'flash'} {size:>6} B  {name}")
+    print(f"  hot kernels in IRAM: {hot} B")
+    return used
+
+
+def main():
+    parser = argparse.ArgumentParser(description='IRAM budget report')
+    parser.add_argument('--env', default='bench_iram',
+                        help='PlatformIO env to report (default bench_iram)')
+    parser.add_argument('--compare', metavar='ENV',
+                        help='second env to report and diff against')
+    args = parser.parse_args()
+
+    used = report(args.env)
+    if args.compare:
+        other = report(args.compare)
+        if used is not None and other is not None:
+            print(f"IRAM delta {args.env} - {args.compare}: {used - other:+} B")
+
+
+if __name__ == '__main__':
+    main()
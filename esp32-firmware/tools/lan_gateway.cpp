@@ -0,0 +1,735 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <regex>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "json.hpp" // The nlohmann/json library
+#include "payload_model.h"
+#include "render_model.h"
+#include "udp_sync.h"
+#include "wake_trace.h"
+
+using json = nlohmann::json;
+
+/**
+ * @brief LAN gateway: one upstream fetch serves every panel at a site.
+ *
+ * Fetches the published artifacts (display_data.json by default) over
+ * HTTPS, validates them and keeps them in memory. Panels get them over
+ * plain HTTP at the same paths as on raw.githubusercontent.com (the query
+ * string is ignored), with an ETag and 304 for If-None-Match. Devices built
+ * with -DSYNC_SERVER get the first artifact's render model over UDP
+ * (src/udp_sync.h) instead. A download that fails validation is never
+ * served; the last good one stays.
+ *
+ * Upstream is checked with conditional requests: every --poll seconds from
+ * --delay seconds after the daily publish time (--publish, UTC, the
+ * aggregator's cron) until a new version arrives or --window minutes pass,
+ * and every --interval seconds otherwise. GET /_stats returns upstream and
+ * serving counters as JSON. Devices built with -DTELEMETRY_URL POST their
+ * telemetry line to /_telemetry; it is printed and, with --telemetry,
+ * appended to a JSON lines file.
+ *
+ * Usage: lan_gateway [--http-port N] [--udp-port N] [--publish HH:MM]
+ *                    [--delay S] [--window MIN] [--poll S] [--interval S]
+ *                    [--insecure] [--telemetry FILE] [url]...
+ */
+
+#define DEFAULT_URL                                                            \
+  "https://raw.githubusercontent.com/Amkobano/e-ink-display-module/main/"     \
+  "data-collection/output/display_data.json"
+#define UPSTREAM_TIMEOUT_S 15
+#define UPSTREAM_RETRY_S 5 // doubles up to --poll
+#define REQUEST_MAX 4096
+#define IDLE_CLOSE_S 5
+
+struct Url {
+  bool tls;
+  std::string host;
+  std::string port;
+  std::string path;
+};
+
+static bool parseUrl(const std::string &s, Url &url) {
+  std::smatch m;
+  static const std::regex re("(https?)://([^/:]+)(?::(\\d+))?(/.*)");
+  if (!std::regex_match(s, m, re)) {
+    return false;
+  }
+  url.tls = m[1] == "https";
+  url.host = m[2];
+  url.port = m[3].matched ? m[3].str() : (url.tls ? "443" : "80");
+  url.path = m[4];
+  return true;
+}
+
+// One artifact as served: immutable, replaced as a whole on a new version
+struct Entry {
+  std::string body;
+  std::string etag; // quoted FNV-1a of the body, as the aggregator's version
+  std::string ok;   // the whole 200 response
+  std::string notModified;
+  RenderModel model; // the payload's, for UDP
+  uint32_t version = 0;
+  time_t fetchedAt = 0;
+};
+
+struct Artifact {
+  Url url;
+  bool payload; // the first: checked as prayer times and served over UDP
+  std::string upstreamEtag;
+  std::shared_ptr<const Entry> entry;
+};
+
+struct Stats {
+  std::atomic<uint32_t> upstreamRequests{0};
+  std::atomic<uint32_t> upstreamChanges{0};
+  std::atomic<uint32_t> upstreamErrors{0};
+  std::atomic<uint32_t> upstreamRejected{0};
+  std::atomic<uint32_t> http200{0};
+  std::atomic<uint32_t> http304{0};
+  std::atomic<uint32_t> httpOther{0};
+  std::atomic<uint32_t> udpRequests{0};
+  std::atomic<uint32_t> telemetry{0};
+};
+
+struct Schedule {
+  int publishMin = 23 * 60 + 47; // .github/workflows/update-data.yml
+  int delay = 60;
+  int window = 90 * 60;
+  int poll = 60;
+  int interval = 3600;
+};
+
+struct Gateway {
+  std::vector<Artifact> artifacts;
+  std::mutex lock; // guards the entries
+  Stats stats;
+  Schedule schedule;
+  SSL_CTX *ssl = nullptr;
+  std::string telemetryPath;
+};
+
+// ---------------------------------------------------------------- Upstream
+
+struct Response {
+  int status = 0;
+  std::string etag;
+  std::string body;
+  std::string error;
+};
+
+static int connectTcp(const Url &url, std::string &error) {
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *res;
+  int rc = getaddrinfo(url.host.c_str(), url.port.c_str(), &hints, &res);
+  if (rc != 0) {
+    error = std::string("dns: ") + gai_strerror(rc);
+    return -1;
+  }
+  int fd = -1;
+  for (addrinfo *ai = res; ai && fd < 0; ai = ai->ai_next) {
+    fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+    timeval tv = {UPSTREAM_TIMEOUT_S, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    if (connect(fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(res);
+  if (fd < 0) {
+    error = std::string("connect: ") + strerror(errno);
+  }
+  return fd;
+}
+
+static std::string headerValue(const std::string &head, const char *name) {
+  std::string lower = head;
+  std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+  std::string key = std::string("\r\n") + name + ":";
+  size_t at = lower.find(key);
+  if (at == std::string::npos) {
+    return "";
+  }
+  at += key.size();
+  size_t end = head.find("\r\n", at);
+  std::string value = head.substr(at, end - at);
+  value.erase(0, value.find_first_not_of(' '));
+  value.erase(value.find_last_not_of(' ') + 1);
+  return value;
+}
+
+// A GET, conditional on etag; HTTP/1.0 so the body is never chunked
+static void fetch(SSL_CTX *ctx, const Url &url, const std::string &etag,
+                  Response &r) {
+  int fd = connectTcp(url, r.error);
+  if (fd < 0) {
+    return;
+  }
+  SSL *ssl = nullptr;
+  if (url.tls) {
+    ssl = SSL_new(ctx);
+    SSL_set_fd(ssl, fd);
+    SSL_set_tlsext_host_name(ssl, url.host.c_str());
+    SSL_set1_host(ssl, url.host.c_str());
+    if (SSL_connect(ssl) != 1) {
+      char buf[160];
+      ERR_error_string_n(ERR_get_error(), buf, sizeof(buf));
+      r.error = std::string("tls: ") + buf;
+      SSL_free(ssl);
+      close(fd);
+      return;
+    }
+  }
+
+  // Past the CDN's cache, like the device's cache buster
+  std::string request = "GET " + url.path + "?t=" +
+                        std::to_string(time(nullptr)) + " HTTP/1.0\r\nHost: " +
+                        url.host + "\r\nUser-Agent: lan_gateway\r\n";
+  if (!etag.empty()) {
+    request += "If-None-Match: " + etag + "\r\n";
+  }
+  request += "\r\n";
+  bool sent = ssl ? SSL_write(ssl, request.data(), request.size()) > 0
+                  : send(fd, request.data(), request.size(), 0) > 0;
+
+  std::string raw;
+  char buf[4096];
+  int n;
+  while (sent && (n = ssl ? SSL_read(ssl, buf, sizeof(buf))
+                          : recv(fd, buf, sizeof(buf), 0)) > 0) {
+    raw.append(buf, n);
+  }
+  if (ssl) {
+    SSL_shutdown(ssl);
+    SSL_free(ssl);
+  }
+  close(fd);
+
+  size_t split = raw.find("\r\n\r\n");
+  if (!sent || split == std::string::npos ||
+      sscanf(raw.c_str(), "HTTP/%*s %d", &r.status) != 1) {
+    r.error = "no response";
+    r.status = 0;
+    return;
+  }
+  std::string head = raw.substr(0, split + 2);
+  r.etag = headerValue(head, "etag");
+  r.body = raw.substr(split + 4);
+  std::string length = headerValue(head, "content-length");
+  if (r.status == 200 && !length.empty() &&
+      r.body.size() != std::strtoul(length.c_str(), nullptr, 10)) {
+    r.error = "truncated: " + std::to_string(r.body.size()) + " of " + length +
+              " bytes";
+    r.status = 0;
+  }
+}
+
+// Empty if the artifact may be served; the payload gets the aggregator's
+// validate_prayer_times() checks, so a failed run never reaches the panels
+static std::string validate(const std::string &body, bool payload,
+                            RenderModel &model) {
+  json doc = json::parse(body, nullptr, false);
+  if (doc.is_discarded()) {
+    return "not JSON";
+  }
+  if (!payload) {
+    return "";
+  }
+  if (!doc.is_object() || !doc.contains("prayer_times") ||
+      !doc["prayer_times"].is_object()) {
+    return "no prayer_times";
+  }
+  const char *names[] = {"fajr", "shuruq", "dhuhr", "asr", "maghrib", "isha"};
+  int last = -1;
+  for (const char *name : names) {
+    json value = doc["prayer_times"].value(name, json());
+    int h, m;
+    char extra;
+    if (!value.is_string() ||
+        sscanf(value.get<std::string>().c_str(), "%2d:%2d%c", &h, &m,
+               &extra) != 2 ||
+        h > 23 || m > 59) {
+      return std::string("bad ") + name;
+    }
+    if (h * 60 + m <= last) {
+      return "times not in order";
+    }
+    last = h * 60 + m;
+  }
+  model = modelFromPayload(doc);
+  model.highlight = -1; // the device sets it from its clock
+  return "";
+}
+
+static std::shared_ptr<const Entry> makeEntry(const std::string &body,
+                                              const RenderModel &model) {
+  auto e = std::make_shared<Entry>();
+  e->body = body;
+  char etag[16];
+  snprintf(etag, sizeof(etag), "\"%08x\"",
+           traceHash(body.data(), body.size()));
+  e->etag = etag;
+  std::string common = "ETag: " + e->etag +
+                       "\r\nCache-Control: no-cache\r\nConnection: close\r\n";
+  e->ok = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+          "Content-Length: " +
+          std::to_string(body.size()) + "\r\n" + common + "\r\n" + body;
+  e->notModified = "HTTP/1.1 304 Not Modified\r\n" + common + "\r\n";
+  e->model = model;
+  e->version = traceHash(&e->model, sizeof(e->model));
+  e->fetchedAt = time(nullptr);
+  return e;
+}
+
+// Checks every artifact once; true if any changed, false in ok on errors
+static bool checkUpstream(Gateway &g, bool &ok) {
+  bool changed = false;
+  ok = true;
+  for (Artifact &a : g.artifacts) {
+    Response r;
+    fetch(g.ssl, a.url, a.entry ? a.upstreamEtag : "", r);
+    g.stats.upstreamRequests++;
+    if (r.status == 304) {
+      continue;
+    }
+    if (r.status != 200) {
+      g.stats.upstreamErrors++;
+      ok = false;
+      std::printf("upstream %s: %s\n", a.url.path.c_str(),
+                  r.error.empty() ? ("HTTP " + std::to_string(r.status)).c_str()
+                                  : r.error.c_str());
+      continue;
+    }
+    RenderModel model;
+    memset(&model, 0, sizeof(model));
+    std::string invalid = validate(r.body, a.payload, model);
+    if (!invalid.empty()) {
+      g.stats.upstreamRejected++;
+      ok = false;
+      std::printf("upstream %s: rejected (%s), keeping the last version\n",
+                  a.url.path.c_str(), invalid.c_str());
+      continue;
+    }
+    a.upstreamEtag = r.etag;
+    auto entry = makeEntry(r.body, model);
+    if (a.entry && a.entry->etag == entry->etag) {
+      continue;
+    }
+    {
+      std::lock_guard<std::mutex> guard(g.lock);
+      a.entry = entry;
+    }
+    g.stats.upstreamChanges++;
+    changed = true;
+    std::printf("upstream %s: etag=%s version=%08x (%zu bytes)\n",
+                a.url.path.c_str(), entry->etag.c_str(), entry->version,
+                entry->body.size());
+  }
+  std::fflush(stdout);
+  return changed;
+}
+
+// When to check next. Polls after each publish until it brings a new
+// version (windowDone) or the window closes, then waits for the next one
+static time_t nextCheck(const Schedule &s, time_t now, time_t windowDone) {
+  time_t publish = now - now % 86400 + s.publishMin * 60;
+  if (publish > now) {
+    publish -= 86400;
+  }
+  if (windowDone != publish && now < publish + s.window) {
+    return std::max(now + s.poll, publish + s.delay);
+  }
+  return std::min(now + s.interval, publish + 86400 + s.delay);
+}
+
+static void upstreamLoop(Gateway &g) {
+  time_t windowDone = 0;
+  int retry = UPSTREAM_RETRY_S;
+  bool first = true;
+  while (true) {
+    time_t now = time(nullptr);
+    bool ok;
+    bool changed = checkUpstream(g, ok);
+    time_t publish = now - now % 86400 + g.schedule.publishMin * 60;
+    publish -= publish > now ? 86400 : 0;
+    // The version the gateway starts with is not the publish it waits for
+    if (changed && !first && now < publish + g.schedule.window) {
+      windowDone = publish;
+    }
+    first = false;
+    time_t next = nextCheck(g.schedule, now, windowDone);
+    if (ok) {
+      retry = UPSTREAM_RETRY_S;
+    } else {
+      next = std::min<time_t>(next, now + retry);
+      retry = std::min(retry * 2, g.schedule.poll);
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(
+        std::max<time_t>(next - time(nullptr), 1)));
+  }
+}
+
+// ------------------------------------------------------------------ Serving
+
+struct Conn {
+  char peer[INET_ADDRSTRLEN];
+  std::string in;
+  std::shared_ptr<const Entry> entry; // keeps out alive
+  std::string own;                    // out when not an entry's response
+  const std::string *out = nullptr;
+  size_t sent = 0;
+  time_t lastActive;
+};
+
+static std::string statsJson(Gateway &g) {
+  const Stats &s = g.stats;
+  json doc = {
+      {"upstream",
+       {{"requests", s.upstreamRequests.load()},
+        {"changes", s.upstreamChanges.load()},
+        {"errors", s.upstreamErrors.load()},
+        {"rejected", s.upstreamRejected.load()}}},
+      {"served",
+       {{"http_200", s.http200.load()},
+        {"http_304", s.http304.load()},
+        {"http_other", s.httpOther.load()},
+        {"udp", s.udpRequests.load()},
+        {"telemetry", s.telemetry.load()}}},
+      {"artifacts", json::array()},
+  };
+  std::lock_guard<std::mutex> guard(g.lock);
+  for (const Artifact &a : g.artifacts) {
+    json item = {{"path", a.url.path}};
+    if (a.entry) {
+      char version[9];
+      snprintf(version, sizeof(version), "%08x", a.entry->version);
+      item["etag"] = a.entry->etag;
+      item["bytes"] = a.entry->body.size();
+      item["fetched_at"] = a.entry->fetchedAt;
+      if (a.payload) {
+        item["version"] = version;
+      }
+    }
+    doc["artifacts"].push_back(item);
+  }
+  return doc.dump();
+}
+
+static std::string simpleResponse(const char *status, const std::string &body,
+                                  const char *type = "text/plain") {
+  return std::string("HTTP/1.1 ") + status + "\r\nContent-Type: " + type +
+         "\r\nContent-Length: " + std::to_string(body.size()) +
+         "\r\nConnection: close\r\n\r\n" + body;
+}
+
+// Bytes still to come after the head: its Content-Length, if any
+static size_t bodyLength(const std::string &in) {
+  return std::strtoul(headerValue(in, "content-length").c_str(), nullptr, 10);
+}
+
+static void recordTelemetry(Gateway &g, const Conn &c,
+                            const std::string &body) {
+  json line = {{"at", time(nullptr)},
+               {"from", c.peer},
+               {"telemetry", json::parse(body, nullptr, false)}};
+  if (line["telemetry"].is_discarded()) {
+    line["telemetry"] = body;
+  }
+  std::printf("telemetry %s %s\n", c.peer, body.c_str());
+  std::fflush(stdout);
+  if (!g.telemetryPath.empty()) {
+    std::ofstream(g.telemetryPath, std::ios::app) << line.dump() << "\n";
+  }
+  g.stats.telemetry++;
+}
+
+// Picks the response for a complete request
+static void respond(Gateway &g, Conn &c) {
+  char method[8], target[1024];
+  if (sscanf(c.in.c_str(), "%7s %1023s", method, target) != 2) {
+    c.own = simpleResponse("400 Bad Request", "");
+  } else if (strcmp(method, "POST") == 0 &&
+             strncmp(target, "/_telemetry", 11) == 0) {
+    recordTelemetry(g, c, c.in.substr(c.in.find("\r\n\r\n") + 4));
+    c.own = "HTTP/1.1 204 No Content\r\nConnection: close\r\n\r\n";
+    c.out = &c.own;
+    return;
+  } else if (strcmp(method, "GET") != 0) {
+    c.own = simpleResponse("405 Method Not Allowed", "");
+  } else {
+    std::string path = target;
+    path = path.substr(0, path.find('?'));
+    if (path == "/_stats") {
+      c.own = simpleResponse("200 OK", statsJson(g), "application/json");
+      c.out = &c.own;
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> guard(g.lock);
+      for (const Artifact &a : g.artifacts) {
+        if (a.url.path == path) {
+          c.entry = a.entry;
+        }
+      }
+    }
+    if (c.entry) {
+      bool same = headerValue(c.in, "if-none-match") == c.entry->etag;
+      c.out = same ? &c.entry->notModified : &c.entry->ok;
+      (same ? g.stats.http304 : g.stats.http200)++;
+      return;
+    }
+    // Not published, or not fetched yet
+    c.own = simpleResponse("404 Not Found", "");
+  }
+  g.stats.httpOther++;
+  c.out = &c.own;
+}
+
+struct UdpSender {
+  int fd;
+  sockaddr_in to;
+};
+
+static void sendDatagram(void *ctx, const uint8_t *data, size_t len) {
+  UdpSender &s = *static_cast<UdpSender *>(ctx);
+  sendto(s.fd, data, len, 0, reinterpret_cast<sockaddr *>(&s.to),
+         sizeof(s.to));
+}
+
+static void serveUdp(Gateway &g, int fd) {
+  uint8_t buf[512];
+  UdpSender sender = {fd, {}};
+  while (true) {
+    socklen_t fromLen = sizeof(sender.to);
+    ssize_t n = recvfrom(fd, buf, sizeof(buf), MSG_DONTWAIT,
+                         reinterpret_cast<sockaddr *>(&sender.to), &fromLen);
+    if (n < 0) {
+      return;
+    }
+    SyncRequest request;
+    if (!syncParseRequest(buf, n, request)) {
+      continue;
+    }
+    std::shared_ptr<const Entry> entry;
+    {
+      std::lock_guard<std::mutex> guard(g.lock);
+      entry = g.artifacts[0].entry;
+    }
+    if (!entry) {
+      continue; // the device retries, then falls back
+    }
+    g.stats.udpRequests++;
+    syncServe(request, reinterpret_cast<const uint8_t *>(&entry->model),
+              sizeof(entry->model), entry->version, (uint32_t)time(nullptr),
+              sendDatagram, &sender);
+  }
+}
+
+static int listenSocket(int type, int port) {
+  int fd = socket(AF_INET, type | SOCK_NONBLOCK, 0);
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if (fd < 0 || bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) ||
+      (type == SOCK_STREAM && listen(fd, 1024))) {
+    std::perror("bind");
+    exit(1);
+  }
+  return fd;
+}
+
+// One thread: the responses are prebuilt, so each request is a lookup and
+// a send
+static void serve(Gateway &g, int httpPort, int udpPort) {
+  int tcp = listenSocket(SOCK_STREAM, httpPort);
+  int udp = listenSocket(SOCK_DGRAM, udpPort);
+  int ep = epoll_create1(0);
+  epoll_event ev = {};
+  ev.events = EPOLLIN;
+  ev.data.fd = tcp;
+  epoll_ctl(ep, EPOLL_CTL_ADD, tcp, &ev);
+  ev.data.fd = udp;
+  epoll_ctl(ep, EPOLL_CTL_ADD, udp, &ev);
+  std::printf("serving http/%d and udp/%d\n", httpPort, udpPort);
+  std::fflush(stdout);
+
+  std::map<int, Conn> conns;
+  auto drop = [&](int fd) {
+    close(fd); // also leaves the epoll set
+    conns.erase(fd);
+  };
+  time_t lastSweep = time(nullptr);
+  epoll_event events[256];
+  while (true) {
+    int n = epoll_wait(ep, events, 256, 1000);
+    time_t now = time(nullptr);
+    for (int i = 0; i < n; i++) {
+      int fd = events[i].data.fd;
+      if (fd == udp) {
+        serveUdp(g, udp);
+        continue;
+      }
+      if (fd == tcp) {
+        int c;
+        sockaddr_in peer;
+        socklen_t peerLen = sizeof(peer);
+        while ((c = accept4(tcp, reinterpret_cast<sockaddr *>(&peer),
+                            &peerLen, SOCK_NONBLOCK)) >= 0) {
+          conns[c].lastActive = now;
+          inet_ntop(AF_INET, &peer.sin_addr, conns[c].peer,
+                    sizeof(conns[c].peer));
+          peerLen = sizeof(peer);
+          ev.events = EPOLLIN;
+          ev.data.fd = c;
+          epoll_ctl(ep, EPOLL_CTL_ADD, c, &ev);
+        }
+        continue;
+      }
+      auto it = conns.find(fd);
+      if (it == conns.end()) {
+        continue; // closed earlier in this batch
+      }
+      Conn &c = it->second;
+      c.lastActive = now;
+      if (!c.out) {
+        char buf[2048];
+        ssize_t got = recv(fd, buf, sizeof(buf), 0);
+        if (got <= 0) {
+          if (got == 0 || errno != EAGAIN) {
+            drop(fd);
+          }
+          continue;
+        }
+        c.in.append(buf, got);
+        size_t head = c.in.find("\r\n\r\n");
+        if (c.in.size() > REQUEST_MAX) {
+          drop(fd);
+          continue;
+        }
+        if (head == std::string::npos ||
+            c.in.size() < head + 4 + bodyLength(c.in)) {
+          continue;
+        }
+        respond(g, c);
+      }
+      ssize_t put = send(fd, c.out->data() + c.sent, c.out->size() - c.sent,
+                         MSG_NOSIGNAL);
+      if (put < 0 && errno != EAGAIN) {
+        drop(fd);
+        continue;
+      }
+      c.sent += std::max<ssize_t>(put, 0);
+      if (c.sent == c.out->size()) {
+        drop(fd); // Connection: close, as the device reads to the end
+      } else {
+        ev.events = EPOLLOUT;
+        ev.data.fd = fd;
+        epoll_ctl(ep, EPOLL_CTL_MOD, fd, &ev);
+      }
+    }
+    if (now - lastSweep >= 1) {
+      lastSweep = now;
+      for (auto it = conns.begin(); it != conns.end();) {
+        int fd = it->first;
+        time_t last = it->second.lastActive;
+        ++it;
+        if (now - last > IDLE_CLOSE_S) {
+          drop(fd);
+        }
+      }
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  Gateway g;
+  int httpPort = 8080;
+  int udpPort = SYNC_PORT;
+  bool insecure = false;
+  std::vector<std::string> urls;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    int hh, mm;
+    if (arg == "--http-port" && i + 1 < argc) {
+      httpPort = std::atoi(argv[++i]);
+    } else if (arg == "--udp-port" && i + 1 < argc) {
+      udpPort = std::atoi(argv[++i]);
+    } else if (arg == "--publish" && i + 1 < argc &&
+               sscanf(argv[++i], "%d:%d", &hh, &mm) == 2) {
+      g.schedule.publishMin = hh * 60 + mm;
+    } else if (arg == "--delay" && i + 1 < argc) {
+      g.schedule.delay = std::atoi(argv[++i]);
+    } else if (arg == "--window" && i + 1 < argc) {
+      g.schedule.window = std::atoi(argv[++i]) * 60;
+    } else if (arg == "--poll" && i + 1 < argc) {
+      g.schedule.poll = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--interval" && i + 1 < argc) {
+      g.schedule.interval = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--insecure") {
+      insecure = true;
+    } else if (arg == "--telemetry" && i + 1 < argc) {
+      g.telemetryPath = argv[++i];
+    } else if (arg[0] == '-') {
+      std::cerr << "Usage: " << argv[0]
+                << " [--http-port N] [--udp-port N] [--publish HH:MM]"
+                   " [--delay S] [--window MIN] [--poll S] [--interval S]"
+                   " [--insecure] [--telemetry FILE] [url]..."
+                << std::endl;
+      return 1;
+    } else {
+      urls.push_back(arg);
+    }
+  }
+  if (urls.empty()) {
+    urls.push_back(DEFAULT_URL);
+  }
+  for (const std::string &u : urls) {
+    Artifact a;
+    if (!parseUrl(u, a.url)) {
+      std::cerr << "Error: not an http(s) URL: " << u << std::endl;
+      return 1;
+    }
+    a.payload = g.artifacts.empty();
+    g.artifacts.push_back(a);
+  }
+
+  g.ssl = SSL_CTX_new(TLS_client_method());
+  SSL_CTX_set_default_verify_paths(g.ssl);
+  // For tools/standin_server.py's self-signed certificate
+  SSL_CTX_set_verify(g.ssl, insecure ? SSL_VERIFY_NONE : SSL_VERIFY_PEER,
+                     nullptr);
+
+  std::thread upstream(upstreamLoop, std::ref(g));
+  serve(g, httpPort, udpPort);
+}
@@ -0,0 +1,231 @@
+"""
+Local stand-in for the LAN MQTT broker the display can fetch from.
+
+Speaks just enough MQTT 3.1.1 for the device and the aggregator: CONNECT,
+SUBSCRIBE (retained messages are delivered right after the SUBACK, as a
+real broker does), PUBLISH with QoS 0/1 and the retain flag, PINGREQ and
+DISCONNECT. Messages are only kept as retained messages; nothing is
+forwarded to live subscribers. Retained messages can be seeded from a
+payload file, compacted and versioned like the aggregator does, or
+published by the aggregator itself (MQTT_HOST=<this host>).
+
+Every connection is logged with the client id, the topics it subscribed
+to, bytes sent and how long it stayed connected, which is the part of the
+radio-on time the transport adds.
+
+Usage:
+    python mqtt_standin.py [--port 1883] [--payload display_data.json]
+                           [--topic eink/my-city] [--latency-ms N]
+                           [--log connections.jsonl]
+"""
+
+import argparse
+import json
+import socket
+import socketserver
+import sys
+import threading
+import time
+from pathlib import Path
+from typing import Any, Dict, Optional
+
+# As in data-collection/aggregator.py
+PAYLOAD_KEY_ORDER = ['location', 'prayer_times', 'weather']
+
+CONNECT, CONNACK, PUBLISH, PUBACK = 1, 2, 3, 4
+SUBSCRIBE, SUBACK, PINGREQ, PINGRESP, DISCONNECT = 8, 9, 12, 13, 14
+
+
+def compact_payload(data: Dict[str, Any]) -> bytes:
+    compact = {key: data[key] for key in PAYLOAD_KEY_ORDER if key in data}
+    return json.dumps(compact, separators=(',', ':'),
+                      ensure_ascii=False).encode('utf-8')
+
+
+def payload_version(payload: bytes) -> str:
+    h = 2166136261
+    for byte in payload:
+        h = ((h ^ byte) * 16777619) & 0xFFFFFFFF
+    return f'{h:08x}'
+
+
+def topic_matches(pattern: str, topic: str) -> bool:
+    """MQTT topic filter match with + and # wildcards."""
+    p, t = pattern.split('/'), topic.split('/')
+    for i, level in enumerate(p):
+        if level == '#':
+            return True
+        if i >= len(t) or (level != '+' and level != t[i]):
+            return False
+    return len(p) == len(t)
+
+
+def encode_length(n: int) -> bytes:
+    out = bytearray()
+    while True:
+        byte, n = n % 128, n // 128
+        out.append(byte | (0x80 if n else 0))
+        if not n:
+            return bytes(out)
+
+
+def packet(kind: int, flags: int, body: bytes) -> bytes:
+    return bytes([kind << 4 | flags]) + encode_length(len(body)) + body
+
+
+def utf8(s: str) -> bytes:
+    data = s.encode('utf-8')
+    return len(data).to_bytes(2, 'big') + data
+
+
+class Broker(socketserver.ThreadingTCPServer):
+    daemon_threads = True
+    allow_reuse_address = True
+
+    def __init__(self, address, latency_ms: int, log_path: Optional[Path]):
+        super().__init__(address, BrokerHandler)
+        self.latency_ms = latency_ms
+        self.log_path = log_path
+        self.retained: Dict[str, bytes] = {}
+        self.lock = threading.Lock()
+
+    def retain(self, topic: str, payload: bytes):
+        with self.lock:
+            if payload:
+                self.retained[topic] = payload
+            else:
+                self.retained.pop(topic, None)
+
+    def matching(self, pattern: str):
+        with self.lock:
+            return [(t, p) for t, p in sorted(self.retained.items())
+                    if topic_matches(pattern, t)]
+
+    def record(self, entry: Dict[str, Any]):
+        entry['time'] = round(time.time(), 3)
+        with self.lock:
+            if self.log_path:
+                with open(self.log_path, 'a') as f:
+                    f.write(json.dumps(entry) + '\n')
+        print(json.dumps(entry))
+
+
+class BrokerHandler(socketserver.BaseRequestHandler):
+    server: Broker
+
+    def read_exact(self, n: int) -> bytes:
+        data = b''
+        while len(data) < n:
+            chunk = self.request.recv(n - len(data))
+            if not chunk:
+                raise ConnectionError('closed')
+            data += chunk
+        return data
+
+    def read_packet(self):
+        first = self.read_exact(1)[0]
+        length, shift = 0, 0
+        while True:
+            byte = self.read_exact(1)[0]
+            length |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                break
+        return first >> 4, first & 0x0F, self.read_exact(length)
+
+    def send(self, data: bytes):
+        self.request.sendall(data)
+        self.sent += len(data)
+
+    def handle(self):
+        self.request.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.sent = 0
+        start = time.monotonic()
+        entry: Dict[str, Any] = {'client': self.client_address[0],
+                                 'subscribed': [], 'published': []}
+        try:
+            self.session(entry)
+            entry['end'] = 'disconnect'
+        except (ConnectionError, OSError, IndexError) as e:
+            entry['end'] = str(e) or type(e).__name__
+        entry['bytes_sent'] = self.sent
+        entry['ms'] = round((time.monotonic() - start) * 1000)
+        self.server.record(entry)
+
+    def session(self, entry: Dict[str, Any]):
+        while True:
+            kind, flags, body = self.read_packet()
+            if kind == CONNECT:
+                # Protocol name, level, flags, keep alive, then the client id
+                name_len = int.from_bytes(body[0:2], 'big')
+                pos = 2 + name_len + 4
+                id_len = int.from_bytes(body[pos:pos + 2], 'big')
+                entry['client_id'] = body[pos + 2:pos + 2 + id_len].decode()
+                if self.server.latency_ms:
+                    time.sleep(self.server.latency_ms / 1000)
+                self.send(packet(CONNACK, 0, b'\x00\x00'))
+            elif kind == SUBSCRIBE:
+                packet_id, pos = body[0:2], 2
+                filters = []
+                while pos < len(body):
+                    n = int.from_bytes(body[pos:pos + 2], 'big')
+                    filters.append(body[pos + 2:pos + 2 + n].decode())
+                    pos += 2 + n + 1  # requested QoS, always granted 0
+                self.send(packet(SUBACK, 0, packet_id + bytes(len(filters))))
+                for pattern in filters:
+                    entry['subscribed'].append(pattern)
+                    for topic, payload in self.server.matching(pattern):
+                        self.send(packet(PUBLISH, 0x01, utf8(topic) + payload))
+            elif kind == PUBLISH:
+                qos, retain = (flags >> 1) & 3, flags & 1
+                n = int.from_bytes(body[0:2], 'big')
+                topic = body[2:2 + n].decode()
+                pos = 2 + n
+                if qos:
+                    packet_id = body[pos:pos + 2]
+                    pos += 2
+                payload = body[pos:]
+                if retain:
+                    self.server.retain(topic, payload)
+                entry['published'].append({'topic': topic,
+                                           'bytes': len(payload)})
+                if qos == 1:
+                    self.send(packet(PUBACK, 0, packet_id))
+            elif kind == PINGREQ:
+                self.send(packet(PINGRESP, 0, b''))
+            elif kind == DISCONNECT:
+                return
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Retained-message MQTT broker stand-in')
+    parser.add_argument('--host', default='0.0.0.0')
+    parser.add_argument('--port', type=int, default=1883)
+    parser.add_argument('--payload', type=Path,
+                        help='seed <topic>/payload and <topic>/version from '
+                             'a display_data.json')
+    parser.add_argument('--topic', default='eink/my-city')
+    parser.add_argument('--latency-ms', type=int, default=0,
+                        help='delay before each CONNACK')
+    parser.add_argument('--log', type=Path,
+                        help='append connections as JSON lines')
+    args = parser.parse_args()
+
+    broker = Broker((args.host, args.port), args.latency_ms, args.log)
+    if args.payload:
+        payload = compact_payload(json.loads(args.payload.read_text()))
+        version = payload_version(payload)
+        broker.retain(f'{args.topic}/payload', payload)
+        broker.retain(f'{args.topic}/version', version.encode())
+        print(f"Retained {len(payload)} bytes on {args.topic} "
+              f"(version {version})", file=sys.stderr)
+    print(f"MQTT stand-in on {args.host}:{args.port}", file=sys.stderr)
+    try:
+        broker.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,49 @@
+/*
+ * display_data.json to RenderModel, shared by the host tools
+ */
+
+#ifndef PAYLOAD_MODEL_H
+#define PAYLOAD_MODEL_H
+
+#include <cstring>
+
+#include "json.hpp" // The nlohmann/json library
+#include "render_model.h"
+
+// Same mapping as fetchPrayerTimes() + buildRenderModel() on the device
+inline RenderModel modelFromPayload(const nlohmann::json &doc) {
+  using json = nlohmann::json;
+  RenderModel model;
+  memset(&model, 0, sizeof(model)); // padding too, models are hashed
+  modelSetString(model.location, sizeof(model.location),
+                 doc.value("location", "").c_str());
+  const char *names[] = {"fajr", "shuruq", "dhuhr", "asr", "maghrib", "isha"};
+  json times = doc.value("prayer_times", json::object());
+  for (int i = 0; i < 6; i++) {
+    modelSetString(model.prayers[i], sizeof(model.prayers[i]),
+                   times.value(names[i], "N/A").c_str());
+  }
+
+  modelSetString(model.condition, sizeof(model.condition), "N/A");
+  json weather = doc.value("weather", json::object());
+  json current = weather.value("current", json::object());
+  if (!current.empty()) {
+    model.temperature = current.value("temperature", 0);
+    modelSetString(model.condition, sizeof(model.condition),
+                   current.value("condition", "N/A").c_str());
+    modelSetString(model.icon, sizeof(model.icon),
+                   current.value("icon", "").c_str());
+  }
+  json days = weather.value("forecast", json::array());
+  for (size_t i = 0; i < 3 && i < days.size(); i++) {
+    ForecastModel &f = model.forecast[i];
+    modelSetString(f.date, sizeof(f.date), days[i].value("date", "").c_str());
+    f.high = days[i].value("high", 0);
+    f.low = days[i].value("low", 0);
+    modelSetString(f.condition, sizeof(f.condition),
+                   days[i].value("condition", "").c_str());
+  }
+  return model;
+}
+
+#endif
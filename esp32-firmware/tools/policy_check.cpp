@@ -0,0 +1,236 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "network_score.h"
+#include "refresh_policy.h"
+#include "schedule.h"
+
+/**
+ * @brief Checks the firmware's portable wake policies on fixed cases.
+ *
+ * Each case drives the code main.cpp uses through a scenario the device
+ * can't easily be put into on the bench, tracking the state the firmware
+ * keeps between wakes, and compares the outcome with what the policy
+ * promises. Prints one line per case and exits with 1 if any failed.
+ *
+ * - long_outage: three days without a good fetch, retried as
+ *   handleFetchFailure() does. The stored frame stays up through the
+ *   first FAILURES_BEFORE_ERROR failures; the error screen is then drawn
+ *   once, not again on every retry, and a good fetch clears it.
+ * - outage_without_frame: the same from a first boot, with no frame to
+ *   keep.
+ * - network_reorder: a provisioning image reorders the WiFi list and
+ *   drops and adds a network. Every SSID must keep its own stats, so the
+ *   best network is still tried first.
+ * - refresh_data_wake: the 00:10 data wake after a day with the same
+ *   prayer times. The forecast boxes move on a day and must refresh; a
+ *   one-degree temperature change alone must not.
+ * - refresh_revision: a payload revising the same days' forecast and the
+ *   temperature by a degree, pushed half an hour after the data wake. It
+ *   must wait for the next refresh.
+ *
+ * Usage: policy_check
+ */
+
+// Firmware defaults (main.cpp)
+#define FAILURES_BEFORE_ERROR 8
+#define REFRESH_ALWAYS (WIDGET_HEADER | WIDGET_PRAYERS | WIDGET_ICON)
+#define REFRESH_TEMPERATURE_BAND 2
+#define REFRESH_MAX_STALE_MIN 360
+
+static int failed = 0;
+
+static void check(const char *name, bool ok, const std::string &detail) {
+  std::printf("%-4s %-24s %s\n", ok ? "ok" : "FAIL", name, detail.c_str());
+  failed += !ok;
+}
+
+// What the firmware's RTC state and panel go through on failed fetches
+struct PanelState {
+  bool haveFrame = true; // a good fetch put a frame on the panel
+  bool errorShown = false;
+  uint8_t failures = 0;
+  int refreshes = 0;
+  int errorRefreshes = 0;
+  int keptFrame = 0;
+
+  void fetchFailed() {
+    failures = failures < 255 ? failures + 1 : 255;
+    bool frame = failures <= FAILURES_BEFORE_ERROR && haveFrame;
+    switch (failureAction(failures, frame, errorShown,
+                          FAILURES_BEFORE_ERROR)) {
+    case FAILURE_KEEP_FRAME:
+      keptFrame++;
+      break;
+    case FAILURE_SHOW_ERROR:
+      // displayError(): clears the stored frame, pushes the error screen
+      haveFrame = false;
+      errorShown = true;
+      refreshes++;
+      errorRefreshes++;
+      break;
+    case FAILURE_ERROR_SHOWN:
+      break;
+    }
+  }
+
+  void fetchSucceeded() {
+    // pushFrame() clears errorShown
+    failures = 0;
+    haveFrame = true;
+    errorShown = false;
+    refreshes++;
+  }
+};
+
+static void longOutage() {
+  PanelState panel;
+  long elapsed = 0;
+  int retries = 0;
+  uint32_t random = 12345;
+  while (elapsed < 3 * 86400L) {
+    panel.fetchFailed();
+    random = random * 1103515245u + 12345u;
+    elapsed += retryDelay(panel.failures, random >> 8);
+    retries++;
+  }
+  char detail[128];
+  snprintf(detail, sizeof(detail),
+           "%d failed fetches: kept frame %d, error refreshes %d", retries,
+           panel.keptFrame, panel.errorRefreshes);
+  check("long_outage", panel.keptFrame == FAILURES_BEFORE_ERROR &&
+                           panel.errorRefreshes == 1 && panel.refreshes == 1,
+        detail);
+
+  // Recovery, then a second outage shows the error screen again, once
+  panel.fetchSucceeded();
+  bool cleared = !panel.errorShown;
+  for (int i = 0; i < 40; i++) {
+    panel.fetchFailed();
+  }
+  snprintf(detail, sizeof(detail),
+           "error cleared by a good fetch: %s, second outage error "
+           "refreshes %d",
+           cleared ? "yes" : "no", panel.errorRefreshes - 1);
+  check("long_outage_recovery", cleared && panel.errorRefreshes == 2,
+        detail);
+}
+
+// First boot or a cleared frame: the error screen at once, still only once
+static void outageWithoutFrame() {
+  PanelState panel;
+  panel.haveFrame = false;
+  for (int i = 0; i < 48; i++) {
+    panel.fetchFailed();
+  }
+  char detail[96];
+  snprintf(detail, sizeof(detail), "48 failed fetches: error refreshes %d",
+           panel.errorRefreshes);
+  check("outage_without_frame",
+        panel.keptFrame == 0 && panel.errorRefreshes == 1, detail);
+}
+
+static void networkReorder() {
+  const char before[3][33] = {"Office", "Lobby", "Hotspot"};
+  const char after[3][33] = {"Hotspot", "Office", "Guest"};
+  NetworkStats stats[MAX_NETWORKS];
+  memset(stats, 0, sizeof(stats));
+  recordAssociation(stats[0], -50, 800);  // Office: strong
+  recordAssociation(stats[1], -85, 3000); // Lobby: weak, dropped
+  recordFailure(stats[2]);                // Hotspot: failing
+  NetworkStats office = stats[0];
+  NetworkStats hotspot = stats[2];
+
+  remapNetworkStats(stats, before, 3, after, 3);
+  NetworkEntry networks[3];
+  for (int i = 0; i < 3; i++) {
+    memset(&networks[i], 0, sizeof(networks[i]));
+    strcpy(networks[i].ssid, after[i]);
+    networks[i].stats = stats[i];
+  }
+  uint8_t order[MAX_NETWORKS];
+  rankNetworks(networks, 3, order);
+  NetworkStats none;
+  memset(&none, 0, sizeof(none));
+  bool moved = memcmp(&stats[0], &hotspot, sizeof(none)) == 0 &&
+               memcmp(&stats[1], &office, sizeof(none)) == 0 &&
+               memcmp(&stats[2], &none, sizeof(none)) == 0;
+  char detail[128];
+  snprintf(detail, sizeof(detail),
+           "stats follow their SSIDs: %s, tried first: %s, last: %s",
+           moved ? "yes" : "no", networks[order[0]].ssid,
+           networks[order[2]].ssid);
+  check("network_reorder",
+        moved && strcmp(networks[order[0]].ssid, "Office") == 0 &&
+            strcmp(networks[order[2]].ssid, "Hotspot") == 0,
+        detail);
+}
+
+// The model buildRenderModel() makes from a day's payload
+static RenderModel dayModel(int day, int16_t temperature) {
+  static const char *const prayers[6] = {"05:12", "06:41", "12:30",
+                                         "15:52", "18:19", "19:44"};
+  RenderModel model;
+  memset(&model, 0, sizeof(model));
+  modelSetString(model.location, sizeof(model.location), "My City");
+  for (int i = 0; i < 6; i++) {
+    modelSetString(model.prayers[i], sizeof(model.prayers[i]), prayers[i]);
+  }
+  model.highlight = 0;
+  model.temperature = temperature;
+  modelSetString(model.condition, sizeof(model.condition), "Clouds");
+  modelSetString(model.icon, sizeof(model.icon), "04n");
+  for (int i = 0; i < 3; i++) {
+    ForecastModel &f = model.forecast[i];
+    snprintf(f.date, sizeof(f.date), "2026-06-%02d", day + 1 + i);
+    f.high = 28 + i;
+    f.low = 17 + i;
+    modelSetString(f.condition, sizeof(f.condition), "Clouds");
+  }
+  return model;
+}
+
+static const RefreshPolicy refreshPolicy = {
+    REFRESH_ALWAYS, REFRESH_TEMPERATURE_BAND, REFRESH_MAX_STALE_MIN * 60L};
+
+static void refreshDataWake() {
+  // Around the solstice the times can stay put for a few days
+  RenderModel shown = dayModel(20, 21);
+  RenderModel next = dayModel(21, 22);
+  uint8_t significant = significantWidgets(refreshPolicy, shown, next);
+  RenderModel warmer = shown;
+  warmer.temperature++;
+  uint8_t temperatureOnly = significantWidgets(refreshPolicy, shown, warmer);
+  char detail[96];
+  snprintf(detail, sizeof(detail),
+           "changed %02x significant %02x, temperature only %02x",
+           changedWidgets(shown, next), significant, temperatureOnly);
+  uint8_t forecast = WIDGET_FORECAST_0 | WIDGET_FORECAST_1 | WIDGET_FORECAST_2;
+  check("refresh_data_wake", significant == forecast && temperatureOnly == 0,
+        detail);
+}
+
+static void refreshRevision() {
+  RenderModel shown = dayModel(21, 22); // drawn at the 00:10 data wake
+  RenderModel revised = shown;          // pushed at 00:40
+  revised.temperature--;
+  revised.forecast[1].high--;
+  modelSetString(revised.forecast[2].condition,
+                 sizeof(revised.forecast[2].condition), "Rain");
+  uint8_t significant = significantWidgets(refreshPolicy, shown, revised);
+  char detail[96];
+  snprintf(detail, sizeof(detail), "changed %02x significant %02x",
+           changedWidgets(shown, revised), significant);
+  check("refresh_revision", significant == 0, detail);
+}
+
+int main() {
+  longOutage();
+  outageWithoutFrame();
+  networkReorder();
+  refreshDataWake();
+  refreshRevision();
+  std::printf("failed=%d\n", failed);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,230 @@
+"""
+Flat profile and flame graph stacks from a WAKE_PROFILE serial log.
+
+Reads the "PROFILE" lines a -DWAKE_PROFILE build prints before sleeping
+(src/profiler.h), symbolizes every sampled address against the build's
+firmware.elf with the Xtensa toolchain's nm, and prints a flat profile:
+samples per function with the leaf (self) and anywhere on the stack
+(total), as a share of the busy samples. Samples can be limited to one
+wake phase or task. With --collapsed, also writes one line per distinct
+stack ("task;outer;...;inner count"), the input format of flamegraph.pl
+and speedscope. With --lines N, the N hottest leaf addresses are resolved
+to source lines with addr2line.
+
+Usage:
+    pio run -e profile -t upload
+    pio device monitor | tee wake.log
+    python tools/profile_report.py wake.log [--env profile]
+        [--elf PATH] [--phase NAME] [--task NAME] [--top N]
+        [--collapsed FILE] [--lines N]
+"""
+
+import argparse
+import bisect
+import shutil
+import subprocess
+import sys
+from collections import Counter
+from pathlib import Path
+from typing import Dict, List, NamedTuple, Optional, Tuple
+
+FIRMWARE_DIR = Path(__file__).resolve().parents[1]
+TOOLCHAIN = (Path.home() / '.platformio' / 'packages' /
+             'toolchain-xtensa-esp32s3' / 'bin')
+PREFIX = 'xtensa-esp32s3-elf-'
+
+
+class Sample(NamedTuple):
+    core: int
+    task: str
+    phase: str
+    stack: Tuple[int, ...]  # innermost first
+
+
+class Profile(NamedTuple):
+    hz: int
+    header: Dict[str, int]
+    samples: List[Sample]
+
+
+def tool(name: str) -> str:
+    path = TOOLCHAIN / (PREFIX + name)
+    if path.exists():
+        return str(path)
+    found = shutil.which(PREFIX + name)
+    if not found:
+        sys.exit(f"Error: {PREFIX}{name} not found (run `pio run` once)")
+    return found
+
+
+def read_profile(lines) -> Profile:
+    """The last dump in the log; earlier wakes' dumps are replaced."""
+    header: Dict[str, int] = {}
+    tasks: Dict[int, str] = {}
+    phases: Dict[int, str] = {}
+    raw: List[List[str]] = []
+    for line in lines:
+        start = line.find('PROFILE ')
+        if start < 0:
+            continue
+        fields = line[start:].split()
+        if len(fields) < 2:
+            continue
+        if '=' in fields[1]:
+            header = {k: int(v) for k, v in
+                      (f.split('=', 1) for f in fields[1:] if '=' in f)}
+            tasks, phases, raw = {}, {}, []
+        elif fields[1] == 'task' and len(fields) >= 3:
+            tasks[int(fields[2])] = ' '.join(fields[3:]) or '?'
+        elif fields[1] == 'phase' and len(fields) == 4:
+            phases[int(fields[2])] = fields[3]
+        elif fields[1] == 's' and len(fields) >= 6:
+            raw.append(fields[2:])
+    if not header:
+        sys.exit("Error: no PROFILE dump in the log (built with "
+                 "-DWAKE_PROFILE?)")
+    samples = []
+    for f in raw:
+        try:
+            core, task, phase = int(f[0]), int(f[1]), int(f[2])
+            stack = tuple(int(pc, 16) for pc in f[3:])
+        except ValueError:
+            continue  # a line mangled on the serial link
+        samples.append(Sample(core, tasks.get(task, f'task{task}'),
+                              phases.get(phase, f'phase{phase}'), stack))
+    return Profile(header.get('hz', 0), header, samples)
+
+
+class Symbols:
+    """Function symbols of the ELF, looked up by address."""
+
+    def __init__(self, elf: Path):
+        out = subprocess.run([tool('nm'), '-C', '-n', '-S', '--defined-only',
+                              str(elf)],
+                             capture_output=True, text=True, check=True).stdout
+        self.starts: List[int] = []
+        self.ends: List[int] = []
+        self.names: List[str] = []
+        for line in out.splitlines():
+            parts = line.split(None, 3)
+            if len(parts) != 4 or parts[2] not in 'tTwW':
+                continue
+            start, size = int(parts[0], 16), int(parts[1], 16)
+            if size == 0:
+                continue
+            self.starts.append(start)
+            self.ends.append(start + size)
+            self.names.append(parts[3])
+
+    def name(self, addr: int) -> str:
+        i = bisect.bisect_right(self.starts, addr) - 1
+        if i >= 0 and addr < self.ends[i]:
+            return self.names[i]
+        return f'0x{addr:08x}'
+
+
+def source_lines(elf: Path, addrs: List[int]) -> List[str]:
+    out = subprocess.run([tool('addr2line'), '-e', str(elf), '-f', '-C',
+                          '-s'] + [f'0x{a:x}' for a in addrs],
+                         capture_output=True, text=True, check=True).stdout
+    lines = out.splitlines()
+    return [f'{lines[2 * i + 1]} ({lines[2 * i]})'
+            for i in range(len(addrs))]
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.split('\n\n')[0])
+    parser.add_argument('log', nargs='?', help='serial log (default stdin)')
+    parser.add_argument('--env', default='profile',
+                        help='PlatformIO environment the log came from')
+    parser.add_argument('--elf', type=Path, help='firmware ELF to use '
+                        'instead of the environment\'s build')
+    parser.add_argument('--phase', help='only samples from this wake phase')
+    parser.add_argument('--task', help='only samples from this task')
+    parser.add_argument('--top', type=int, default=30,
+                        help='functions in the flat profile')
+    parser.add_argument('--collapsed', type=Path,
+                        help='write collapsed stacks for flame graphs here')
+    parser.add_argument('--lines', type=int, default=0,
+                        help='also show the N hottest leaf source lines')
+    args = parser.parse_args()
+
+    elf = args.elf or (FIRMWARE_DIR / '.pio' / 'build' / args.env /
+                       'firmware.elf')
+    if not elf.exists():
+        sys.exit(f"Error: {elf} not found (build the same firmware first)")
+    if args.log:
+        with open(args.log, errors='replace') as f:
+            profile = read_profile(f)
+    else:
+        profile = read_profile(sys.stdin)
+
+    samples = [s for s in profile.samples
+               if (not args.phase or s.phase == args.phase) and
+               (not args.task or s.task == args.task)]
+    h = profile.header
+    idle = sum(v for k, v in h.items() if k.startswith('idle'))
+    print(f"{len(profile.samples)} busy samples at {profile.hz} Hz per core, "
+          f"{idle} idle, {h.get('dropped', 0)} dropped"
+          + (f", {len(samples)} selected" if len(samples) !=
+             len(profile.samples) else ''))
+    if h.get('isr'):
+        # Cycles are the same work at any clock; 80 MHz is the worst case
+        busy = h['isr'] * h.get('isr_cycles', 0) / 80e6
+        wall = h.get('wall_ms', 0) / 1000 * len([k for k in h
+                                                 if k.startswith('idle')])
+        print(f"  sampler: {h.get('isr_cycles', 0)} cycles per interrupt, "
+              f"{h.get('isr_max_cycles', 0)} worst"
+              + (f", {100 * busy / wall:.2f}% of the cores at 80 MHz"
+                 if wall else ''))
+    if h.get('dropped'):
+        print("  the buffer filled up: raise PROFILE_SAMPLES or lower "
+              "PROFILE_HZ to cover the whole wake")
+    if not samples:
+        return 1
+
+    symbols = Symbols(elf)
+    self_counts: Counter = Counter()
+    total_counts: Counter = Counter()
+    stacks: Counter = Counter()
+    leaves: Counter = Counter()
+    for s in samples:
+        names = [symbols.name(pc) for pc in s.stack]
+        self_counts[names[0]] += 1
+        for name in set(names):
+            total_counts[name] += 1
+        leaves[s.stack[0]] += 1
+        stacks[';'.join([s.task] + names[::-1])] += 1
+
+    n = len(samples)
+    ms = 1000.0 / profile.hz if profile.hz else 0
+    print(f"\n{'self':>6} {'self%':>6} {'total%':>6} {'~ms':>7}  function")
+    for name, count in self_counts.most_common(args.top):
+        print(f"{count:6d} {100.0 * count / n:6.1f} "
+              f"{100.0 * total_counts[name] / n:6.1f} {count * ms:7.0f}  "
+              f"{name}")
+
+    by_task = Counter(s.task for s in samples)
+    by_phase = Counter(s.phase for s in samples)
+    print('\nby task:  ' + ', '.join(f'{t} {100.0 * c / n:.0f}%'
+                                     for t, c in by_task.most_common()))
+    print('by phase: ' + ', '.join(f'{p} {100.0 * c / n:.0f}%'
+                                   for p, c in by_phase.most_common()))
+
+    if args.lines:
+        hot = leaves.most_common(args.lines)
+        print(f"\n{'self':>6}  leaf line")
+        for (addr, count), where in zip(hot, source_lines(
+                elf, [a for a, _ in hot])):
+            print(f"{count:6d}  0x{addr:08x} {where}")
+
+    if args.collapsed:
+        with open(args.collapsed, 'w') as f:
+            for stack, count in sorted(stacks.items()):
+                f.write(f'{stack} {count}\n')
+        print(f"\n{len(stacks)} distinct stacks written to {args.collapsed}")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
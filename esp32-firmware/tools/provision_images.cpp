@@ -0,0 +1,481 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <strings.h>
+#include <thread>
+#include <vector>
+
+#include "http_date.h"
+#include "json.hpp" // The nlohmann/json library
+#include "provision.h"
+
+using json = nlohmann::json;
+
+/**
+ * @brief Builds a provisioning image per device of a fleet, in parallel.
+ *
+ * Reads a fleet manifest: per device an ID, WiFi networks, location, data
+ * wake offset and panel type, with top-level defaults for any of them
+ * ("data_url" may contain {location}). Each device gets an image for the
+ * "provision" partition (src/provision.h) with its settings and the
+ * offline calendar of its location, from --calendars DIR/<location>.json:
+ * an object of "YYYY-MM-DD" dates to prayer_times objects, as in
+ * display_data.json. Calendars are packed once per location, then the
+ * images are built and written as <id>.bin, padded to the partition, by
+ * --threads workers. flash.json lists each device's image, the partition
+ * offset from partitions.csv and the firmware environment for its panel,
+ * so one generic firmware image and the per-device data can be flashed.
+ * IDs and locations are letters, digits, '-', '_' and '.', not starting
+ * with a dot. There is no asset partition: the fonts and weather icons
+ * are compiled into the firmware and the same for every device.
+ *
+ * --repeat N builds N copies of every device (IDs get -1, -2... appended)
+ * to measure images per second for a large batch.
+ *
+ * Usage: provision_images [--out DIR] [--calendars DIR] [--from YYYY-MM-DD]
+ *                         [--partitions FILE] [--threads N] [--repeat N]
+ *                         fleet.json
+ */
+
+// Panels the firmware drives, and the PlatformIO environment of each
+struct PanelBuild {
+  const char *panel;
+  const char *env;
+};
+static const PanelBuild PANELS[] = {
+    {"GDEY073D46", "esp32-s3-wroom-1"},
+};
+
+#define PROVISION_PARTITION "provision"
+
+struct Calendar {
+  int32_t firstDay = 0;
+  std::vector<CalendarDay> days;
+};
+
+struct Device {
+  std::string id;
+  const PanelBuild *panel;
+  const Calendar *calendar;
+  ProvisionConfig config;
+};
+
+static const PanelBuild *findPanel(const std::string &name) {
+  for (const PanelBuild &p : PANELS) {
+    if (strcasecmp(p.panel, name.c_str()) == 0) {
+      return &p;
+    }
+  }
+  return nullptr;
+}
+
+// "HH:MM" as minutes of the day, -1 if malformed
+static int parseMinutes(const std::string &s) {
+  int h, m;
+  char end;
+  if (std::sscanf(s.c_str(), "%2d:%2d%c", &h, &m, &end) != 2 || h < 0 ||
+      h > 23 || m < 0 || m > 59) {
+    return -1;
+  }
+  return h * 60 + m;
+}
+
+// daysFromCivil() of "YYYY-MM-DD", or false if malformed
+static bool parseDate(const std::string &s, int32_t &day) {
+  int y, m, d;
+  char end;
+  if (std::sscanf(s.c_str(), "%4d-%2d-%2d%c", &y, &m, &d, &end) != 3 ||
+      m < 1 || m > 12 || d < 1 || d > 31) {
+    return false;
+  }
+  day = (int32_t)daysFromCivil(y, m, d);
+  return true;
+}
+
+static bool loadCalendar(const std::string &path, int32_t from,
+                         Calendar &calendar, std::string &error) {
+  static const char *NAMES[] = {"fajr", "shuruq", "dhuhr",
+                                "asr",  "maghrib", "isha"};
+  std::ifstream in(path);
+  if (!in) {
+    error = "could not open " + path;
+    return false;
+  }
+  json doc;
+  try {
+    doc = json::parse(in);
+  } catch (json::parse_error &e) {
+    error = path + ": " + e.what();
+    return false;
+  }
+  std::map<int32_t, CalendarDay> byDay;
+  for (auto &[date, times] : doc.items()) {
+    int32_t day;
+    if (!parseDate(date, day)) {
+      error = path + ": bad date '" + date + "'";
+      return false;
+    }
+    if (day < from) {
+      continue;
+    }
+    CalendarDay entry;
+    for (int i = 0; i < 6; i++) {
+      int minutes = times.is_object()
+                        ? parseMinutes(times.value(NAMES[i], std::string()))
+                        : -1;
+      entry.prayers[i] = minutes < 0 ? CALENDAR_NO_TIME : (uint16_t)minutes;
+    }
+    byDay[day] = entry;
+  }
+  if (byDay.empty()) {
+    error = path + ": no days from the start date on";
+    return false;
+  }
+  // Consecutive days from the first; gaps stay unknown, the firmware then
+  // shows the error screen on those days
+  calendar.firstDay = byDay.begin()->first;
+  int32_t span = byDay.rbegin()->first - calendar.firstDay + 1;
+  span = std::min<int32_t>(span, PROVISION_MAX_DAYS);
+  CalendarDay unknown;
+  std::fill(std::begin(unknown.prayers), std::end(unknown.prayers),
+            CALENDAR_NO_TIME);
+  calendar.days.assign(span, unknown);
+  for (auto &[day, entry] : byDay) {
+    if (day - calendar.firstDay < span) {
+      calendar.days[day - calendar.firstDay] = entry;
+    }
+  }
+  return true;
+}
+
+// Offset and size of the provision partition in a partition table CSV
+static bool findPartition(const std::string &path, uint32_t &offset,
+                          uint32_t &size) {
+  std::ifstream in(path);
+  std::string line;
+  while (std::getline(in, line)) {
+    std::vector<std::string> fields;
+    std::stringstream row(line);
+    std::string field;
+    while (std::getline(row, field, ',')) {
+      field.erase(0, field.find_first_not_of(" \t"));
+      field.erase(field.find_last_not_of(" \t\r") + 1);
+      fields.push_back(field);
+    }
+    if (fields.size() >= 5 && fields[0] == PROVISION_PARTITION) {
+      offset = std::strtoul(fields[3].c_str(), nullptr, 0);
+      size = std::strtoul(fields[4].c_str(), nullptr, 0);
+      return size > 0;
+    }
+  }
+  return false;
+}
+
+static bool copyField(char *dst, size_t size, const std::string &value,
+                      const char *name, std::string &error) {
+  if (value.size() >= size) {
+    error = std::string(name) + " longer than " + std::to_string(size - 1) +
+            " bytes";
+    return false;
+  }
+  modelSetString(dst, size, value.c_str());
+  return true;
+}
+
+// IDs and locations name files (<id>.bin, <location>.json), so neither may
+// hold a path separator or start with a dot
+static bool validId(const std::string &id) {
+  return !id.empty() && id[0] != '.' &&
+         std::all_of(id.begin(), id.end(), [](char c) {
+           return std::isalnum((unsigned char)c) || c == '-' || c == '_' ||
+                  c == '.';
+         });
+}
+
+// Settings of one manifest entry, with the manifest's defaults
+static bool parseDevice(const json &entry, const json &defaults,
+                        Device &device, std::string &error) {
+  auto field = [&](const char *name) -> const json & {
+    static const json none;
+    if (entry.contains(name)) {
+      return entry[name];
+    }
+    return defaults.contains(name) ? defaults[name] : none;
+  };
+  try {
+    device.id = field("id").get<std::string>();
+    std::string location = field("location").get<std::string>();
+    std::string panel = field("panel").is_null()
+                            ? std::string(PANELS[0].panel)
+                            : field("panel").get<std::string>();
+    std::string url = field("data_url").is_null()
+                          ? std::string()
+                          : field("data_url").get<std::string>();
+    int offset = field("wake_offset").is_null()
+                     ? 0
+                     : field("wake_offset").get<int>();
+    const json &wifi = field("wifi");
+
+    if (!validId(device.id)) {
+      error = "bad id '" + device.id + "' (letters, digits, - _ .)";
+      return false;
+    }
+    if (!validId(location)) {
+      error = "bad location '" + location + "' (letters, digits, - _ .)";
+      return false;
+    }
+    device.panel = findPanel(panel);
+    if (!device.panel) {
+      error = "unknown panel '" + panel + "'";
+      return false;
+    }
+    size_t at = url.find("{location}");
+    if (at != std::string::npos) {
+      url.replace(at, 10, location);
+    }
+    if (offset < -720 || offset > 720) {
+      error = "wake_offset outside -720..720 minutes";
+      return false;
+    }
+    if (!wifi.is_array() || wifi.empty() || wifi.size() > MAX_NETWORKS) {
+      error = "wifi needs 1 to " + std::to_string(MAX_NETWORKS) +
+              " networks";
+      return false;
+    }
+
+    ProvisionConfig &c = device.config;
+    std::memset(&c, 0, sizeof(c));
+    if (!copyField(c.deviceId, sizeof(c.deviceId), device.id, "id", error) ||
+        !copyField(c.location, sizeof(c.location), location, "location",
+                   error) ||
+        !copyField(c.dataUrl, sizeof(c.dataUrl), url, "data_url", error) ||
+        !copyField(c.panel, sizeof(c.panel), device.panel->panel, "panel",
+                   error)) {
+      return false;
+    }
+    c.wakeOffsetMin = (int16_t)offset;
+    c.networkCount = (uint8_t)wifi.size();
+    for (size_t i = 0; i < wifi.size(); i++) {
+      ProvisionNetwork &n = c.networks[i];
+      if (!copyField(n.ssid, sizeof(n.ssid),
+                     wifi[i].at("ssid").get<std::string>(), "ssid", error) ||
+          !copyField(n.password, sizeof(n.password),
+                     wifi[i].value("password", std::string()), "password",
+                     error)) {
+        return false;
+      }
+    }
+  } catch (json::exception &e) {
+    error = e.what();
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  std::string outDir = "provision";
+  std::string calendarDir;
+  std::string partitions = "partitions.csv";
+  std::string manifestPath;
+  int32_t from = INT32_MIN;
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  int repeat = 1;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--out" && i + 1 < argc) {
+      outDir = argv[++i];
+    } else if (arg == "--calendars" && i + 1 < argc) {
+      calendarDir = argv[++i];
+    } else if (arg == "--from" && i + 1 < argc) {
+      if (!parseDate(argv[++i], from)) {
+        std::cerr << "Error: --from needs YYYY-MM-DD" << std::endl;
+        return 1;
+      }
+    } else if (arg == "--partitions" && i + 1 < argc) {
+      partitions = argv[++i];
+    } else if (arg == "--threads" && i + 1 < argc) {
+      threads = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--repeat" && i + 1 < argc) {
+      repeat = std::max(1, std::atoi(argv[++i]));
+    } else {
+      manifestPath = arg;
+    }
+  }
+  if (manifestPath.empty()) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--out DIR] [--calendars DIR] [--from YYYY-MM-DD]"
+                 " [--partitions FILE] [--threads N] [--repeat N]"
+                 " fleet.json"
+              << std::endl;
+    return 1;
+  }
+
+  uint32_t partitionOffset, partitionSize;
+  if (!findPartition(partitions, partitionOffset, partitionSize)) {
+    std::cerr << "Error: no '" PROVISION_PARTITION "' partition in "
+              << partitions << std::endl;
+    return 1;
+  }
+  if (provisionSize(PROVISION_MAX_DAYS) > partitionSize) {
+    std::cerr << "Error: the '" PROVISION_PARTITION "' partition is smaller "
+              << "than the largest image, "
+              << provisionSize(PROVISION_MAX_DAYS) << " bytes" << std::endl;
+    return 1;
+  }
+
+  std::ifstream in(manifestPath);
+  json manifest;
+  try {
+    manifest = json::parse(in);
+  } catch (json::parse_error &e) {
+    std::cerr << "Error: " << manifestPath << ": " << e.what() << std::endl;
+    return 1;
+  }
+  const json &entries =
+      manifest.is_array() ? manifest : manifest.value("devices", json());
+  json defaults = manifest.is_object() ? manifest : json::object();
+  defaults.erase("devices");
+  if (!entries.is_array() || entries.empty()) {
+    std::cerr << "Error: " << manifestPath << ": no devices" << std::endl;
+    return 1;
+  }
+
+  // 1. Settings per device, calendars once per location
+  auto t0 = std::chrono::steady_clock::now();
+  std::map<std::string, Calendar> calendars;
+  std::vector<Device> devices;
+  std::map<std::string, size_t> ids;
+  for (size_t i = 0; i < entries.size(); i++) {
+    Device device;
+    std::string error;
+    if (!parseDevice(entries[i], defaults, device, error)) {
+      std::cerr << "Error: devices[" << i << "]: " << error << std::endl;
+      return 1;
+    }
+    if (!ids.emplace(device.id, i).second) {
+      std::cerr << "Error: devices[" << i << "]: id '" << device.id
+                << "' already used by devices[" << ids[device.id] << "]"
+                << std::endl;
+      return 1;
+    }
+    device.calendar = nullptr;
+    if (!calendarDir.empty()) {
+      std::string location = device.config.location;
+      auto it = calendars.find(location);
+      if (it == calendars.end()) {
+        Calendar calendar;
+        if (!loadCalendar(calendarDir + "/" + location + ".json", from,
+                          calendar, error)) {
+          std::cerr << "Error: " << error << std::endl;
+          return 1;
+        }
+        it = calendars.emplace(location, std::move(calendar)).first;
+      }
+      device.calendar = &it->second;
+    }
+    devices.push_back(device);
+  }
+  if (repeat > 1) {
+    size_t n = devices.size();
+    devices.reserve(n * repeat);
+    for (int r = 1; r < repeat; r++) {
+      for (size_t i = 0; i < n; i++) {
+        Device copy = devices[i];
+        copy.id += "-" + std::to_string(r);
+        std::string error;
+        if (!copyField(copy.config.deviceId, sizeof(copy.config.deviceId),
+                       copy.id, "id", error)) {
+          std::cerr << "Error: " << copy.id << ": " << error << std::endl;
+          return 1;
+        }
+        devices.push_back(copy);
+      }
+    }
+  }
+  auto t1 = std::chrono::steady_clock::now();
+
+  std::error_code ec;
+  std::filesystem::create_directories(outDir, ec);
+  if (ec) {
+    std::cerr << "Error: Could not create '" << outDir << "'" << std::endl;
+    return 1;
+  }
+
+  // 2. Images, built and written in parallel; devices are all alike, so
+  // workers just take the next index
+  std::atomic<size_t> next{0};
+  std::atomic<size_t> failed{0};
+  std::vector<size_t> sizes(devices.size());
+  auto work = [&] {
+    // Erased flash reads 0xFF; writing the whole partition also clears
+    // what a longer image before left behind
+    std::vector<uint8_t> image(partitionSize);
+    for (size_t i = next++; i < devices.size(); i = next++) {
+      const Device &d = devices[i];
+      std::fill(image.begin(), image.end(), 0xFF);
+      const Calendar *cal = d.calendar;
+      sizes[i] = provisionBuild(
+          image.data(), image.size(), d.config, cal ? cal->firstDay : 0,
+          cal ? cal->days.data() : nullptr,
+          cal ? (uint16_t)cal->days.size() : 0);
+      std::ofstream out(outDir + "/" + d.id + ".bin", std::ios::binary);
+      out.write(reinterpret_cast<const char *>(image.data()), image.size());
+      if (!sizes[i] || !out) {
+        failed++;
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  for (unsigned w = 0; w < threads; w++) {
+    workers.emplace_back(work);
+  }
+  for (auto &t : workers) {
+    t.join();
+  }
+  auto t2 = std::chrono::steady_clock::now();
+  if (failed) {
+    std::cerr << "Error: " << failed << " images could not be built or "
+              << "written to " << outDir << std::endl;
+    return 1;
+  }
+
+  // 3. What to flash where
+  char offset[16];
+  snprintf(offset, sizeof(offset), "0x%x", partitionOffset);
+  json flash;
+  flash["partition"] = PROVISION_PARTITION;
+  flash["offset"] = offset;
+  flash["size"] = partitionSize;
+  flash["devices"] = json::array();
+  for (size_t i = 0; i < devices.size(); i++) {
+    const Device &d = devices[i];
+    flash["devices"].push_back(
+        {{"id", d.id},
+         {"location", d.config.location},
+         {"panel", d.panel->panel},
+         {"firmware", d.panel->env},
+         {"file", d.id + ".bin"},
+         {"calendar_days", d.calendar ? d.calendar->days.size() : 0},
+         {"image_bytes", sizes[i]}});
+  }
+  std::ofstream(outDir + "/flash.json") << flash.dump(2) << std::endl;
+
+  double parse = std::chrono::duration<double>(t1 - t0).count();
+  double build = std::chrono::duration<double>(t2 - t1).count();
+  std::printf("devices=%zu locations=%zu threads=%u parse_seconds=%.3f "
+              "build_seconds=%.3f images_per_second=%.0f mb_per_second=%.1f\n",
+              devices.size(), calendars.size(), threads, parse, build,
+              devices.size() / build,
+              devices.size() * (double)partitionSize / 1e6 / build);
+  return 0;
+}
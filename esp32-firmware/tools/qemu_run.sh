@@ -0,0 +1,66 @@
+#!/bin/sh
+# Boots the firmware in Espressif's QEMU, runs one full wake cycle and
+# prints the per-phase cycle counts.
+#
+# Needs PlatformIO and qemu-system-xtensa from Espressif's QEMU fork
+# (https://github.com/espressif/qemu, or `idf_tools.py install qemu-xtensa`).
+#
+# Usage: tools/qemu_run.sh [payload.json]
+set -e
+cd "$(dirname "$0")/.."
+
+ENV=qemu
+BUILD=.pio/build/$ENV
+OUT=tools/build/qemu
+PAYLOAD=${1:-../data-collection/output/display_data.json}
+FLASH_SIZE=8MB
+# Instruction counting keeps runs deterministic; shift 2 is 4 ns per
+# instruction, about 240 MHz at one instruction per cycle
+ICOUNT=${ICOUNT:-2}
+QEMU=${QEMU:-qemu-system-xtensa}
+
+# 1. Firmware, plus a LittleFS image holding the payload
+mkdir -p $OUT/data
+cp "$PAYLOAD" $OUT/data/display_data.json
+export PLATFORMIO_DATA_DIR=$OUT/data
+pio run -e $ENV
+pio run -e $ENV -t buildfs
+
+# 2. One flash image: bootloader, partition table, OTA data, app, LittleFS
+# at its offset in partitions.csv. provision, state and coredump are left
+# erased (0xFF), as on a freshly flashed device.
+FRAMEWORK=${FRAMEWORK:-$HOME/.platformio/packages/framework-arduinoespressif32}
+PARTITIONS=$FRAMEWORK/tools/partitions
+FS_OFFSET=$(awk -F, '/^spiffs/ { gsub(/ /, "", $4); print $4 }' \
+  partitions.csv)
+pio pkg exec -p tool-esptoolpy -- esptool.py --chip esp32s3 \
+  merge_bin --fill-flash-size $FLASH_SIZE --flash_mode dio \
+  --flash_size $FLASH_SIZE -o $OUT/flash.bin \
+  0x0 $BUILD/bootloader.bin \
+  0x8000 $BUILD/partitions.bin \
+  0xe000 $PARTITIONS/boot_app0.bin \
+  0x10000 $BUILD/firmware.bin \
+  $FS_OFFSET $BUILD/littlefs.bin
+
+# 3. Run until the firmware reports the end of the wake
+rm -f $OUT/serial.log
+$QEMU -nographic -machine esp32s3 -icount shift=$ICOUNT \
+  -drive file=$OUT/flash.bin,if=mtd,format=raw \
+  -serial file:$OUT/serial.log -monitor none &
+PID=$!
+trap 'kill $PID 2>/dev/null' EXIT
+for _ in $(seq 1 300); do
+  if grep -q "QEMU: wake cycle done" $OUT/serial.log 2>/dev/null; then
+    break
+  fi
+  sleep 1
+done
+
+if ! grep -q "QEMU: wake cycle done" $OUT/serial.log; then
+  echo "Wake cycle did not finish, see $OUT/serial.log" >&2
+  exit 1
+fi
+awk '/^PHASE/ {
+  split($3, us, "="); split($4, cycles, "=")
+  printf "%-8s %10s us %12s cycles\n", $2, us[2], cycles[2]
+}' $OUT/serial.log
@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "json.hpp" // The nlohmann/json library
+
+using json = nlohmann::json;
+
+/**
+ * @brief Time and memory of read_data's lazy query mode against a full parse.
+ *
+ * Writes archives of about 1 KB, 1 MB and 100 MB: the payload's top-level
+ * keys followed by "days", an array of copies of the payload with varying
+ * times. Each size is queried for /prayer_times/fajr (early in the file)
+ * and for the last day's fajr (the scan has to pass everything), running
+ * read_data as a child process with and without --dom. Prints the median
+ * wall time and the child's peak RSS, and fails if the two modes print
+ * different values.
+ *
+ * A small file that repeats keys, at the top level and nested, is then
+ * queried in both modes. The lazy scan must return the first member with
+ * the name and the full parse the last, as read_data documents.
+ *
+ * Usage: read_data_bench [--bin read_data] [--dir DIR] [--runs N]
+ *                        [payload.json]
+ */
+
+struct Run {
+    double ms;
+    long maxRssKb;
+    std::string out;
+};
+
+// Runs bin with args, stdout to a file; false if it didn't exit with 0
+static bool runChild(const std::string& bin, const std::vector<std::string>& args,
+                     const std::string& outPath, Run& run) {
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid == 0) {
+        int fd = open(outPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        dup2(fd, STDOUT_FILENO);
+        std::vector<char*> argv = {const_cast<char*>(bin.c_str())};
+        for (const std::string& a : args) {
+            argv.push_back(const_cast<char*>(a.c_str()));
+        }
+        argv.push_back(nullptr);
+        execv(bin.c_str(), argv.data());
+        _exit(127);
+    }
+    int status;
+    struct rusage usage;
+    wait4(pid, &status, 0, &usage);
+    run.ms = std::chrono::duration<double, std::milli>(
+                 std::chrono::steady_clock::now() - start).count();
+    run.maxRssKb = usage.ru_maxrss;
+    std::ifstream in(outPath);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    run.out = ss.str();
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Writes the archive and returns the number of days in it
+static size_t writeArchive(const json& payload, const std::string& path, size_t target) {
+    json day = payload;
+    std::string top = payload.dump(2);
+    top.pop_back(); // the closing brace; "days" goes last
+    while (!top.empty() && (top.back() == '\n' || top.back() == ' ')) {
+        top.pop_back();
+    }
+
+    std::ofstream out(path, std::ios::binary);
+    out << top << ",\n  \"days\": [";
+    size_t written = top.size() + 12;
+    size_t days = 0;
+    do {
+        // Vary the times so the days aren't identical
+        char fajr[6];
+        snprintf(fajr, sizeof(fajr), "%02zu:%02zu", 4 + days % 3, days % 60);
+        day["prayer_times"]["fajr"] = fajr;
+        std::string text = day.dump();
+        out << (days ? ",\n    " : "\n    ") << text;
+        written += text.size() + 6;
+        days++;
+    } while (written < target);
+    out << "\n  ]\n}\n";
+    return days;
+}
+
+// Checks the documented difference: lazy finds the first duplicate, DOM keeps the last
+static int checkDuplicateKeys(const std::string& bin, const std::string& dir) {
+    std::string path = dir + "/read_data_bench_dup.json";
+    std::ofstream(path) << "{\"fajr\": \"05:01\", \"prayer_times\": {\"fajr\": \"05:02\",\n"
+                           "  \"fajr\": \"05:03\"}, \"fajr\": \"05:04\"}\n";
+    const struct {
+        const char* query;
+        const char* lazy;
+        const char* dom;
+    } cases[] = {{"/fajr", "05:01\n", "05:04\n"},
+                 {"/prayer_times/fajr", "05:02\n", "05:03\n"}};
+    int failures = 0;
+    for (const auto& c : cases) {
+        for (int mode = 0; mode < 2; mode++) {
+            std::vector<std::string> args = {"-q", c.query, path};
+            if (mode == 1) {
+                args.insert(args.begin(), "--dom");
+            }
+            Run run;
+            const char* expected = mode ? c.dom : c.lazy;
+            if (!runChild(bin, args, dir + "/read_data_bench.out", run) ||
+                run.out != expected) {
+                printf("MISMATCH dup %s %s: '%s', expected '%s'\n", c.query,
+                       mode ? "dom" : "lazy", run.out.c_str(), expected);
+                failures++;
+            }
+        }
+    }
+    std::remove(path.c_str());
+    return failures;
+}
+
+int main(int argc, char* argv[]) {
+    std::string bin = "tools/build/read_data";
+    std::string dir = "/tmp";
+    std::string payloadPath = "../data-collection/output/display_data.json";
+    int runs = 3;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--bin" && i + 1 < argc) {
+            bin = argv[++i];
+        } else if (arg == "--dir" && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (arg == "--runs" && i + 1 < argc) {
+            runs = std::max(1, std::atoi(argv[++i]));
+        } else if (arg[0] == '-') {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--bin read_data] [--dir DIR] [--runs N] [payload.json]"
+                      << std::endl;
+            return 1;
+        } else {
+            payloadPath = arg;
+        }
+    }
+
+    std::ifstream in(payloadPath);
+    json payload;
+    try {
+        payload = json::parse(in);
+    } catch (json::parse_error& e) {
+        std::cerr << "Error: " << payloadPath << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    const struct {
+        const char* name;
+        size_t bytes;
+    } sizes[] = {{"1KB", 1000}, {"1MB", 1000000}, {"100MB", 100000000}};
+
+    int failures = 0;
+    printf("%-6s %-32s %-5s %10s %10s\n", "size", "query", "mode", "ms", "rss_mb");
+    for (const auto& size : sizes) {
+        std::string path = dir + "/read_data_bench_" + size.name + ".json";
+        size_t days = writeArchive(payload, path, size.bytes);
+        std::string last = "/days/" + std::to_string(days - 1) + "/prayer_times/fajr";
+        for (const std::string& query : {std::string("/prayer_times/fajr"), last}) {
+            std::string outputs[2];
+            for (int mode = 0; mode < 2; mode++) {
+                std::vector<std::string> args = {"-q", query, path};
+                if (mode == 1) {
+                    args.insert(args.begin(), "--dom");
+                }
+                std::vector<double> times;
+                long rss = 0;
+                for (int r = 0; r < runs; r++) {
+                    Run run;
+                    if (!runChild(bin, args, dir + "/read_data_bench.out", run)) {
+                        std::cerr << "Error: " << bin << " failed on " << path << std::endl;
+                        return 1;
+                    }
+                    times.push_back(run.ms);
+                    rss = std::max(rss, run.maxRssKb);
+                    outputs[mode] = run.out;
+                }
+                std::sort(times.begin(), times.end());
+                printf("%-6s %-32s %-5s %10.2f %10.1f\n", size.name, query.c_str(),
+                       mode ? "dom" : "lazy", times[times.size() / 2], rss / 1024.0);
+            }
+            if (outputs[0] != outputs[1]) {
+                printf("MISMATCH %s %s: lazy '%s' dom '%s'\n", size.name, query.c_str(),
+                       outputs[0].c_str(), outputs[1].c_str());
+                failures++;
+            }
+        }
+        std::remove(path.c_str());
+    }
+    failures += checkDuplicateKeys(bin, dir);
+    printf("failures=%d\n", failures);
+    return failures ? 1 : 0;
+}
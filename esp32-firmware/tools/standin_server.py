@@ -0,0 +1,315 @@
+"""
+Local stand-in for raw.githubusercontent.com with fault injection.
+
+Serves files from the repository checkout under the same paths GitHub uses
+(/<owner>/<repo>/<branch>/<path>), ignoring the query string like the
+device's cache buster. Responses carry an ETag; If-None-Match gives 304 and
+Range gives 206. Faults come from command-line defaults and from a script of
+per-request overrides, consumed in order:
+
+    [
+      {"latency_ms": 3000},
+      {"status": 503},
+      {"tls_error": "reset"},
+      {"truncate": 512, "kbps": 20},
+      {"path": "display_data.json", "etag": false}
+    ]
+
+Entries may be limited to a path substring ("path") and repeated ("times").
+The script can be replaced at runtime with POST /_faults, and every request
+is recorded; GET /_log returns the log as JSON and --log appends it as JSON
+lines.
+
+Usage:
+    python standin_server.py [--port 8080] [--tls cert.pem key.pem]
+                             [--script faults.json] [--log requests.jsonl]
+                             [--latency-ms N] [--kbps N]
+"""
+
+import argparse
+import hashlib
+import json
+import socket
+import ssl
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from pathlib import Path
+from typing import Any, Dict, List, Optional
+from urllib.parse import urlsplit
+
+REPO_ROOT = Path(__file__).resolve().parents[2]
+
+
+class FaultScript:
+    """Per-request fault overrides on top of defaults, consumed in order."""
+
+    def __init__(self, defaults: Dict[str, Any]):
+        self.defaults = defaults
+        self.entries: List[Dict[str, Any]] = []
+        self.lock = threading.Lock()
+
+    def load(self, entries: List[Dict[str, Any]]):
+        with self.lock:
+            self.entries = [dict(e) for e in entries]
+
+    def _take(self, accept) -> Optional[Dict[str, Any]]:
+        with self.lock:
+            for i, entry in enumerate(self.entries):
+                if accept(entry):
+                    entry['times'] = entry.get('times', 1) - 1
+                    if entry['times'] <= 0:
+                        del self.entries[i]
+                    return entry
+        return None
+
+    def next_connection(self) -> Optional[str]:
+        """TLS faults happen before the request is known; returns the mode."""
+        entry = self._take(lambda e: 'tls_error' in e)
+        return entry['tls_error'] if entry else None
+
+    def next_request(self, path: str) -> Dict[str, Any]:
+        entry = self._take(lambda e: 'tls_error' not in e and
+                           e.get('path', '') in path)
+        fault = dict(self.defaults)
+        if entry:
+            fault.update({k: v for k, v in entry.items()
+                          if k not in ('path', 'times')})
+        return fault
+
+
+class StandinServer(ThreadingHTTPServer):
+    daemon_threads = True
+
+    def __init__(self, address, root: Path, faults: FaultScript,
+                 tls: Optional[ssl.SSLContext], log_path: Optional[Path]):
+        super().__init__(address, StandinHandler)
+        self.root = root
+        self.faults = faults
+        self.tls = tls
+        self.log_path = log_path
+        self.log: List[Dict[str, Any]] = []
+        self.log_lock = threading.Lock()
+
+    def get_request(self):
+        sock, addr = super().get_request()
+        if self.tls is None:
+            return sock, addr
+        mode = self.faults.next_connection()
+        if mode is not None:
+            self.record({'client': addr[0], 'tls_error': mode})
+            if mode == 'garbage':
+                sock.sendall(b'\x15\x03\x03\x00\x02\x02\x28' * 4)
+            sock.close()
+            raise OSError('injected TLS error')
+        try:
+            return self.tls.wrap_socket(sock, server_side=True), addr
+        except (ssl.SSLError, OSError) as e:
+            self.record({'client': addr[0], 'tls_error': str(e)})
+            sock.close()
+            raise
+
+    def record(self, entry: Dict[str, Any]):
+        entry['time'] = round(time.time(), 3)
+        with self.log_lock:
+            self.log.append(entry)
+            if self.log_path:
+                with open(self.log_path, 'a') as f:
+                    f.write(json.dumps(entry) + '\n')
+        print(json.dumps(entry))
+
+
+class StandinHandler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+    server: StandinServer
+
+    def log_message(self, format, *args):
+        pass  # replaced by the structured request log
+
+    def resolve(self, path: str) -> Optional[Path]:
+        """Maps /<owner>/<repo>/<branch>/<path> (or plain <path>) to a file."""
+        parts = [p for p in path.split('/') if p and p != '..']
+        for candidate in (parts[3:], parts):
+            if candidate:
+                file = self.server.root.joinpath(*candidate)
+                if file.is_file():
+                    return file
+        return None
+
+    def do_POST(self):
+        if urlsplit(self.path).path != '/_faults':
+            self.send_simple(404, b'Not Found')
+            return
+        length = int(self.headers.get('Content-Length', 0))
+        try:
+            self.server.faults.load(json.loads(self.rfile.read(length)))
+        except (ValueError, TypeError) as e:
+            self.send_simple(400, str(e).encode())
+            return
+        self.send_simple(204, b'')
+
+    def do_HEAD(self):
+        self.do_GET()
+
+    def do_GET(self):
+        path = urlsplit(self.path).path
+        if path == '/_log':
+            with self.server.log_lock:
+                body = json.dumps(self.server.log).encode()
+            self.send_simple(200, body, 'application/json')
+            return
+
+        fault = self.server.faults.next_request(path)
+        entry = {
+            'client': self.client_address[0],
+            'method': self.command,
+            'path': self.path,
+            'range': self.headers.get('Range'),
+            'if_none_match': self.headers.get('If-None-Match'),
+        }
+        start = time.monotonic()
+        try:
+            status, sent = self.respond(path, fault)
+            entry.update(status=status, bytes=sent)
+        except (BrokenPipeError, ConnectionResetError):
+            entry['status'] = 'client closed'
+        defaults = self.server.faults.defaults
+        entry['fault'] = {k: v for k, v in fault.items()
+                          if v != defaults.get(k)}
+        entry['ms'] = round((time.monotonic() - start) * 1000)
+        self.server.record(entry)
+
+    def respond(self, path: str, fault: Dict[str, Any]):
+        if fault.get('latency_ms'):
+            time.sleep(fault['latency_ms'] / 1000)
+        if fault.get('status'):
+            return self.send_simple(fault['status'], b'Injected error\n'), 0
+
+        file = self.resolve(path)
+        if file is None:
+            return self.send_simple(404, b'404: Not Found\n'), 0
+        data = file.read_bytes()
+        etag = '"' + hashlib.sha1(data).hexdigest() + '"'
+        use_etag = fault.get('etag', True)
+
+        if use_etag and self.headers.get('If-None-Match') == etag:
+            self.send_response(304)
+            self.send_header('ETag', etag)
+            self.send_header('Content-Length', '0')
+            self.end_headers()
+            return 304, 0
+
+        status = 200
+        body = data
+        content_range = None
+        requested = self.headers.get('Range', '')
+        if requested.startswith('bytes='):
+            first, _, last = requested[6:].partition('-')
+            try:
+                if first == '':
+                    lo, hi = max(0, len(data) - int(last)), len(data) - 1
+                else:
+                    lo = int(first)
+                    hi = min(int(last), len(data) - 1) if last else len(data) - 1
+            except ValueError:
+                lo, hi = 0, -1
+            if lo > hi or lo >= len(data):
+                self.send_response(416)
+                self.send_header('Content-Range', f'bytes */{len(data)}')
+                self.send_header('Content-Length', '0')
+                self.end_headers()
+                return 416, 0
+            status = 206
+            body = data[lo:hi + 1]
+            content_range = f'bytes {lo}-{hi}/{len(data)}'
+
+        self.send_response(status)
+        self.send_header('Content-Type', 'text/plain; charset=utf-8')
+        self.send_header('Content-Length', str(len(body)))
+        self.send_header('Accept-Ranges', 'bytes')
+        self.send_header('Cache-Control', 'max-age=300')
+        if use_etag:
+            self.send_header('ETag', etag)
+        if content_range:
+            self.send_header('Content-Range', content_range)
+        self.end_headers()
+        if self.command == 'HEAD':
+            return status, 0
+
+        # Truncation keeps the advertised length, then drops the connection
+        truncate = fault.get('truncate')
+        if truncate is not None and truncate < len(body):
+            body = body[:truncate]
+            self.close_connection = True
+        sent = self.write_throttled(body, fault.get('kbps'))
+        if self.close_connection:
+            self.connection.shutdown(socket.SHUT_RDWR)
+        return status, sent
+
+    def write_throttled(self, body: bytes, kbps: Optional[float]) -> int:
+        if not kbps:
+            self.wfile.write(body)
+            return len(body)
+        chunk = 256
+        delay = chunk * 8 / (kbps * 1000)
+        for i in range(0, len(body), chunk):
+            self.wfile.write(body[i:i + chunk])
+            self.wfile.flush()
+            time.sleep(delay)
+        return len(body)
+
+    def send_simple(self, status: int, body: bytes,
+                    content_type: str = 'text/plain') -> int:
+        self.send_response(status)
+        self.send_header('Content-Type', content_type)
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        if self.command != 'HEAD':
+            self.wfile.write(body)
+        return status
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Fault-injecting stand-in for raw.githubusercontent.com')
+    parser.add_argument('--host', default='0.0.0.0')
+    parser.add_argument('--port', type=int, default=8080)
+    parser.add_argument('--root', type=Path, default=REPO_ROOT,
+                        help='directory served as the repository checkout')
+    parser.add_argument('--tls', nargs=2, metavar=('CERT', 'KEY'),
+                        help='serve HTTPS (the device skips verification)')
+    parser.add_argument('--script', type=Path,
+                        help='JSON list of per-request faults')
+    parser.add_argument('--log', type=Path, help='append requests as JSON lines')
+    parser.add_argument('--latency-ms', type=int, default=0,
+                        help='default delay before each response')
+    parser.add_argument('--kbps', type=float, default=0,
+                        help='default body bandwidth limit')
+    parser.add_argument('--no-etag', action='store_true',
+                        help='never send ETag or answer 304')
+    args = parser.parse_args()
+
+    faults = FaultScript({'latency_ms': args.latency_ms, 'kbps': args.kbps,
+                          'etag': not args.no_etag})
+    if args.script:
+        faults.load(json.loads(args.script.read_text()))
+
+    tls = None
+    if args.tls:
+        tls = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        tls.load_cert_chain(*args.tls)
+
+    server = StandinServer((args.host, args.port), args.root, faults, tls,
+                           args.log)
+    scheme = 'https' if tls else 'http'
+    print(f"Serving {args.root} on {scheme}://{args.host}:{args.port}/",
+          file=sys.stderr)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "render_model.h"
+#include "udp_sync.h"
+#include "wake_trace.h"
+
+/**
+ * @brief Sync protocol under injected loss, on a virtual clock.
+ *
+ * Runs the device's sync client (src/udp_sync.h) against syncServe() over
+ * a simulated LAN link that drops and corrupts datagrams in both
+ * directions, with the client's real timeout and retransmission schedule.
+ * Each case runs many exchanges and reports how many completed and how
+ * long they took from the first request. It fails if any exchange returns
+ * a payload that differs from what the server sent, or if a lossless link
+ * needs more than one round trip.
+ *
+ * Cases: a render model (one datagram), a 6 KB payload (selective
+ * retransmission of missing chunks), the server publishing a new payload
+ * mid-exchange, and an unchanged payload.
+ *
+ * Usage: sync_loss_test [--trials N] [--seed N]
+ */
+
+#define ONE_WAY_US 1000 // LAN latency, including the server
+#define DATAGRAM_US 120 // serialization of a full datagram back to back
+
+struct Datagram {
+  uint32_t atUs;
+  std::vector<uint8_t> bytes;
+};
+
+struct Link {
+  std::mt19937 rng;
+  double loss;
+  double corrupt;
+
+  // False if the datagram is lost; may flip a bit in it
+  bool carry(std::vector<uint8_t> &bytes) {
+    std::uniform_real_distribution<> u(0, 1);
+    if (u(rng) < loss) {
+      return false;
+    }
+    if (u(rng) < corrupt) {
+      bytes[rng() % bytes.size()] ^= 1 << (rng() % 8);
+    }
+    return true;
+  }
+};
+
+struct ServerSide {
+  Link *link;
+  uint32_t nowUs;
+  std::vector<Datagram> *inFlight;
+};
+
+static void serverSend(void *ctx, const uint8_t *data, size_t len) {
+  ServerSide &s = *static_cast<ServerSide *>(ctx);
+  std::vector<uint8_t> bytes(data, data + len);
+  if (s.link->carry(bytes)) {
+    s.inFlight->push_back({s.nowUs, bytes});
+  }
+  s.nowUs += DATAGRAM_US;
+}
+
+struct Case {
+  const char *name;
+  std::vector<uint8_t> payload;
+  std::vector<uint8_t> next; // published after the first request, if any
+  bool known;                // the device already has the payload
+};
+
+struct Outcome {
+  SyncStatus status;
+  uint32_t us;
+  uint8_t requests;
+  bool intact;
+};
+
+static Outcome exchange(const Case &c, Link &link, uint16_t nonce) {
+  static const uint8_t deviceId[6] = {0x24, 0x6f, 0x28, 0x01, 0x02, 0x03};
+  static std::vector<uint8_t> buf(SYNC_MAX_CHUNKS * SYNC_CHUNK);
+  const std::vector<uint8_t> *published = &c.payload;
+  uint32_t version = traceHash(published->data(), published->size());
+  SyncClient client;
+  syncClientBegin(client, deviceId, nonce, c.known ? version : 0,
+                  buf.data(), buf.size());
+
+  uint32_t nowUs = 0;
+  uint8_t requests = 0;
+  while (true) {
+    SyncRequest request;
+    uint32_t timeoutMs;
+    if (syncClientRequest(client, request, timeoutMs) == SYNC_GAVE_UP) {
+      return {SYNC_GAVE_UP, nowUs, requests, true};
+    }
+    requests++;
+    uint32_t deadline = nowUs + timeoutMs * 1000;
+
+    std::vector<Datagram> replies;
+    std::vector<uint8_t> bytes(reinterpret_cast<uint8_t *>(&request),
+                               reinterpret_cast<uint8_t *>(&request) +
+                                   sizeof(request));
+    SyncRequest received;
+    if (link.carry(bytes) &&
+        syncParseRequest(bytes.data(), bytes.size(), received)) {
+      if (requests == 2 && !c.next.empty()) {
+        published = &c.next;
+        version = traceHash(published->data(), published->size());
+      }
+      ServerSide server = {&link, nowUs + ONE_WAY_US, &replies};
+      syncServe(received, published->data(), published->size(), version,
+                1772362800, serverSend, &server);
+    }
+    for (Datagram &d : replies) {
+      d.atUs += ONE_WAY_US;
+      if (d.atUs > deadline) {
+        break; // the device would still take these; pessimistic
+      }
+      SyncStatus status =
+          syncClientReceive(client, d.bytes.data(), d.bytes.size());
+      if (status == SYNC_SAME) {
+        return {status, d.atUs, requests, c.known};
+      }
+      if (status == SYNC_COMPLETE) {
+        bool intact =
+            (client.total == c.payload.size() &&
+             memcmp(buf.data(), c.payload.data(), client.total) == 0) ||
+            (client.total == c.next.size() &&
+             memcmp(buf.data(), c.next.data(), client.total) == 0);
+        return {status, d.atUs, requests, intact};
+      }
+    }
+    nowUs = deadline;
+  }
+}
+
+static std::vector<uint8_t> randomBytes(std::mt19937 &rng, size_t n) {
+  std::vector<uint8_t> v(n);
+  for (uint8_t &b : v) {
+    b = rng();
+  }
+  return v;
+}
+
+int main(int argc, char *argv[]) {
+  int trials = 2000;
+  unsigned seed = 1;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--trials" && i + 1 < argc) {
+      trials = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--seed" && i + 1 < argc) {
+      seed = std::strtoul(argv[++i], nullptr, 10);
+    } else {
+      std::fprintf(stderr, "Usage: %s [--trials N] [--seed N]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  std::mt19937 rng(seed);
+  RenderModel model;
+  memset(&model, 0, sizeof(model));
+  modelSetString(model.location, sizeof(model.location), "Stuttgart");
+  model.highlight = -1;
+  std::vector<uint8_t> modelBytes(reinterpret_cast<uint8_t *>(&model),
+                                  reinterpret_cast<uint8_t *>(&model) +
+                                      sizeof(model));
+  std::vector<Case> cases = {
+      {"model", modelBytes, {}, false},
+      {"6kb", randomBytes(rng, 6000), {}, false},
+      {"republish", randomBytes(rng, 3000), randomBytes(rng, 2500), false},
+      {"unchanged", modelBytes, {}, true},
+  };
+  const double losses[] = {0, 0.05, 0.2, 0.4};
+
+  int failures = 0;
+  std::printf("%-10s %5s %8s %8s %8s %8s %8s\n", "case", "loss", "done",
+              "p50_ms", "p99_ms", "max_ms", "requests");
+  for (const Case &c : cases) {
+    for (double loss : losses) {
+      Link link = {std::mt19937(seed), loss, loss > 0 ? 0.01 : 0};
+      std::vector<uint32_t> times;
+      int done = 0;
+      long requests = 0;
+      for (int t = 0; t < trials; t++) {
+        Outcome o = exchange(c, link, (uint16_t)t);
+        requests += o.requests;
+        if (o.status == SYNC_GAVE_UP) {
+          continue;
+        }
+        if (!o.intact) {
+          std::printf("CORRUPT %s loss=%.2f trial=%d\n", c.name, loss, t);
+          failures++;
+        }
+        if (loss == 0 && o.requests != 1) {
+          std::printf("RETRY %s without loss, trial=%d\n", c.name, t);
+          failures++;
+        }
+        done++;
+        times.push_back(o.us);
+      }
+      std::sort(times.begin(), times.end());
+      auto pct = [&](double p) {
+        return times.empty() ? 0.0
+                             : times[(size_t)(p * (times.size() - 1))] / 1000.0;
+      };
+      std::printf("%-10s %4.0f%% %7.2f%% %8.2f %8.2f %8.2f %8.2f\n", c.name,
+                  loss * 100, 100.0 * done / trials, pct(0.5), pct(0.99),
+                  pct(1.0), (double)requests / trials);
+      if (loss == 0 && done != trials) {
+        failures++;
+      }
+    }
+  }
+  std::printf("failures=%d\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,170 @@
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <netinet/in.h>
+#include <random>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "json.hpp" // The nlohmann/json library
+#include "payload_model.h"
+#include "render_model.h"
+#include "udp_sync.h"
+#include "wake_trace.h"
+
+using json = nlohmann::json;
+
+/**
+ * @brief LAN sync server for devices built with -DSYNC_SERVER.
+ *
+ * Answers each sync request (src/udp_sync.h) with UNCHANGED or the
+ * device's render model, built from its payload file the same way the
+ * device maps display_data.json. Payload files are re-read when they
+ * change, so the aggregator can keep writing them. --drop discards that
+ * fraction of the reply datagrams to exercise retransmission on a real
+ * device.
+ *
+ * Usage: sync_server [--port N] [--drop P] [--device MAC=payload.json]...
+ *                    payload.json
+ */
+
+struct Payload {
+  std::string path;
+  std::filesystem::file_time_type mtime;
+  RenderModel model;
+  uint32_t version = 0;
+};
+
+// (Re)loads the file if it changed; false if it can't be read
+static bool refresh(Payload &p) {
+  std::error_code ec;
+  auto mtime = std::filesystem::last_write_time(p.path, ec);
+  if (ec) {
+    return false;
+  }
+  if (p.version != 0 && mtime == p.mtime) {
+    return true;
+  }
+  std::ifstream in(p.path);
+  json doc;
+  try {
+    doc = json::parse(in);
+  } catch (json::parse_error &e) {
+    std::cerr << "Error: " << p.path << ": " << e.what() << std::endl;
+    return false;
+  }
+  p.model = modelFromPayload(doc);
+  p.model.highlight = -1; // the device sets it from its clock
+  p.version = traceHash(&p.model, sizeof(p.model));
+  p.mtime = mtime;
+  std::printf("loaded %s version=%08x (%zu bytes)\n", p.path.c_str(),
+              p.version, sizeof(p.model));
+  return true;
+}
+
+static std::string macString(const uint8_t *id) {
+  char s[18];
+  snprintf(s, sizeof(s), "%02x:%02x:%02x:%02x:%02x:%02x", id[0], id[1], id[2],
+           id[3], id[4], id[5]);
+  return s;
+}
+
+struct Sender {
+  int fd;
+  sockaddr_in to;
+  double drop;
+  std::mt19937 rng;
+  int dropped;
+};
+
+static void sendDatagram(void *ctx, const uint8_t *data, size_t len) {
+  Sender &s = *static_cast<Sender *>(ctx);
+  if (std::uniform_real_distribution<>(0, 1)(s.rng) < s.drop) {
+    s.dropped++;
+    return;
+  }
+  sendto(s.fd, data, len, 0, reinterpret_cast<sockaddr *>(&s.to),
+         sizeof(s.to));
+}
+
+int main(int argc, char *argv[]) {
+  int port = SYNC_PORT;
+  double drop = 0;
+  Payload fallback;
+  std::map<std::string, Payload> devices;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--port" && i + 1 < argc) {
+      port = std::atoi(argv[++i]);
+    } else if (arg == "--drop" && i + 1 < argc) {
+      drop = std::atof(argv[++i]);
+    } else if (arg == "--device" && i + 1 < argc) {
+      std::string spec = argv[++i];
+      size_t eq = spec.find('=');
+      if (eq == std::string::npos) {
+        std::cerr << "Error: --device wants MAC=payload.json" << std::endl;
+        return 1;
+      }
+      devices[spec.substr(0, eq)].path = spec.substr(eq + 1);
+    } else {
+      fallback.path = arg;
+    }
+  }
+  if (fallback.path.empty() && devices.empty()) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--port N] [--drop P] [--device MAC=payload.json]..."
+                 " payload.json"
+              << std::endl;
+    return 1;
+  }
+
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if (fd < 0 || bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr))) {
+    std::perror("bind");
+    return 1;
+  }
+  std::printf("sync server on udp/%d, dropping %.0f%% of replies\n", port,
+              drop * 100);
+  std::fflush(stdout);
+
+  Sender sender = {fd, {}, drop, std::mt19937(std::random_device()()), 0};
+  uint8_t buf[512];
+  while (true) {
+    socklen_t fromLen = sizeof(sender.to);
+    ssize_t n = recvfrom(fd, buf, sizeof(buf), 0,
+                         reinterpret_cast<sockaddr *>(&sender.to), &fromLen);
+    SyncRequest request;
+    if (n <= 0 || !syncParseRequest(buf, n, request)) {
+      continue;
+    }
+    std::string mac = macString(request.deviceId);
+    auto it = devices.find(mac);
+    Payload &payload = it != devices.end() ? it->second : fallback;
+    if (payload.path.empty() || !refresh(payload)) {
+      std::printf("%s unknown device or unreadable payload\n", mac.c_str());
+      continue;
+    }
+    sender.dropped = 0;
+    int sent = syncServe(request, reinterpret_cast<uint8_t *>(&payload.model),
+                         sizeof(payload.model), payload.version,
+                         (uint32_t)time(nullptr), sendDatagram, &sender);
+    std::printf("%s attempt=%u known=%08x -> %s datagrams=%d dropped=%d\n",
+                mac.c_str(), request.attempt, request.knownVersion,
+                request.knownVersion == payload.version ? "unchanged" : "data",
+                sent, sender.dropped);
+    std::fflush(stdout);
+  }
+}
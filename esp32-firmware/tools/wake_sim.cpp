@@ -0,0 +1,463 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "json.hpp" // The nlohmann/json library
+#include "payload_model.h"
+#include "render_model.h"
+#include "schedule.h"
+#include "wake_trace.h"
+
+using json = nlohmann::json;
+
+/**
+ * @brief Replays the firmware's wake cycle on a virtual clock.
+ *
+ * Runs the wake decisions of setup()/goToSleep() against the portable
+ * scheduling code, with the network conditions taken from wake traces
+ * captured on a device (-DWAKE_TRACE, dumped as "TRACE <hex>" lines over
+ * serial). Each simulated fetch gets the outcome of the last recorded fetch
+ * at or before its time, so a changed policy can be compared against what
+ * the device actually did on the same nights. Without traces every fetch
+ * succeeds.
+ *
+ * Outages can be injected on top: --outage D/HH:MM/MIN fails every fetch
+ * from HH:MM on day D (0 is the first) for MIN minutes, --flaky P fails
+ * each fetch with probability P. Failed fetches follow the firmware's retry
+ * policy (schedule.h); --no-retry replays the old one, the error screen
+ * at once and no fetch before the next data wake. The summary adds how
+ * long the error screen was up and how long fresh data was overdue.
+ *
+ * Usage: wake_sim [--trace serial.log] [--dump] [--days N] [--tz TZ]
+ *                 [--data-wake HH:MM] [--no-highlight] [--quiet]
+ *                 [--outage D/HH:MM/MIN]... [--flaky P] [--seed N]
+ *                 [--errors-after N] [--no-retry] payload.json
+ */
+
+// Firmware defaults (main.cpp)
+#define DEFAULT_TZ "CET-1CEST,M3.5.0,M10.5.0/3"
+#define DEFAULT_DATA_WAKE "00:10"
+// Awake time when no trace says otherwise
+#define FETCH_AWAKE_MS 9000     // connect, sync, fetch, render
+#define HIGHLIGHT_AWAKE_MS 2500 // load the pre-rendered frame
+#define REFRESH_MS 30000        // pushFrame() waits for the panel
+#define FAILED_AWAKE_MS 20000   // an injected failure: timeouts, then sleep
+#define DEFAULT_FAILURES_BEFORE_ERROR 8
+
+struct FetchOutcome {
+  time_t at;
+  bool wifiOk;
+  uint32_t assocMs;
+  int httpCode;
+  bool parsed;
+  uint32_t awakeMs;
+  bool ok() const { return wifiOk && httpCode == 200 && parsed; }
+};
+
+struct WakeSummary {
+  int wakes = 0;
+  int fetches = 0;
+  int failures = 0;
+  int refreshes = 0;
+  double awakeSeconds = 0;
+  int errorScreens = 0;
+  double errorSeconds = 0;   // error screen on the panel
+  double overdueSeconds = 0; // from a failed fetch to the next good one
+};
+
+struct Outage {
+  time_t from;
+  time_t to;
+};
+
+static const char *eventName(uint8_t type) {
+  static const char *names[] = {"?",     "wifi_ok", "wifi_fail", "time_sync",
+                                "dns",   "http",    "tls",       "body",
+                                "parse", "refresh", "sleep"};
+  return type <= TRACE_SLEEP ? names[type] : "?";
+}
+
+// Reads "TRACE <hex>" lines, ignoring everything else in a serial capture
+static std::vector<WakeTrace> loadTraces(const std::string &path) {
+  std::vector<WakeTrace> traces;
+  std::ifstream in(path);
+  std::string line;
+  while (std::getline(in, line)) {
+    size_t pos = line.find("TRACE ");
+    if (pos == std::string::npos) {
+      continue;
+    }
+    std::string hex = line.substr(pos + 6);
+    while (!hex.empty() && (hex.back() == '\r' || hex.back() == ' ')) {
+      hex.pop_back();
+    }
+    std::vector<uint8_t> bytes;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+      bytes.push_back(std::strtoul(hex.substr(i, 2).c_str(), nullptr, 16));
+    }
+    WakeTrace trace;
+    if (traceDecode(bytes.data(), bytes.size(), trace)) {
+      traces.push_back(trace);
+    } else if (hex != "END") {
+      std::cerr << "Warning: skipping malformed trace" << std::endl;
+    }
+  }
+  return traces;
+}
+
+// Wall clock at boot; a cold boot only learns it from the NTP sync
+static time_t bootEpoch(const WakeTrace &trace) {
+  if (trace.header.epoch != 0) {
+    return trace.header.epoch;
+  }
+  for (uint8_t i = 0; i < trace.header.count; i++) {
+    const TraceEvent &e = trace.events[i];
+    if (e.type == TRACE_TIME_SYNC && e.a) {
+      return e.b - e.ms / 1000;
+    }
+  }
+  return 0;
+}
+
+static uint32_t awakeMs(const WakeTrace &trace) {
+  return trace.header.count ? trace.events[trace.header.count - 1].ms : 0;
+}
+
+static std::string localTime(time_t t) {
+  struct tm tm;
+  localtime_r(&t, &tm);
+  char buf[32];
+  strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+  return buf;
+}
+
+static long secondOfDay(time_t t) {
+  struct tm tm;
+  localtime_r(&t, &tm);
+  return tm.tm_hour * 3600L + tm.tm_min * 60 + tm.tm_sec;
+}
+
+static void dumpTrace(const WakeTrace &trace) {
+  std::printf("wake %s cause=%u events=%u\n",
+              localTime(bootEpoch(trace)).c_str(), trace.header.wakeCause,
+              trace.header.count);
+  for (uint8_t i = 0; i < trace.header.count; i++) {
+    const TraceEvent &e = trace.events[i];
+    std::printf("  %7u ms %-9s a=%d b=%u\n", e.ms, eventName(e.type), e.a,
+                e.b);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  std::string tracePath;
+  std::string payloadPath;
+  std::string tz = DEFAULT_TZ;
+  std::string dataWake = DEFAULT_DATA_WAKE;
+  bool highlightWakes = true;
+  bool dump = false;
+  bool quiet = false;
+  int days = 0;
+  std::vector<std::string> outageSpecs;
+  double flaky = 0;
+  unsigned seed = 1;
+  int errorsAfter = DEFAULT_FAILURES_BEFORE_ERROR;
+  bool retry = true;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--trace" && i + 1 < argc) {
+      tracePath = argv[++i];
+    } else if (arg == "--tz" && i + 1 < argc) {
+      tz = argv[++i];
+    } else if (arg == "--data-wake" && i + 1 < argc) {
+      dataWake = argv[++i];
+    } else if (arg == "--days" && i + 1 < argc) {
+      days = std::atoi(argv[++i]);
+    } else if (arg == "--no-highlight") {
+      highlightWakes = false;
+    } else if (arg == "--dump") {
+      dump = true;
+    } else if (arg == "--quiet") {
+      quiet = true;
+    } else if (arg == "--outage" && i + 1 < argc) {
+      outageSpecs.push_back(argv[++i]);
+    } else if (arg == "--flaky" && i + 1 < argc) {
+      flaky = std::atof(argv[++i]);
+    } else if (arg == "--seed" && i + 1 < argc) {
+      seed = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--errors-after" && i + 1 < argc) {
+      errorsAfter = std::atoi(argv[++i]);
+    } else if (arg == "--no-retry") {
+      retry = false;
+    } else {
+      payloadPath = arg;
+    }
+  }
+  int dataWakeMinute = parseClock(dataWake.c_str());
+  if (payloadPath.empty() || dataWakeMinute < 0) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--trace serial.log] [--dump] [--days N] [--tz TZ]"
+                 " [--data-wake HH:MM] [--no-highlight] [--quiet]"
+                 " [--outage D/HH:MM/MIN]... [--flaky P] [--seed N]"
+                 " [--errors-after N] [--no-retry] payload.json"
+              << std::endl;
+    return 1;
+  }
+  setenv("TZ", tz.c_str(), 1);
+  tzset();
+
+  std::ifstream in(payloadPath);
+  json doc;
+  try {
+    doc = json::parse(in);
+  } catch (json::parse_error &e) {
+    std::cerr << "Error: " << payloadPath << ": " << e.what() << std::endl;
+    return 1;
+  }
+  RenderModel base = modelFromPayload(doc);
+
+  // 1. What the device recorded
+  std::vector<WakeTrace> traces;
+  if (!tracePath.empty()) {
+    traces = loadTraces(tracePath);
+  }
+  std::vector<FetchOutcome> network;
+  WakeSummary recorded;
+  uint32_t highlightAwake = 0;
+  int highlightWakesSeen = 0;
+  time_t first = 0;
+  time_t last = 0;
+  for (const WakeTrace &trace : traces) {
+    if (dump) {
+      dumpTrace(trace);
+    }
+    time_t at = bootEpoch(trace);
+    if (at == 0) {
+      continue; // no wall clock, can't place it
+    }
+    first = first ? std::min(first, at) : at;
+    last = std::max(last, at);
+    recorded.wakes++;
+    recorded.awakeSeconds += awakeMs(trace) / 1000.0;
+
+    FetchOutcome outcome = {at, false, 0, 0, false, awakeMs(trace)};
+    bool fetched = false;
+    for (uint8_t i = 0; i < trace.header.count; i++) {
+      const TraceEvent &e = trace.events[i];
+      switch (e.type) {
+      case TRACE_WIFI_OK:
+        outcome.wifiOk = true;
+        outcome.assocMs = e.b;
+        fetched = true;
+        break;
+      case TRACE_WIFI_FAIL:
+        outcome.assocMs += e.b;
+        fetched = true;
+        break;
+      case TRACE_HTTP:
+        outcome.httpCode = e.a;
+        break;
+      case TRACE_PARSE:
+        outcome.parsed = e.a != 0;
+        break;
+      case TRACE_REFRESH:
+        recorded.refreshes += e.a != 0;
+        break;
+      }
+    }
+    if (fetched) {
+      recorded.fetches++;
+      recorded.failures += !outcome.ok();
+      network.push_back(outcome);
+    } else {
+      highlightAwake += outcome.awakeMs;
+      highlightWakesSeen++;
+    }
+  }
+  std::sort(network.begin(), network.end(),
+            [](const FetchOutcome &a, const FetchOutcome &b) {
+              return a.at < b.at;
+            });
+  if (traces.empty()) {
+    // A day from a fixed, DST-free date so runs are reproducible
+    struct tm start = {};
+    start.tm_year = 2026 - 1900;
+    start.tm_mon = 0;
+    start.tm_mday = 15;
+    start.tm_hour = dataWakeMinute / 60;
+    start.tm_min = dataWakeMinute % 60;
+    start.tm_isdst = -1;
+    first = last = mktime(&start);
+  } else if (first == 0) {
+    std::cerr << "Error: no trace has a wall clock" << std::endl;
+    return 1;
+  }
+  time_t end = days > 0 ? first + days * 86400L : last + 1;
+  uint32_t highlightMs = highlightWakesSeen
+                             ? highlightAwake / highlightWakesSeen
+                             : HIGHLIGHT_AWAKE_MS;
+
+  std::vector<Outage> outages;
+  for (const std::string &spec : outageSpecs) {
+    int day, hh, mm, minutes;
+    if (sscanf(spec.c_str(), "%d/%d:%d/%d", &day, &hh, &mm, &minutes) != 4) {
+      std::cerr << "Error: --outage wants D/HH:MM/MIN, not " << spec
+                << std::endl;
+      return 1;
+    }
+    struct tm from;
+    localtime_r(&first, &from);
+    from.tm_mday += day;
+    from.tm_hour = hh;
+    from.tm_min = mm;
+    from.tm_sec = 0;
+    from.tm_isdst = -1;
+    time_t at = mktime(&from);
+    outages.push_back({at, at + minutes * 60L});
+  }
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<> uniform(0, 1);
+
+  // 2. The current firmware logic on the same nights
+  WakeSummary simulated;
+  bool nextWakeFetches = true;
+  bool haveShownModel = false;
+  RenderModel shownModel = {};
+  size_t envIndex = 0;
+  int failures = 0;
+  time_t retryAt = 0;
+  time_t errorSince = 0;
+  time_t overdueSince = 0;
+  for (time_t t = first; t < end;) {
+    bool timerWake = t != first;
+    const char *kind;
+    const char *result;
+    bool refresh = false;
+    uint32_t awake;
+    char detail[64] = "";
+
+    if (timerWake && !nextWakeFetches && haveShownModel) {
+      kind = "highlight";
+      RenderModel model = shownModel;
+      model.highlight = nextPrayerIndex(model, secondOfDay(t) / 60);
+      refresh = changedWidgets(shownModel, model) != 0;
+      shownModel = model;
+      result = "ok";
+      awake = highlightMs;
+      if (highlightWakesSeen == 0 && refresh) {
+        awake += REFRESH_MS;
+      }
+    } else {
+      kind = failures ? "retry" : "fetch";
+      simulated.fetches++;
+      while (envIndex + 1 < network.size() && network[envIndex + 1].at <= t) {
+        envIndex++;
+      }
+      FetchOutcome outcome = {t, true, 0, 200, true, FETCH_AWAKE_MS};
+      if (!network.empty()) {
+        outcome = network[envIndex];
+      }
+      bool injected = flaky > 0 && uniform(rng) < flaky;
+      for (const Outage &o : outages) {
+        injected |= t >= o.from && t < o.to;
+      }
+      if (injected) {
+        outcome = {t, true, 0, 0, false, FAILED_AWAKE_MS};
+      }
+      snprintf(detail, sizeof(detail), "wifi %s %ums http %d",
+               outcome.wifiOk ? "ok" : "fail", outcome.assocMs,
+               outcome.httpCode);
+      awake = outcome.awakeMs;
+      if (outcome.ok()) {
+        RenderModel model = base;
+        model.highlight = nextPrayerIndex(model, secondOfDay(t) / 60);
+        refresh = !haveShownModel || changedWidgets(shownModel, model) != 0;
+        shownModel = model;
+        haveShownModel = true;
+        result = "ok";
+        failures = 0;
+        if (errorSince) {
+          simulated.errorSeconds += t - errorSince;
+          errorSince = 0;
+        }
+        if (overdueSince) {
+          simulated.overdueSeconds += t - overdueSince;
+          overdueSince = 0;
+        }
+      } else {
+        // As handleFetchFailure(): keep the panel until too many in a row,
+        // then draw the error screen once
+        simulated.failures++;
+        failures = std::min(failures + 1, 255);
+        overdueSince = overdueSince ? overdueSince : t;
+        result = "FAILED";
+        if (retry) {
+          retryAt = t + outcome.awakeMs / 1000 + retryDelay(failures, rng());
+        }
+        FailureAction action =
+            failureAction(failures, retry && haveShownModel, errorSince != 0,
+                          errorsAfter);
+        if (action != FAILURE_KEEP_FRAME) {
+          refresh = action == FAILURE_SHOW_ERROR;
+          simulated.errorScreens += refresh;
+          errorSince = errorSince ? errorSince : t;
+          haveShownModel = false;
+          result = "ERROR";
+        }
+      }
+      if (network.empty() && refresh) {
+        awake += REFRESH_MS;
+      }
+    }
+    simulated.wakes++;
+    simulated.refreshes += refresh;
+    simulated.awakeSeconds += awake / 1000.0;
+
+    time_t asleep = t + awake / 1000;
+    long dataWakeSecond = dataWakeMinute * 60L;
+    if (retry && failures > 0) {
+      // As calculateWakePlan(): the retry replaces the data wake
+      long retryIn = std::max<long>(retryAt - asleep, 1);
+      dataWakeSecond = (secondOfDay(asleep) + retryIn) % 86400;
+    }
+    WakePlan plan =
+        planNextWake(shownModel, secondOfDay(asleep), dataWakeSecond,
+                     highlightWakes && haveShownModel);
+    nextWakeFetches = plan.fetch;
+    if (!quiet) {
+      std::printf("%s %-9s %-6s %-28s %-7s awake %5.1fs sleep %6lds -> %s\n",
+                  localTime(t).c_str(), kind, result, detail,
+                  refresh ? "refresh" : "-", awake / 1000.0, plan.sleepSeconds,
+                  plan.fetch ? "fetch" : "highlight");
+    }
+    t = asleep + plan.sleepSeconds;
+  }
+  if (errorSince) {
+    simulated.errorSeconds += end - errorSince;
+  }
+  if (overdueSince) {
+    simulated.overdueSeconds += end - overdueSince;
+  }
+
+  auto print = [](const char *name, const WakeSummary &s) {
+    std::printf("%s wakes=%d fetches=%d failed=%d refreshes=%d "
+                "awake_s=%.1f\n",
+                name, s.wakes, s.fetches, s.failures, s.refreshes,
+                s.awakeSeconds);
+  };
+  if (!traces.empty()) {
+    print("recorded", recorded);
+  }
+  print("simulated", simulated);
+  std::printf("simulated error_screens=%d error_s=%.0f overdue_s=%.0f\n",
+              simulated.errorScreens, simulated.errorSeconds,
+              simulated.overdueSeconds);
+  return 0;
+}